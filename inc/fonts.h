@@ -13,6 +13,29 @@ typedef struct {
     const uint16_t *data;
 } FontDef;
 
+// Proportional font glyph. Bitmap pixels are stored in raster order as RLE
+// tokens: each byte is (alpha << (8 - bpp)) | (run length - 1), and runs
+// continue across rows. The bitmap sits inside the advance x height cell.
+typedef struct {
+    uint32_t offset;    // First token in PropFontDef.data
+    uint8_t width;      // Bitmap width
+    uint8_t height;     // Bitmap height
+    uint8_t advance;    // Cell width / pen advance
+    uint8_t x_offset;   // Bitmap left inside the cell
+    uint8_t y_offset;   // Bitmap top inside the cell
+} GlyphDef;
+
+// Proportional, optionally anti-aliased font (generate with tools/fontgen.py)
+typedef struct {
+    uint8_t height;     // Line height (cell height)
+    uint8_t baseline;   // Baseline from top of cell
+    uint8_t bpp;        // Alpha bits per pixel: 1, 2 or 4
+    uint8_t first;      // First character code
+    uint8_t last;       // Last character code
+    const GlyphDef *glyphs;
+    const uint8_t *data;
+} PropFontDef;
+
 //Font lib.
 extern FontDef Font_7x10;
 extern FontDef Font_11x18;
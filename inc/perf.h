@@ -0,0 +1,89 @@
+/**
+ * @file perf.h
+ */
+
+#ifndef __PERF_H
+#define __PERF_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include "main.h"
+
+/* ============== TYPES ============== */
+
+// Running min / max / mean of a measurement
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} PERF_Stat;
+
+/* ============== PUBLIC API ============== */
+
+/**
+ * @brief Start the DWT cycle counter (Cortex-M3 and up).
+ */
+static inline void PERF_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Read the cycle counter (wraps every 2^32 cycles, ~60 s at 72 MHz).
+ * @return Core clock cycles.
+ */
+static inline uint32_t PERF_Cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Convert a cycle count to microseconds.
+ * @param cycles Core clock cycles.
+ * @return Microseconds.
+ */
+static inline uint32_t PERF_CyclesToUs(uint32_t cycles)
+{
+    return cycles / (SystemCoreClock / 1000000);
+}
+
+/**
+ * @brief Clear a statistic.
+ * @param stat Statistic.
+ */
+static inline void PERF_StatReset(PERF_Stat *stat)
+{
+    stat->count = 0;
+    stat->min = UINT32_MAX;
+    stat->max = 0;
+    stat->sum = 0;
+}
+
+/**
+ * @brief Add a measurement.
+ * @param stat Statistic.
+ * @param value Measurement (usually cycles).
+ */
+static inline void PERF_StatAdd(PERF_Stat *stat, uint32_t value)
+{
+    stat->count++;
+    stat->sum += value;
+    if (value < stat->min) stat->min = value;
+    if (value > stat->max) stat->max = value;
+}
+
+/**
+ * @brief Mean of the measurements.
+ * @param stat Statistic.
+ * @return Mean, 0 if empty.
+ */
+static inline uint32_t PERF_StatMean(const PERF_Stat *stat)
+{
+    return stat->count ? (uint32_t)(stat->sum / stat->count) : 0;
+}
+
+#endif // __PERF_H
@@ -0,0 +1,107 @@
+/**
+ * @file spi_bus.h
+ */
+
+#ifndef __SPI_BUS_H
+#define __SPI_BUS_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"
+
+/* ============== TYPES ============== */
+
+typedef struct SPI_BusDevice SPI_BusDevice;
+
+/**
+ * @brief Grant callback type: the device now owns the bus (may run in interrupt context).
+ */
+typedef void (*SPI_BusGrant)(SPI_BusDevice *dev);
+
+// Shared SPI peripheral
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    SPI_BusDevice * volatile owner;   // NULL = free
+    SPI_BusDevice *head;              // Waiting devices, oldest first
+    SPI_BusDevice *tail;
+} SPI_Bus;
+
+// One chip on a shared bus
+struct SPI_BusDevice {
+    SPI_Bus *bus;
+    uint32_t prescaler;               // SPI_BAUDRATEPRESCALER_x used while owning the bus
+    SPI_BusGrant grant;               // Called when a SPI_BusRequest is granted (may be NULL)
+    void *context;                    // Free for the owner of the device
+    SPI_BusDevice *next;              // Wait queue link
+    bool notify;                      // Queued by SPI_BusRequest: call grant on hand-over
+};
+
+/* ============== PUBLIC API ============== */
+
+/**
+ * @brief Set up an arbiter for a SPI peripheral shared by several drivers.
+ * @param bus Bus to initialize.
+ * @param hspi SPI handle.
+ */
+void SPI_BusInit(SPI_Bus *bus, SPI_HandleTypeDef *hspi);
+
+/**
+ * @brief Register a device on a bus.
+ * @param dev Device to initialize.
+ * @param bus Bus the device is wired to.
+ * @param prescaler SPI_BAUDRATEPRESCALER_x to switch to whenever the device takes the bus.
+ * @param grant Callback for SPI_BusRequest, or NULL.
+ * @param context Stored in dev->context.
+ */
+void SPI_BusAddDevice(SPI_BusDevice *dev, SPI_Bus *bus, uint32_t prescaler,
+                      SPI_BusGrant grant, void *context);
+
+/**
+ * @brief Take the bus if it is free.
+ * @param dev Device.
+ * @return true if the device owns the bus.
+ */
+bool SPI_BusTryAcquire(SPI_BusDevice *dev);
+
+/**
+ * @brief Take the bus, waiting behind earlier requests.
+ * The current owner hands over when it releases or yields (the display
+ * yields between DMA chunks). Do not call from an interrupt: a blocked
+ * owner could never release; use SPI_BusRequest there.
+ * @param dev Device.
+ */
+void SPI_BusAcquire(SPI_BusDevice *dev);
+
+/**
+ * @brief Ask for the bus without waiting.
+ * If the bus is free the grant callback runs right away in the caller's
+ * context, otherwise from the context that hands the bus over.
+ * @param dev Device.
+ */
+void SPI_BusRequest(SPI_BusDevice *dev);
+
+/**
+ * @brief Check if other devices are waiting for the bus.
+ * @param dev Device (owner).
+ * @return true if a yield would hand the bus over.
+ */
+bool SPI_BusIsContended(const SPI_BusDevice *dev);
+
+/**
+ * @brief Hand the bus to the oldest waiting device and queue behind it.
+ * The device gets its grant callback once the bus comes back.
+ * Release any chip select before calling.
+ * @param dev Device (owner).
+ * @return true if the bus was handed over.
+ */
+bool SPI_BusYield(SPI_BusDevice *dev);
+
+/**
+ * @brief Give up the bus, handing it to the oldest waiting device.
+ * @param dev Device (owner).
+ */
+void SPI_BusRelease(SPI_BusDevice *dev);
+
+#endif // __SPI_BUS_H
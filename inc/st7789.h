@@ -21,7 +21,39 @@ extern SPI_HandleTypeDef ST7789_SPI_PORT;
 //#define ST7789_USE_DMA
 #ifdef ST7789_USE_DMA
     #define ST7789_DMA_MIN_SIZE 16         // Min bytes to use DMA
-    #define ST7789_DMA_BUFFER_LINES 5      // Buffer size (lines)
+    #define ST7789_DMA_BUFFER_LINES 5      // Lines per ping-pong buffer (2 buffers)
+    #define ST7789_DMA_QUEUE_SIZE 8        // Queued transfers per panel (power of 2)
+    #define ST7789_MAX_PANELS 2            // Panel handles, default one included (ST7789_InitHandle fails beyond)
+//  #define ST7789_USER_SPI_CALLBACK       // Uncomment if HAL_SPI_TxCpltCallback is defined elsewhere
+#endif
+
+// Shared SPI bus (uncomment when other drivers use the same SPI, see spi_bus.h)
+// Every transfer takes the bus through the arbiter; DMA bursts yield to
+// waiting devices between chunks. Attach with ST7789_AttachBus().
+//#define ST7789_USE_SPI_BUS
+#ifdef ST7789_USE_SPI_BUS
+    #include "spi_bus.h"
+    #define ST7789_BUS_CHUNK 4096          // Max DMA chunk (bytes, even): longest other devices wait
+#endif
+
+// 16-bit SPI frames for native-order images (uncomment to enable, F1/F2/F4: SPI with CR1.DFF)
+// ST7789_ORDER_NATIVE pixels then go out as-is instead of being byte-swapped
+// by the CPU. Not with ST7789_USE_SPI_BUS: other devices expect 8-bit frames.
+//#define ST7789_USE_SPI_16BIT
+
+// Framebuffer (comment to draw straight to the panel)
+// Primitives render into RAM and ST7789_Flush() sends only dirty areas.
+//#define ST7789_USE_FRAMEBUFFER
+#ifdef ST7789_USE_FRAMEBUFFER
+    #define ST7789_FB_LINES ST7789_MAX_HEIGHT  // Lines in RAM (< HEIGHT = banded, e.g. 40 on F1)
+    #define ST7789_FB_MAX_DIRTY 8          // Dirty rectangles tracked before merging
+#endif
+
+// Power Manager (idle mode / lower frame rate while the screen is static)
+// Call ST7789_PowerTask() from the main loop; any drawing wakes the panel.
+//#define ST7789_USE_POWER_MANAGER
+#ifdef ST7789_USE_POWER_MANAGER
+    #define ST7789_IDLE_TIMEOUT_MS 5000    // Static time before idling (default, see ST7789_PowerConfig)
 #endif
 
 // Font Support (comment to disable and save memory)
@@ -30,18 +62,67 @@ extern SPI_HandleTypeDef ST7789_SPI_PORT;
     #include "fonts.h"
 #endif
 
+// Glyph Cache (keeps recently drawn glyphs expanded to RGB565, LRU eviction)
+//#define ST7789_USE_GLYPH_CACHE
+#ifdef ST7789_USE_GLYPH_CACHE
+    #define ST7789_GLYPH_CACHE_SIZE    4096  // RAM budget for expanded glyphs (bytes)
+    #define ST7789_GLYPH_CACHE_ENTRIES 32    // Max glyphs held at once (< 255)
+#endif
+
+// Display List (deferred drawing, needs ST7789_USE_DMA, not with ST7789_USE_FRAMEBUFFER)
+// ST7789_DList* calls only record; ST7789_DListSubmit() rasterizes the list
+// band by band into the DMA line buffers and streams it.
+//#define ST7789_USE_DLIST
+#ifdef ST7789_USE_DLIST
+    #define ST7789_DLIST_ARENA_SIZE  2048    // Command storage (bytes)
+    #define ST7789_DLIST_MAX_COMMANDS 64     // Commands per list (< 256)
+#endif
+
+// Bus statistics (uncomment to enable, uses the DWT cycle counter)
+// Counts commands, windows and data transfers, and the time the CPU spends
+// blocked on the bus versus DMA running behind it. Read with ST7789_GetStats().
+//#define ST7789_USE_STATS
+#ifdef ST7789_USE_STATS
+    #include "perf.h"
+#endif
+
+// Event trace (uncomment to log commands, windows and DMA bursts with cycle
+// timestamps into the trace.h ring; print it over SWO with TRACE_Dump())
+//#define ST7789_USE_TRACE
+#ifdef ST7789_USE_TRACE
+    #include "trace.h"
+#endif
+
+// GRAM readback (uncomment to enable; needs the panel's SDO wired to MISO,
+// which many modules leave unconnected, and a full-duplex SPI)
+//#define ST7789_USE_READBACK
+#ifdef ST7789_USE_READBACK
+    #define ST7789_READ_PRESCALER SPI_BAUDRATEPRESCALER_16  // Read clock (panel: 150 ns min cycle, <= 6.6 MHz)
+    #define ST7789_RAMRD_DUMMY_BITS 8      // Dummy clocks between RAMRD and the pixel data
+#endif
+
 // Display Type (uncomment ONE only)
 //#define ST7789_135x240    // 0.96 inch
 //#define ST7789_240x240    // 1.3 inch
 #define ST7789_240x320      // 2.8 inch
 //#define ST7789_170x320    // 1.9 inch
 
-// Display Rotation (0-3)
+// Display Rotation (0-3, initial rotation when ST7789_RUNTIME_ROTATION is set)
 //#define ST7789_ROTATION 0    // 0=Portrait
 //#define ST7789_ROTATION 1    // 1=Landscape
 //#define ST7789_ROTATION 2    // 2=Portrait180
 #define ST7789_ROTATION 3    // 3=Landscape180
 
+// Runtime Rotation (ST7789_SetRotation may switch between portrait and landscape;
+// geometry then lives in st7789_display instead of compile-time constants)
+//#define ST7789_RUNTIME_ROTATION
+
+// Reset recovery before the first command (ms, datasheet tRT): 120 covers a
+// panel that was awake (MCU reset alone), 5 is enough if the panel is always
+// powered up together with the MCU. Sleep Out still waits until 120 ms after
+// reset; with 5 the configuration registers are written during that time.
+#define ST7789_RESET_MS 120
+
 // CS Control (comment if CS tied to GND)
 #define ST7789_USE_CS
 
@@ -57,72 +138,106 @@ extern SPI_HandleTypeDef ST7789_SPI_PORT;
 
 /* ============== DISPLAY PARAMETERS ============== */
 
+// Panel size in rotation 0 and the X/Y offset of the visible area for each rotation
+
 // 135x240 (0.96 inch)
 #ifdef ST7789_135x240
-    #if ST7789_ROTATION == 0 || ST7789_ROTATION == 2
-        #define ST7789_WIDTH  135
-        #define ST7789_HEIGHT 240
-    #else
-        #define ST7789_WIDTH  240
-        #define ST7789_HEIGHT 135
-    #endif
-    #if ST7789_ROTATION == 0
-        #define ST7789_X_SHIFT 53
-        #define ST7789_Y_SHIFT 40
-    #elif ST7789_ROTATION == 1
-        #define ST7789_X_SHIFT 40
-        #define ST7789_Y_SHIFT 52
-    #elif ST7789_ROTATION == 2
-        #define ST7789_X_SHIFT 52
-        #define ST7789_Y_SHIFT 40
-    #else
-        #define ST7789_X_SHIFT 40
-        #define ST7789_Y_SHIFT 53
-    #endif
+    #define ST7789_PANEL_WIDTH  135
+    #define ST7789_PANEL_HEIGHT 240
+    #define ST7789_R0_X_SHIFT   53
+    #define ST7789_R0_Y_SHIFT   40
+    #define ST7789_R1_X_SHIFT   40
+    #define ST7789_R1_Y_SHIFT   52
+    #define ST7789_R2_X_SHIFT   52
+    #define ST7789_R2_Y_SHIFT   40
+    #define ST7789_R3_X_SHIFT   40
+    #define ST7789_R3_Y_SHIFT   53
 #endif
 
 // 240x240 (1.3 inch)
 #ifdef ST7789_240x240
-    #define ST7789_WIDTH  240
-    #define ST7789_HEIGHT 240
-    #if ST7789_ROTATION == 0
-        #define ST7789_X_SHIFT 0
-        #define ST7789_Y_SHIFT 80
-    #elif ST7789_ROTATION == 1
-        #define ST7789_X_SHIFT 80
-        #define ST7789_Y_SHIFT 0
-    #else
-        #define ST7789_X_SHIFT 0
-        #define ST7789_Y_SHIFT 0
-    #endif
+    #define ST7789_PANEL_WIDTH  240
+    #define ST7789_PANEL_HEIGHT 240
+    #define ST7789_R0_X_SHIFT   0
+    #define ST7789_R0_Y_SHIFT   80
+    #define ST7789_R1_X_SHIFT   80
+    #define ST7789_R1_Y_SHIFT   0
+    #define ST7789_R2_X_SHIFT   0
+    #define ST7789_R2_Y_SHIFT   0
+    #define ST7789_R3_X_SHIFT   0
+    #define ST7789_R3_Y_SHIFT   0
 #endif
 
 // 240x320 (2.8 inch)
 #ifdef ST7789_240x320
-    #if ST7789_ROTATION == 0 || ST7789_ROTATION == 2
-        #define ST7789_WIDTH  240
-        #define ST7789_HEIGHT 320
-    #else
-        #define ST7789_WIDTH  320
-        #define ST7789_HEIGHT 240
-    #endif
-    #define ST7789_X_SHIFT 0
-    #define ST7789_Y_SHIFT 0
+    #define ST7789_PANEL_WIDTH  240
+    #define ST7789_PANEL_HEIGHT 320
+    #define ST7789_R0_X_SHIFT   0
+    #define ST7789_R0_Y_SHIFT   0
+    #define ST7789_R1_X_SHIFT   0
+    #define ST7789_R1_Y_SHIFT   0
+    #define ST7789_R2_X_SHIFT   0
+    #define ST7789_R2_Y_SHIFT   0
+    #define ST7789_R3_X_SHIFT   0
+    #define ST7789_R3_Y_SHIFT   0
 #endif
 
 // 170x320 (1.9 inch)
 #ifdef ST7789_170x320
-    #if ST7789_ROTATION == 0 || ST7789_ROTATION == 2
-        #define ST7789_WIDTH  170
-        #define ST7789_HEIGHT 320
-        #define ST7789_X_SHIFT 35
-        #define ST7789_Y_SHIFT 0
+    #define ST7789_PANEL_WIDTH  170
+    #define ST7789_PANEL_HEIGHT 320
+    #define ST7789_R0_X_SHIFT   35
+    #define ST7789_R0_Y_SHIFT   0
+    #define ST7789_R1_X_SHIFT   0
+    #define ST7789_R1_Y_SHIFT   35
+    #define ST7789_R2_X_SHIFT   35
+    #define ST7789_R2_Y_SHIFT   0
+    #define ST7789_R3_X_SHIFT   0
+    #define ST7789_R3_Y_SHIFT   35
+#endif
+
+// Geometry of ST7789_ROTATION (applied by ST7789_Init)
+#if ST7789_ROTATION == 0 || ST7789_ROTATION == 2
+    #define ST7789_DEFAULT_WIDTH  ST7789_PANEL_WIDTH
+    #define ST7789_DEFAULT_HEIGHT ST7789_PANEL_HEIGHT
+#else
+    #define ST7789_DEFAULT_WIDTH  ST7789_PANEL_HEIGHT
+    #define ST7789_DEFAULT_HEIGHT ST7789_PANEL_WIDTH
+#endif
+
+#if ST7789_ROTATION == 0
+    #define ST7789_DEFAULT_X_SHIFT ST7789_R0_X_SHIFT
+    #define ST7789_DEFAULT_Y_SHIFT ST7789_R0_Y_SHIFT
+#elif ST7789_ROTATION == 1
+    #define ST7789_DEFAULT_X_SHIFT ST7789_R1_X_SHIFT
+    #define ST7789_DEFAULT_Y_SHIFT ST7789_R1_Y_SHIFT
+#elif ST7789_ROTATION == 2
+    #define ST7789_DEFAULT_X_SHIFT ST7789_R2_X_SHIFT
+    #define ST7789_DEFAULT_Y_SHIFT ST7789_R2_Y_SHIFT
+#else
+    #define ST7789_DEFAULT_X_SHIFT ST7789_R3_X_SHIFT
+    #define ST7789_DEFAULT_Y_SHIFT ST7789_R3_Y_SHIFT
+#endif
+
+// Current geometry: constants unless ST7789_RUNTIME_ROTATION, so bounds checks fold away
+#ifdef ST7789_RUNTIME_ROTATION
+    #define ST7789_WIDTH      (st7789_display.width)
+    #define ST7789_HEIGHT     (st7789_display.height)
+    #define ST7789_X_SHIFT    (st7789_display.x_shift)
+    #define ST7789_Y_SHIFT    (st7789_display.y_shift)
+    #if ST7789_PANEL_WIDTH > ST7789_PANEL_HEIGHT
+        #define ST7789_MAX_WIDTH  ST7789_PANEL_WIDTH
     #else
-        #define ST7789_WIDTH  320
-        #define ST7789_HEIGHT 170
-        #define ST7789_X_SHIFT 0
-        #define ST7789_Y_SHIFT 35
+        #define ST7789_MAX_WIDTH  ST7789_PANEL_HEIGHT
     #endif
+    #define ST7789_MAX_HEIGHT ST7789_MAX_WIDTH
+#else
+    #define ST7789_WIDTH      ST7789_DEFAULT_WIDTH
+    #define ST7789_HEIGHT     ST7789_DEFAULT_HEIGHT
+    #define ST7789_X_SHIFT    ST7789_DEFAULT_X_SHIFT
+    #define ST7789_Y_SHIFT    ST7789_DEFAULT_Y_SHIFT
+    #define ST7789_MAX_WIDTH  ST7789_DEFAULT_WIDTH     // Largest width over the usable rotations
+    #define ST7789_MAX_HEIGHT ST7789_DEFAULT_HEIGHT
 #endif
 
 /* ============== COLOR DEFINITIONS (RGB565) ============== */
@@ -146,19 +261,211 @@ extern SPI_HandleTypeDef ST7789_SPI_PORT;
 
 /* ============== PUBLIC API ============== */
 
+// Byte order of image data in memory
+typedef enum {
+    ST7789_ORDER_SPI,       // High byte first, as sent (pre-swapped arrays, e.g. testimg.h)
+    ST7789_ORDER_NATIVE     // Plain uint16_t RGB565 values (CPU byte order)
+} ST7789_PixelOrder;
+
+/**
+ * @brief Image source callback type for ST7789_BlitStream.
+ * @param dst Buffer for the next pixels (row-major).
+ * @param max Pixels that fit in dst.
+ * @param context Pointer given to ST7789_BlitStream.
+ * @return Pixels written (0 = no more data).
+ */
+typedef uint32_t (*ST7789_BlitSource)(uint16_t *dst, uint32_t max, void *context);
+
+// Image formats for ST7789_Image.flags
+#define ST7789_IMAGE_RLE    0x01    // Run-length encoded
+
+/**
+ * @brief Compressed image (generate with tools/imgconv.py).
+ * bpp 16: data holds RGB565 colors, high byte first.
+ * bpp 1/2/4/8: data holds palette indices, packed MSB first, each row
+ * starting on a byte boundary.
+ * RLE, bpp 16 and 8: a token byte n, then (n & 0x7F) + 1 pixels: one value
+ * repeated if bit 7 is set, otherwise that many literal values.
+ * RLE, bpp 1/2/4: one byte per run, (index << (8 - bpp)) | (length - 1).
+ * RLE runs continue across rows.
+ */
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t bpp;                // 16 = RGB565, 1/2/4/8 = palette indices
+    uint8_t flags;              // ST7789_IMAGE_*
+    uint16_t colors;            // Palette entries
+    const uint16_t *palette;    // RGB565, ST7789_ORDER_SPI (NULL for bpp 16)
+    const uint8_t *data;
+} ST7789_Image;
+
+// Display context (current rotation and geometry, updated by ST7789_SetRotation)
+typedef struct {
+    uint16_t width;     // Visible width in pixels
+    uint16_t height;    // Visible height in pixels
+    uint16_t x_shift;   // Column offset of the visible area in frame memory
+    uint16_t y_shift;   // Row offset of the visible area in frame memory
+    uint8_t rotation;   // 0-3
+} ST7789_Display;
+
+#ifdef ST7789_USE_DMA
+// Queued background transfer
+typedef struct {
+    const uint8_t *data;
+    uint32_t len;
+    uint8_t buffer;    // Line buffer index (0xFF = caller's data)
+} ST7789_Transfer;
+
+/**
+ * @brief Transfer complete callback type (runs in DMA interrupt context).
+ */
+typedef void (*ST7789_DoneCallback)(void);
+#endif
+
+/**
+ * @brief First frame callback type: draws with the normal API (see ST7789_SetSplash).
+ */
+typedef void (*ST7789_SplashCallback)(void);
+
+// Panel handle: bus, pins and per-panel state (set up with ST7789_InitHandle)
+typedef struct {
+    SPI_HandleTypeDef *spi;
+    GPIO_TypeDef *cs_port;
+    uint16_t cs_pin;
+    GPIO_TypeDef *dc_port;
+    uint16_t dc_pin;
+    GPIO_TypeDef *rst_port;       // NULL: no hardware reset (e.g. RST shared)
+    uint16_t rst_pin;
+
+    // Driver state, do not touch
+    ST7789_Display display;
+    struct {
+        uint16_t x0;
+        uint16_t x1;
+        uint16_t y0;
+        uint16_t y1;
+        bool valid;
+    } window;                     // Last address window sent (shift applied)
+    struct {
+        uint16_t tfa;
+        uint16_t height;
+    } scroll;                     // Scroll area in frame memory rows (0 = none)
+    uint8_t frame_rtna;           // FRCTRL2 value for normal mode
+    ST7789_SplashCallback splash; // First frame drawn by ST7789_Init (NULL = black)
+#ifdef ST7789_USE_POWER_MANAGER
+    struct {
+        uint32_t timeout;         // Inactivity before idling (ms, 0 = never)
+        uint32_t last_activity;   // HAL tick of last drawing
+        bool color8;              // Use 8-color idle mode
+        uint8_t idle_rtna;        // FRCTRL2 value while idle without 8-color mode
+        bool idle;
+    } power;
+#endif
+#ifdef ST7789_USE_DMA
+    ST7789_Transfer dma_queue[ST7789_DMA_QUEUE_SIZE];
+    volatile uint8_t dma_head;    // Next free slot
+    volatile uint8_t dma_tail;    // Slot being sent
+    volatile bool dma_active;     // Burst in progress (CS held low)
+    uint16_t dma_chunk;           // Size of chunk in flight
+    ST7789_DoneCallback dma_done_cb;
+#endif
+#ifdef ST7789_USE_SPI_BUS
+    SPI_BusDevice bus_dev;        // Arbiter entry (bus NULL = SPI not shared)
+#endif
+#ifdef ST7789_USE_SPI_16BIT
+    bool spi_wide;                // SPI in 16-bit frames (only during a blit)
+#endif
+#if defined(ST7789_USE_STATS) && defined(ST7789_USE_DMA)
+    uint32_t dma_start;           // Cycle count when the running burst took the bus
+#endif
+} st7789_t;
+
+// Panel that all drawing functions act on (see ST7789_Select)
+extern st7789_t *st7789_current;
+#define st7789_display (st7789_current->display)
+
+// Panels
+
+/**
+ * @brief Set up a handle for an additional panel. The panel built from the
+ * configuration macros above is selected by default.
+ * Afterwards: ST7789_Select(panel); ST7789_Init();
+ * @param panel Handle to initialize (must stay valid while in use).
+ * @param hspi SPI bus.
+ * @param cs_port CS GPIO port (ignored without ST7789_USE_CS).
+ * @param cs_pin CS pin.
+ * @param dc_port DC GPIO port.
+ * @param dc_pin DC pin.
+ * @param rst_port RST GPIO port, or NULL to skip the hardware reset.
+ * @param rst_pin RST pin.
+ * @return false with DMA if ST7789_MAX_PANELS handles (the default one
+ *         included) are already set up; the handle must not be used then.
+ */
+bool ST7789_InitHandle(st7789_t *panel, SPI_HandleTypeDef *hspi,
+                       GPIO_TypeDef *cs_port, uint16_t cs_pin,
+                       GPIO_TypeDef *dc_port, uint16_t dc_pin,
+                       GPIO_TypeDef *rst_port, uint16_t rst_pin);
+
+/**
+ * @brief Direct all following calls to a panel.
+ * Queued DMA of panels on other SPI buses keeps running, so panels refresh
+ * in parallel; panels sharing the bus are waited for. With the framebuffer
+ * (shared by all panels) pending dirty areas are flushed first.
+ * @param panel Panel handle.
+ */
+void ST7789_Select(st7789_t *panel);
+
+/**
+ * @brief Get the selected panel.
+ * @return Panel handle.
+ */
+st7789_t *ST7789_GetSelected(void);
+
+#ifdef ST7789_USE_SPI_BUS
+/**
+ * @brief Share the selected panel's SPI through an arbiter.
+ * @param bus Bus set up with SPI_BusInit() on the panel's SPI handle.
+ * @param prescaler SPI_BAUDRATEPRESCALER_x for the panel (usually the fastest).
+ */
+void ST7789_AttachBus(SPI_Bus *bus, uint32_t prescaler);
+#endif
+
 // Initialization & Control
 
 /*
  * @brief Initialize ST7789 display with reset, color mode (RGB565), gamma, and display on.
+ * The first frame (splash, or black) is written before the display is switched on.
  */
 void ST7789_Init(void);
 
 /**
- * @brief Set display rotation.
+ * @brief Set the first frame for the selected panel, drawn by ST7789_Init()
+ * before the display turns on, so no blank or stale screen is ever shown.
+ * In banded framebuffer mode it is called once per band (each starts black).
+ * @param callback Draws the splash (e.g. ST7789_DrawImage of a full-screen image), or NULL for black.
+ */
+void ST7789_SetSplash(ST7789_SplashCallback callback);
+
+/**
+ * @brief Set display rotation and update st7789_display.
+ * Without ST7789_RUNTIME_ROTATION the geometry (size, offsets) stays fixed
+ * to ST7789_ROTATION. Redraw the screen afterwards.
  * @param rotation 0: Portrait, 1: Landscape, 2: Portrait 180°, 3: Landscape 180°.
  */
 void ST7789_SetRotation(uint8_t rotation);
 
+/**
+ * @brief Current visible width.
+ * @return Width in pixels.
+ */
+uint16_t ST7789_GetWidth(void);
+
+/**
+ * @brief Current visible height.
+ * @return Height in pixels.
+ */
+uint16_t ST7789_GetHeight(void);
+
 /**
  * @brief Invert display colors.
  * @param invert true to invert, false for normal.
@@ -171,6 +478,212 @@ void ST7789_InvertDisplay(bool invert);
  */
 void ST7789_Sleep(bool sleep);
 
+// Scrolling
+
+/**
+ * @brief Define the hardware vertical scroll band and reset its offset.
+ * Rows outside [top, top + height) stay fixed. Drawing keeps using
+ * unscrolled screen coordinates: after ST7789_SetScrollOffset(n), band
+ * row r shows what was drawn at row top + (r - top + n) % height.
+ * @param top First screen row of the band.
+ * @param height Rows in the band.
+ * @return false if out of range or the rotation cannot scroll vertically (landscape).
+ */
+bool ST7789_SetScrollArea(uint16_t top, uint16_t height);
+
+/**
+ * @brief Set the hardware scroll position inside the band.
+ * @param offset Lines to scroll the band contents up (wraps at band height).
+ */
+void ST7789_SetScrollOffset(uint16_t offset);
+
+// Power and Refresh
+
+/**
+ * @brief Enter partial mode: only a band of lines is scanned out.
+ * Lines run along the panel's scan direction: screen rows in portrait,
+ * screen columns in landscape. Lines outside the band are not refreshed.
+ * @param start First line of the band.
+ * @param count Lines in the band.
+ */
+void ST7789_SetPartialArea(uint16_t start, uint16_t count);
+
+/**
+ * @brief Leave partial mode (also ends hardware scrolling).
+ */
+void ST7789_SetNormalMode(void);
+
+/**
+ * @brief Enter/exit idle mode (8 colors: only the MSB of each channel is shown).
+ * @param idle true for 8-color idle mode, false for full color.
+ */
+void ST7789_SetIdleMode(bool idle);
+
+/**
+ * @brief Set the normal mode frame rate (about 39-119 Hz, default 60).
+ * @param hz Requested rate.
+ * @return Rate actually set (closest not above hz, where possible).
+ */
+uint8_t ST7789_SetFrameRate(uint8_t hz);
+
+/**
+ * @brief Set the frame rate used in idle and partial modes (about 5-119 Hz).
+ * @param hz Requested rate.
+ * @return Rate actually set.
+ */
+uint8_t ST7789_SetIdleFrameRate(uint8_t hz);
+
+#ifdef ST7789_USE_POWER_MANAGER
+/**
+ * @brief Configure the power manager.
+ * @param timeout_ms Static time before idling (0 = never).
+ * @param color8 true: switch to 8-color idle mode; false: only lower the frame rate.
+ * @param idle_hz Frame rate while idle (idle mode reaches ~5 Hz, normal mode ~39 Hz).
+ */
+void ST7789_PowerConfig(uint32_t timeout_ms, bool color8, uint8_t idle_hz);
+
+/**
+ * @brief Run from the main loop: idles the panel after the configured timeout.
+ */
+void ST7789_PowerTask(void);
+
+/**
+ * @brief Check if the panel is currently idled by the power manager.
+ * @return true while idle.
+ */
+bool ST7789_PowerIsIdle(void);
+#endif
+
+// Transfer Control
+
+/**
+ * @brief Check if pixel data is still being sent to the selected panel.
+ * @return true while DMA transfers are queued or in flight (always false without DMA).
+ */
+bool ST7789_IsBusy(void);
+
+/**
+ * @brief Block until the selected panel's queued transfers have completed.
+ */
+void ST7789_WaitIdle(void);
+
+#ifdef ST7789_USE_DMA
+/**
+ * @brief Set callback invoked when the selected panel's transfer queue drains.
+ * @param callback Function to call, or NULL to disable.
+ */
+void ST7789_SetDoneCallback(ST7789_DoneCallback callback);
+
+/**
+ * @brief SPI TX complete handler. Call from HAL_SPI_TxCpltCallback when
+ * ST7789_USER_SPI_CALLBACK is defined, otherwise it is hooked automatically.
+ * @param hspi SPI handle that completed.
+ */
+void ST7789_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+#endif
+
+#ifdef ST7789_USE_FRAMEBUFFER
+// Framebuffer
+
+/**
+ * @brief Send merged dirty rectangles of the framebuffer to the panel.
+ */
+void ST7789_Flush(void);
+
+/**
+ * @brief Start a frame. Banded mode: selects the first band and fills it with bgcolor.
+ * Use as: ST7789_FirstPage(bg); do { draw... } while (ST7789_NextPage());
+ * @param bgcolor RGB565 color each band starts with (ignored with full framebuffer).
+ */
+void ST7789_FirstPage(uint16_t bgcolor);
+
+/**
+ * @brief Flush current band and move to the next one.
+ * @return true if the frame must be drawn again for the next band.
+ */
+bool ST7789_NextPage(void);
+#endif
+
+#ifdef ST7789_USE_DLIST
+// Display List
+
+/**
+ * @brief Start recording a new list, discarding the previous one.
+ * Submitting repaints the whole region: bgcolor, then the commands in order.
+ * @param x Region left edge (clipped to the screen).
+ * @param y Region top edge.
+ * @param w Region width.
+ * @param h Region height.
+ * @param bgcolor RGB565 color under the commands.
+ */
+void ST7789_DListBegin(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t bgcolor);
+
+/**
+ * @brief Record a filled rectangle.
+ * @return false if the list is full (the command is dropped).
+ */
+bool ST7789_DListFillRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t color);
+
+/**
+ * @brief Record a rectangle outline (four fills).
+ * @return false if the list is full.
+ */
+bool ST7789_DListDrawRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t color);
+
+/**
+ * @brief Record a line (same pixels as ST7789_DrawLine).
+ * @return false if the list is full.
+ */
+bool ST7789_DListDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+
+/**
+ * @brief Record a filled circle (same pixels as a full ST7789_FillArc with r_inner 0).
+ * @return false if the list is full.
+ */
+bool ST7789_DListFillCircle(int16_t x0, int16_t y0, uint16_t r, uint16_t color);
+
+/**
+ * @brief Record a 1-pixel circle (same pixels as a full ST7789_DrawArc).
+ * @return false if the list is full.
+ */
+bool ST7789_DListDrawCircle(int16_t x0, int16_t y0, uint16_t r, uint16_t color);
+
+/**
+ * @brief Record an image. The pixels are not copied: keep them valid while the list is used.
+ * @param x Left edge (may be negative).
+ * @param y Top edge (may be negative).
+ * @param w Width.
+ * @param h Height.
+ * @param data RGB565 pixels, row-major.
+ * @param order Byte order of data.
+ * @return false if the list is full.
+ */
+bool ST7789_DListDrawImage(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                           const uint16_t *data, ST7789_PixelOrder order);
+
+#ifdef ST7789_USE_FONTS
+/**
+ * @brief Record a single line of text (copied into the list, clipped, no wrapping).
+ * @param font Font (must stay valid while the list is used).
+ * @return false if the list is full.
+ */
+bool ST7789_DListWriteString(int16_t x, int16_t y, const char *str, const FontDef *font,
+                             uint16_t color, uint16_t bgcolor);
+#endif
+
+/**
+ * @brief Draw the recorded list. The list is kept and can be submitted again.
+ *
+ * Commands are sorted by the band they start in and rasterized into the
+ * line buffers one band at a time, so the next band is prepared while DMA
+ * sends the previous one. Bands that come out as one solid color (nothing
+ * drawn, or covered by a single fill) are merged into one window fill; the
+ * other bands stream through a single window.
+ * @return Address windows used.
+ */
+uint16_t ST7789_DListSubmit(void);
+#endif
+
 // Basic Drawing
 
 /**
@@ -252,6 +765,8 @@ void ST7789_DrawTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 
 /**
  * @brief Fill triangle.
+ * Uses a top-left fill rule: pixels on the right and bottom edges are left
+ * out, so triangles sharing an edge tile without gaps or overlap.
  * @param x1 Vertex 1 X.
  * @param y1 Vertex 1 Y.
  * @param x2 Vertex 2 X.
@@ -263,18 +778,146 @@ void ST7789_DrawTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 void ST7789_FillTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 						 uint16_t x3, uint16_t y3, uint16_t color);
 
+/**
+ * @brief Draw anti-aliased line (Wu algorithm), clipped to the screen.
+ * Edge pixels are blended against bgcolor (the display cannot be read back);
+ * each row or column of the line goes out as one burst.
+ * @param x0 Start X.
+ * @param y0 Start Y.
+ * @param x1 End X.
+ * @param y1 End Y.
+ * @param color RGB565 color.
+ * @param bgcolor RGB565 color underneath.
+ */
+void ST7789_DrawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                       uint16_t color, uint16_t bgcolor);
+
+/**
+ * @brief Draw line of any thickness (square ends), clipped to the screen.
+ * Add ST7789_FillCircle() at the end points for round caps.
+ * @param x0 Start X.
+ * @param y0 Start Y.
+ * @param x1 End X.
+ * @param y1 End Y.
+ * @param width Thickness in pixels (1 = ST7789_DrawLine).
+ * @param color RGB565 color.
+ */
+void ST7789_DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                          uint16_t width, uint16_t color);
+
+/**
+ * @brief Draw rounded rectangle outline.
+ * @param x Start X.
+ * @param y Start Y.
+ * @param w Width.
+ * @param h Height.
+ * @param r Corner radius (limited to half the shorter side).
+ * @param color RGB565 color.
+ */
+void ST7789_DrawRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color);
+
+/**
+ * @brief Fill rounded rectangle.
+ * @param x Start X.
+ * @param y Start Y.
+ * @param w Width.
+ * @param h Height.
+ * @param r Corner radius (limited to half the shorter side).
+ * @param color RGB565 color.
+ */
+void ST7789_FillRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color);
+
+/**
+ * @brief Fill ring segment (gauge arc).
+ * Angles are in degrees, 0 = 3 o'clock, increasing clockwise; the segment
+ * runs clockwise from start to end (a sweep of 360 or more is a full ring).
+ * @param x0 Center X.
+ * @param y0 Center Y.
+ * @param r_outer Outer radius.
+ * @param r_inner Inner radius (0 = pie slice, r_outer = 1-pixel arc).
+ * @param start Start angle.
+ * @param end End angle.
+ * @param color RGB565 color.
+ */
+void ST7789_FillArc(int16_t x0, int16_t y0, uint16_t r_outer, uint16_t r_inner,
+                    int16_t start, int16_t end, uint16_t color);
+
+/**
+ * @brief Draw 1-pixel circular arc (see ST7789_FillArc for angles).
+ * @param x0 Center X.
+ * @param y0 Center Y.
+ * @param r Radius.
+ * @param start Start angle.
+ * @param end End angle.
+ * @param color RGB565 color.
+ */
+void ST7789_DrawArc(int16_t x0, int16_t y0, uint16_t r, int16_t start, int16_t end, uint16_t color);
+
 // Image Drawing
 
 /**
- * @brief Draw bitmap image.
+ * @brief Draw bitmap image, clipped to the screen.
+ * With DMA, data is copied band by band into the line buffers, so it can be
+ * reused as soon as the call returns.
  * @param x Start X.
  * @param y Start Y.
  * @param w Width.
  * @param h Height.
- * @param data RGB565 data pointer.
+ * @param data RGB565 data pointer (ST7789_ORDER_SPI).
  */
 void ST7789_DrawImage(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *data);
 
+/**
+ * @brief Start streaming an image into a screen rectangle.
+ * Pixels then arrive in any number of ST7789_BlitWrite() chunks, so images
+ * larger than RAM can come straight from SD card, UART or external flash.
+ * Parts outside the screen are dropped. Draw nothing else until ST7789_BlitEnd().
+ * @param x Left edge (may be negative).
+ * @param y Top edge (may be negative).
+ * @param w Image width.
+ * @param h Image height.
+ * @param order Byte order of the pixels that will be written.
+ * @return false if no part of the image is on screen (writes are still accepted).
+ */
+bool ST7789_BlitBegin(int16_t x, int16_t y, uint16_t w, uint16_t h, ST7789_PixelOrder order);
+
+/**
+ * @brief Push the next pixels of the image (row-major, any count).
+ * Data can be reused as soon as the call returns.
+ * @param pixels RGB565 data.
+ * @param count Number of pixels.
+ */
+void ST7789_BlitWrite(const uint16_t *pixels, uint32_t count);
+
+/**
+ * @brief Finish the image (sends pixels still buffered).
+ */
+void ST7789_BlitEnd(void);
+
+/**
+ * @brief Stream a whole image from a source callback.
+ * @param x Left edge (may be negative).
+ * @param y Top edge (may be negative).
+ * @param w Image width.
+ * @param h Image height.
+ * @param order Byte order the source delivers.
+ * @param source Called until it has delivered w * h pixels or returns 0.
+ * @param context Passed to source.
+ */
+void ST7789_BlitStream(int16_t x, int16_t y, uint16_t w, uint16_t h, ST7789_PixelOrder order,
+                       ST7789_BlitSource source, void *context);
+
+/**
+ * @brief Draw a compressed image, clipped to the screen.
+ * Pixels are decoded straight into the line buffers (or the framebuffer);
+ * no full-size copy is made. Clipped rows and columns are skipped without
+ * expanding them.
+ * @param x Left edge (may be negative).
+ * @param y Top edge (may be negative).
+ * @param image Image descriptor.
+ */
+void ST7789_DrawCompressedImage(int16_t x, int16_t y, const ST7789_Image *image);
+
 // Text Functions (if fonts enabled)
 #ifdef ST7789_USE_FONTS
 
@@ -292,6 +935,8 @@ void ST7789_WriteChar(uint16_t x, uint16_t y, char ch, FontDef font,
 
 /**
  * @brief Write string with word wrap.
+ * Each line of text is sent through one address window as a single
+ * stream of glyph rows.
  * @param x Start X.
  * @param y Start Y.
  * @param str String pointer.
@@ -301,6 +946,149 @@ void ST7789_WriteChar(uint16_t x, uint16_t y, char ch, FontDef font,
  */
 void ST7789_WriteString(uint16_t x, uint16_t y, const char *str, FontDef font,
                         uint16_t color, uint16_t bgcolor);
+
+/**
+ * @brief Write string in a proportional (optionally anti-aliased) font.
+ * Glyph alpha is blended against bgcolor. '\n' starts a new line at x;
+ * drawing stops at the right or bottom edge.
+ * @param x Start X.
+ * @param y Start Y (top of the line).
+ * @param str String pointer.
+ * @param font Proportional font.
+ * @param color Foreground RGB565.
+ * @param bgcolor Background RGB565.
+ * @return X position after the last glyph drawn (x if font->bpp is not 1, 2 or 4).
+ */
+uint16_t ST7789_WriteStringProp(uint16_t x, uint16_t y, const char *str, const PropFontDef *font,
+                                uint16_t color, uint16_t bgcolor);
+
+/**
+ * @brief Measure a line of text in a proportional font.
+ * @param str String pointer (stops at '\n').
+ * @param font Proportional font.
+ * @return Width in pixels.
+ */
+uint16_t ST7789_MeasureStringProp(const char *str, const PropFontDef *font);
+
+#ifdef ST7789_USE_GLYPH_CACHE
+typedef struct {
+    uint32_t hits;       // Glyphs drawn from the cache
+    uint32_t misses;     // Glyphs expanded from the font bitmap
+    uint32_t evictions;  // Glyphs dropped to make room
+} ST7789_GlyphCacheStats;
+
+/**
+ * @brief Read glyph cache counters.
+ * @param stats Destination for the counters.
+ */
+void ST7789_GlyphCacheGetStats(ST7789_GlyphCacheStats *stats);
+
+/**
+ * @brief Drop all cached glyphs and reset the counters.
+ */
+void ST7789_GlyphCacheClear(void);
+#endif
+#endif
+
+#ifdef ST7789_USE_READBACK
+// GRAM Readback
+
+/**
+ * @brief Band callback type for ST7789_ReadBands.
+ * @param pixels RGB565 pixels of the band (native order), rows * w of them.
+ * @param y Screen row of the band's first line.
+ * @param rows Lines in the band.
+ * @param context Pointer given to ST7789_ReadBands.
+ */
+typedef void (*ST7789_ReadCallback)(const uint16_t *pixels, uint16_t y, uint16_t rows, void *context);
+
+/**
+ * @brief Output callback type for ST7789_Screenshot (e.g. a blocking UART or USB CDC write).
+ */
+typedef void (*ST7789_WriteCallback)(const uint8_t *data, uint32_t len, void *context);
+
+/**
+ * @brief Read the display ID (RDDID).
+ * @return Manufacturer, version and driver ID bytes, e.g. 0x858552 on ST7789V.
+ */
+uint32_t ST7789_ReadID(void);
+
+/**
+ * @brief Read a screen area from frame memory. Waits for queued DMA; with the
+ * framebuffer, pending dirty areas are flushed first.
+ * @param x Left edge.
+ * @param y Top edge.
+ * @param w Width.
+ * @param h Height.
+ * @param buffer Receives w * h RGB565 pixels (native order), row-major.
+ * @return false if the area is not entirely on screen (nothing read).
+ */
+bool ST7789_ReadRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *buffer);
+
+/**
+ * @brief Read a screen area band by band through a caller's buffer.
+ * The callback runs between reads (CS released), so it may draw.
+ * @param x Left edge.
+ * @param y Top edge.
+ * @param w Width.
+ * @param h Height.
+ * @param buffer Band storage; buffer_pixels / w lines per band.
+ * @param buffer_pixels Pixels in buffer (at least w).
+ * @param callback Called once per band, top to bottom.
+ * @param context Passed to callback.
+ * @return false if the area is not on screen or the buffer holds less than one line.
+ */
+bool ST7789_ReadBands(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                      uint16_t *buffer, uint32_t buffer_pixels,
+                      ST7789_ReadCallback callback, void *context);
+
+/**
+ * @brief Stream the whole screen as a 16-bit (RGB565) top-down BMP file.
+ * Reads one line at a time (ST7789_MAX_WIDTH pixels of stack), so no frame
+ * is held in RAM. Receive it with tools/screenshot.py.
+ * @param write Called for the header and then every line.
+ * @param context Passed to write.
+ */
+void ST7789_Screenshot(ST7789_WriteCallback write, void *context);
+
+#ifndef ST7789_USE_FRAMEBUFFER
+/**
+ * @brief Invert the colors of an area in place (read-modify-write), e.g. for
+ * an XOR cursor: inverting twice restores it. Clipped to the screen.
+ * With the framebuffer, change the pixels in RAM instead.
+ */
+void ST7789_InvertRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+#endif
+#endif
+
+#ifdef ST7789_USE_STATS
+// Bus Statistics
+
+// Counters since ST7789_ResetStats(), all panels together (cycle counts are core clock cycles)
+typedef struct {
+    uint32_t commands;          // Command bytes sent (DC low), window commands included
+    uint32_t windows;           // Address windows set (one per drawn area)
+    uint32_t window_commands;   // CASET / RASET actually sent (unchanged ranges are skipped)
+    uint32_t polled_writes;     // Data transfers clocked out by the CPU
+    uint32_t polled_bytes;      // Their payload, command arguments included
+    uint32_t dma_transfers;     // Data transfers queued for DMA
+    uint32_t dma_bytes;         // Their payload
+    uint64_t blocked_cycles;    // CPU stuck on the bus: polled transfers, waits for DMA or a line buffer
+    uint64_t dma_cycles;        // DMA bursts holding the bus
+} ST7789_Stats;
+
+/**
+ * @brief Copy the bus statistics.
+ * Time not in blocked_cycles is CPU work: a screen with blocked_cycles close
+ * to the frame time is bus-bound, one with little is CPU-bound.
+ * @param stats Filled in with the counters.
+ */
+void ST7789_GetStats(ST7789_Stats *stats);
+
+/**
+ * @brief Clear the statistics (also starts the cycle counter).
+ */
+void ST7789_ResetStats(void);
 #endif
 
 // Utility Functions
@@ -324,6 +1112,50 @@ void ST7789_Test(void);
     #error "ST7789_ROTATION must be defined (0-3)"
 #endif
 
+#if ST7789_RESET_MS < 5 || ST7789_RESET_MS > 120
+    #error "ST7789_RESET_MS must be 5..120"
+#endif
+
+#if defined(ST7789_USE_FRAMEBUFFER) && (ST7789_FB_LINES > ST7789_MAX_HEIGHT || ST7789_FB_LINES == 0)
+    #error "ST7789_FB_LINES must be 1..ST7789_MAX_HEIGHT"
+#endif
+
+#if defined(ST7789_USE_DMA) && (ST7789_DMA_QUEUE_SIZE & (ST7789_DMA_QUEUE_SIZE - 1)) != 0
+    #error "ST7789_DMA_QUEUE_SIZE must be a power of 2"
+#endif
+
+#if defined(ST7789_USE_SPI_BUS) && (ST7789_BUS_CHUNK < 2 || ST7789_BUS_CHUNK > 65534 || (ST7789_BUS_CHUNK & 1) != 0)
+    #error "ST7789_BUS_CHUNK must be even and 2..65534"
+#endif
+
+#if defined(ST7789_USE_SPI_16BIT) && !defined(SPI_CR1_DFF)
+    #error "ST7789_USE_SPI_16BIT needs an SPI with CR1.DFF (F1/F2/F4)"
+#endif
+
+#if defined(ST7789_USE_SPI_16BIT) && defined(ST7789_USE_SPI_BUS)
+    #error "ST7789_USE_SPI_16BIT cannot be used with ST7789_USE_SPI_BUS"
+#endif
+
+#if defined(ST7789_USE_GLYPH_CACHE) && !defined(ST7789_USE_FONTS)
+    #error "ST7789_USE_GLYPH_CACHE requires ST7789_USE_FONTS"
+#endif
+
+#if defined(ST7789_USE_GLYPH_CACHE) && (ST7789_GLYPH_CACHE_ENTRIES == 0 || ST7789_GLYPH_CACHE_ENTRIES >= 255)
+    #error "ST7789_GLYPH_CACHE_ENTRIES must be 1..254"
+#endif
+
+#if defined(ST7789_USE_DLIST) && (!defined(ST7789_USE_DMA) || defined(ST7789_USE_FRAMEBUFFER))
+    #error "ST7789_USE_DLIST requires ST7789_USE_DMA and cannot be used with ST7789_USE_FRAMEBUFFER"
+#endif
+
+#if defined(ST7789_USE_DLIST) && (ST7789_DLIST_MAX_COMMANDS == 0 || ST7789_DLIST_MAX_COMMANDS > 255)
+    #error "ST7789_DLIST_MAX_COMMANDS must be 1..255"
+#endif
+
+#if defined(ST7789_USE_READBACK) && ST7789_RAMRD_DUMMY_BITS > 16
+    #error "ST7789_RAMRD_DUMMY_BITS must be 0..16"
+#endif
+
 #if !defined(ST7789_135x240) && !defined(ST7789_240x240) && !defined(ST7789_240x320) && !defined(ST7789_170x320)
     #error "Must define one display type"
 #endif
@@ -0,0 +1,69 @@
+/**
+ * @file st7789_bench.h
+ */
+
+#ifndef __ST7789_BENCH_H
+#define __ST7789_BENCH_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include "st7789.h"
+
+/* ============== CONFIGURATION ============== */
+
+#define ST7789_BENCH_MIN_MS     200     // Time spent on each test
+#define ST7789_BENCH_MIN_OPS    4       // Operations per test, however long they take
+
+// Result lines also go to ITM stimulus port 0 (SWO viewer), comment to disable
+#define ST7789_BENCH_ITM
+
+// Result lines also go to this UART (UART_HandleTypeDef), uncomment to enable
+//#define ST7789_BENCH_UART huart1
+
+/* ============== PUBLIC API ============== */
+
+// Timing of one test
+typedef struct {
+    const char *name;
+    uint32_t ops;           // Operations timed
+    uint32_t pixels;        // Pixels drawn by all of them
+    uint32_t cycles;        // Core clock cycles, until the panel received everything
+#ifdef ST7789_USE_STATS
+    uint32_t windows;       // Address windows set
+    uint32_t blocked;       // Cycles the CPU was stuck on the bus
+    uint32_t dma;           // Cycles DMA held the bus
+#endif
+} ST7789_BenchResult;
+
+/**
+ * @brief Time every test at the current SPI clock, without reporting.
+ * Each test repeats its operation for ST7789_BENCH_MIN_MS and then waits
+ * for DMA / ST7789_Flush(), so queued transfers are included.
+ * @param results Filled in, one entry per test.
+ * @param max Entries in results.
+ * @return Number of tests run.
+ */
+uint8_t ST7789_BenchmarkRun(ST7789_BenchResult *results, uint8_t max);
+
+/**
+ * @brief Run the suite and report us per op, kilopixels/s and effective
+ * SPI MB/s (pixel payload) over ITM / UART and on screen. With
+ * ST7789_USE_STATS a second table (ITM / UART only) shows windows per op,
+ * pixels per window and the share of time blocked on the bus and in DMA.
+ */
+void ST7789_Benchmark(void);
+
+/**
+ * @brief Run ST7789_Benchmark() once per SPI prescaler, then restore the original one.
+ * @param prescalers SPI_BAUDRATEPRESCALER_* values.
+ * @param count Number of prescalers.
+ */
+void ST7789_BenchmarkSweep(const uint32_t *prescalers, uint8_t count);
+
+// Validation
+#if ST7789_BENCH_MIN_OPS == 0
+    #error "ST7789_BENCH_MIN_OPS must be at least 1"
+#endif
+
+#endif // __ST7789_BENCH_H
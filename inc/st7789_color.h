@@ -0,0 +1,118 @@
+/**
+ * @file st7789_color.h
+ */
+
+#ifndef __ST7789_COLOR_H
+#define __ST7789_COLOR_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "st7789.h"
+
+/* ============== PUBLIC API ============== */
+
+// Conversion and gradient flags
+#define ST7789_COLOR_SPI        0x01    // Output in ST7789_ORDER_SPI (default native)
+#define ST7789_COLOR_DITHER     0x02    // 4x4 ordered dither (needs screen x / y)
+
+/**
+ * @brief Fill RGB565 pixels, two per 32-bit store.
+ * @param dst Destination.
+ * @param value Pixel value, stored as is (either byte order).
+ * @param count Number of pixels.
+ */
+static inline void ST7789_ColorFill(uint16_t *dst, uint16_t value, uint32_t count)
+{
+    uint32_t pair = value | ((uint32_t)value << 16);
+
+    if (count > 0 && ((uintptr_t)dst & 2))
+    {
+        *dst++ = value;
+        count--;
+    }
+
+    for (; count >= 2; count -= 2, dst += 2)
+    {
+        memcpy(dst, &pair, 4);
+    }
+
+    if (count) *dst = value;
+}
+
+/**
+ * @brief Convert packed RGB888 (R, G, B bytes) to RGB565.
+ * @param dst Output pixels.
+ * @param src Input, 3 bytes per pixel.
+ * @param count Number of pixels.
+ * @param x Screen column of the first pixel (dither phase).
+ * @param y Screen row (dither phase).
+ * @param flags ST7789_COLOR_*.
+ */
+void ST7789_ColorFromRGB888(uint16_t *dst, const uint8_t *src, uint32_t count,
+                            uint16_t x, uint16_t y, uint8_t flags);
+
+/**
+ * @brief Convert 0xAARRGGBB words to RGB565 (alpha ignored).
+ * @param dst Output pixels.
+ * @param src Input words.
+ * @param count Number of pixels.
+ * @param x Screen column of the first pixel (dither phase).
+ * @param y Screen row (dither phase).
+ * @param flags ST7789_COLOR_*.
+ */
+void ST7789_ColorFromARGB8888(uint16_t *dst, const uint32_t *src, uint32_t count,
+                              uint16_t x, uint16_t y, uint8_t flags);
+
+/**
+ * @brief Draw a 24-bit image, converting (and optionally dithering) on the fly.
+ * @param x Left edge (may be negative).
+ * @param y Top edge (may be negative).
+ * @param w Width.
+ * @param h Height.
+ * @param rgb Packed RGB888 rows.
+ * @param dither Apply ordered dithering.
+ */
+void ST7789_DrawImageRGB888(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                            const uint8_t *rgb, bool dither);
+
+/**
+ * @brief Fill a rectangle with a linear gradient.
+ * The color runs from rgb0 at (x0, y0) to rgb1 at (x1, y1) and is constant
+ * beyond both ends and across the gradient direction.
+ * @param x Left edge of the rectangle (may be negative).
+ * @param y Top edge.
+ * @param w Width.
+ * @param h Height.
+ * @param x0 Start point (screen coordinates).
+ * @param y0
+ * @param rgb0 Start color, 0xRRGGBB.
+ * @param x1 End point (screen coordinates).
+ * @param y1
+ * @param rgb1 End color, 0xRRGGBB.
+ * @param dither Apply ordered dithering.
+ */
+void ST7789_FillLinearGradient(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                               int16_t x0, int16_t y0, uint32_t rgb0,
+                               int16_t x1, int16_t y1, uint32_t rgb1, bool dither);
+
+/**
+ * @brief Fill a rectangle with a radial gradient.
+ * @param x Left edge of the rectangle (may be negative).
+ * @param y Top edge.
+ * @param w Width.
+ * @param h Height.
+ * @param cx Center (screen coordinates).
+ * @param cy
+ * @param radius Distance at which rgb1 is reached.
+ * @param rgb0 Center color, 0xRRGGBB.
+ * @param rgb1 Outer color, 0xRRGGBB.
+ * @param dither Apply ordered dithering.
+ */
+void ST7789_FillRadialGradient(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                               int16_t cx, int16_t cy, uint16_t radius,
+                               uint32_t rgb0, uint32_t rgb1, bool dither);
+
+#endif // __ST7789_COLOR_H
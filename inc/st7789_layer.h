@@ -0,0 +1,119 @@
+/**
+ * @file st7789_layer.h
+ */
+
+#ifndef __ST7789_LAYER_H
+#define __ST7789_LAYER_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "st7789.h"
+
+/* ============== CONFIGURATION ============== */
+
+#define ST7789_LAYER_MAX_SPRITES    8       // Sprites in the scene
+#define ST7789_LAYER_MAX_DIRTY      8       // Pending screen areas before they are merged
+#define ST7789_LAYER_BAND_PIXELS    1024    // Band buffer (pixels, 2 bytes each), >= screen width
+
+/* ============== PUBLIC API ============== */
+
+// Sprite flags
+#define ST7789_SPRITE_VISIBLE   0x01    // Drawn at all
+#define ST7789_SPRITE_KEY       0x02    // Pixels equal to 'key' are transparent
+
+/**
+ * @brief Background callback: fill one row segment of the background.
+ * @param dst Output pixels (RGB565, ST7789_ORDER_NATIVE).
+ * @param x Left screen column.
+ * @param y Screen row.
+ * @param w Pixels to fill.
+ * @param context Pointer given to ST7789_LayerInit.
+ */
+typedef void (*ST7789_LayerBackground)(uint16_t *dst, uint16_t x, uint16_t y, uint16_t w, void *context);
+
+/**
+ * @brief Sprite, owned by the caller and composited in the order added.
+ * Move or restyle it by editing the fields; geometry and visibility changes
+ * are picked up by ST7789_LayerRender(), anything else needs
+ * ST7789_LayerChanged().
+ */
+typedef struct {
+    int16_t x;                  // Top-left screen position (may be off screen)
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+    const uint16_t *pixels;     // RGB565, ST7789_ORDER_NATIVE (NULL = solid 'color')
+    const uint8_t *mask;        // 1-bit opacity, MSB first, rows byte aligned (NULL = opaque)
+    const uint8_t *alpha_map;   // 8-bit opacity per pixel (NULL = none)
+    uint16_t color;             // Color of a solid sprite
+    uint16_t key;               // Transparent color (ST7789_SPRITE_KEY)
+    uint8_t alpha;              // Overall opacity, 255 = opaque
+    uint8_t flags;              // ST7789_SPRITE_*
+} ST7789_Sprite;
+
+/**
+ * @brief Reset the scene and set the background.
+ * Nothing is drawn until ST7789_LayerInvalidate() or ST7789_LayerRender().
+ * @param background Row callback, NULL for a solid color (see ST7789_LayerSetColor).
+ * @param context Passed to background.
+ */
+void ST7789_LayerInit(ST7789_LayerBackground background, void *context);
+
+/**
+ * @brief Use a solid background color (native RGB565) and redraw everything.
+ * @param color Background color.
+ */
+void ST7789_LayerSetColor(uint16_t color);
+
+/**
+ * @brief Add a sprite on top of the others.
+ * @param sprite Sprite (must stay valid until removed).
+ * @return false if the scene is full.
+ */
+bool ST7789_LayerAdd(ST7789_Sprite *sprite);
+
+/**
+ * @brief Remove a sprite (its area is redrawn on the next render).
+ * @param sprite Sprite.
+ */
+void ST7789_LayerRemove(ST7789_Sprite *sprite);
+
+/**
+ * @brief Mark a sprite for redraw after changing pixels, mask, alpha, color or key.
+ * @param sprite Sprite.
+ */
+void ST7789_LayerChanged(ST7789_Sprite *sprite);
+
+/**
+ * @brief Mark a screen area for redraw (e.g. the background changed).
+ * @param x Left edge.
+ * @param y Top edge.
+ * @param w Width.
+ * @param h Height.
+ */
+void ST7789_LayerInvalidate(int16_t x, int16_t y, uint16_t w, uint16_t h);
+
+/**
+ * @brief Composite and send every area that changed since the last render.
+ * Each area goes out in bands of up to ST7789_LAYER_BAND_PIXELS: the
+ * background is generated, the sprites are blended on top, and the band is
+ * streamed with ST7789_BlitWrite().
+ */
+void ST7789_LayerRender(void);
+
+// Validation
+#if ST7789_LAYER_BAND_PIXELS < ST7789_MAX_WIDTH
+    #error "ST7789_LAYER_BAND_PIXELS must hold at least one screen line"
+#endif
+
+#if ST7789_LAYER_MAX_SPRITES == 0 || ST7789_LAYER_MAX_SPRITES > 255
+    #error "ST7789_LAYER_MAX_SPRITES must be 1..255"
+#endif
+
+#if ST7789_LAYER_MAX_DIRTY == 0 || ST7789_LAYER_MAX_DIRTY > 255
+    #error "ST7789_LAYER_MAX_DIRTY must be 1..255"
+#endif
+
+#endif // __ST7789_LAYER_H
@@ -0,0 +1,64 @@
+/**
+ * @file st7789_term.h
+ */
+
+#ifndef __ST7789_TERM_H
+#define __ST7789_TERM_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "st7789.h"
+
+/* ============== CONFIGURATION ============== */
+
+// Text kept for redrawing when hardware scrolling is unavailable (landscape)
+#define ST7789_TERM_MAX_COLS        46     // Characters per line
+#define ST7789_TERM_MAX_ROWS        32     // Lines
+
+/* ============== PUBLIC API ============== */
+
+#ifdef ST7789_USE_FONTS
+
+/**
+ * @brief Set up a text console in a band of the screen and clear it.
+ * In portrait the band scrolls in hardware, so a new line costs one text
+ * row of pixels plus a scroll command. In landscape it falls back to
+ * redrawing the band from the stored text.
+ * @param top First screen row of the console.
+ * @param height Console height (rounded down to whole text lines).
+ * @param font Fixed-width font.
+ * @param color Text RGB565.
+ * @param bgcolor Background RGB565.
+ */
+void ST7789_TermInit(uint16_t top, uint16_t height, FontDef font,
+                     uint16_t color, uint16_t bgcolor);
+
+/**
+ * @brief Clear the console and home the cursor.
+ */
+void ST7789_TermClear(void);
+
+/**
+ * @brief Change colors for text written from now on.
+ * @param color Text RGB565.
+ * @param bgcolor Background RGB565.
+ */
+void ST7789_TermSetColor(uint16_t color, uint16_t bgcolor);
+
+/**
+ * @brief Write one character ('\n' new line, '\r' carriage return).
+ * @param ch Character.
+ */
+void ST7789_TermPutc(char ch);
+
+/**
+ * @brief Write a string, scrolling as needed.
+ * @param str String pointer.
+ */
+void ST7789_TermWrite(const char *str);
+
+#endif
+
+#endif // __ST7789_TERM_H
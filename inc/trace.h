@@ -0,0 +1,79 @@
+/**
+ * @file trace.h
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include "main.h"
+#include "perf.h"
+
+/* ============== CONFIGURATION ============== */
+
+#define TRACE_SIZE      256     // Events kept (power of 2, 8 bytes each); oldest are overwritten
+
+/* ============== TYPES ============== */
+
+// Event IDs (argument meaning in brackets)
+typedef enum {
+    TRACE_LCD_COMMAND = 1,      // Display command sent [command byte]
+    TRACE_LCD_WINDOW,           // Address window set [width << 12 | height]
+    TRACE_LCD_DATA,             // Polled data transfer [bytes]
+    TRACE_LCD_DMA_QUEUE,        // Data queued for DMA [bytes]
+    TRACE_LCD_DMA_START,        // DMA burst started, CS low [bytes at queue tail]
+    TRACE_LCD_DMA_STOP,         // DMA burst ended: queue drained or bus yielded [queued transfers left]
+    TRACE_LCD_WAIT,             // CPU starts waiting [0 = DMA idle, 1 = queue slot, 2 = line buffer]
+    TRACE_TOUCH_BURST,          // Touch burst asks for the bus [conversions]
+    TRACE_TOUCH_DONE,           // Touch burst released the bus [bytes]
+    TRACE_USER                  // First ID free for the application (up to 255)
+} TRACE_Id;
+
+// One event: cycle count, then ID in the top byte and a 24-bit argument
+typedef struct {
+    uint32_t cycles;
+    uint32_t event;
+} TRACE_Entry;
+
+/* ============== PUBLIC API ============== */
+
+/**
+ * @brief Start the cycle counter and clear the ring.
+ */
+void TRACE_Init(void);
+
+/**
+ * @brief Record an event (interrupt safe, about 20 cycles).
+ * @param id Event ID (TRACE_Id or TRACE_USER and up).
+ * @param arg Argument, truncated to 24 bits.
+ */
+void TRACE_Event(uint8_t id, uint32_t arg);
+
+/**
+ * @brief Drop all recorded events.
+ */
+void TRACE_Clear(void);
+
+/**
+ * @brief Copy the recorded events, oldest first.
+ * @param out Destination.
+ * @param max Entries in out.
+ * @return Number of entries copied (the newest ones if there are more than max).
+ */
+uint32_t TRACE_Read(TRACE_Entry *out, uint32_t max);
+
+/**
+ * @brief Print the recorded events on ITM stimulus port 0 (SWO viewer) and clear the ring.
+ * One line per event: cycles, microseconds since the previous event, name, argument.
+ * Recording is paused while dumping.
+ */
+void TRACE_Dump(void);
+
+// Validation
+#if TRACE_SIZE == 0 || (TRACE_SIZE & (TRACE_SIZE - 1)) != 0
+    #error "TRACE_SIZE must be a power of 2"
+#endif
+
+#endif // __TRACE_H
@@ -17,6 +17,14 @@
 #define XPT2046_SPI_PORT hspi1
 extern SPI_HandleTypeDef XPT2046_SPI_PORT;
 
+// Shared SPI bus (uncomment to arbitrate with the display, see spi_bus.h)
+// Touch reads then slot in between display DMA chunks at their own clock.
+// Attach with XPT2046_AttachBus().
+//#define XPT2046_USE_SPI_BUS
+#ifdef XPT2046_USE_SPI_BUS
+    #include "spi_bus.h"
+#endif
+
 // Pin Definitions
 #define XPT2046_CS_PORT  XPT2046_CS_GPIO_Port
 #define XPT2046_CS_PIN   XPT2046_CS_Pin
@@ -25,6 +33,40 @@ extern SPI_HandleTypeDef XPT2046_SPI_PORT;
 // #define XPT2046_IRQ_PORT XPT2046_IRQ_GPIO_Port
 // #define XPT2046_IRQ_PIN  XPT2046_IRQ_Pin
 
+// Event mode (requires XPT2046_IRQ_PIN): PENIRQ wakes the driver, a periodic
+// tick samples only while the pen is down and events queue up for
+// XPT2046_PollEvent(). Call XPT2046_Tick() at a fixed rate (e.g. 200 Hz);
+// with XPT2046_TIM the driver runs that timer itself, only while touched.
+// Without XPT2046_USE_SPI_BUS the tick only marks a sample as due and the
+// next XPT2046_PollEvent() runs it, so the display's SPI is never touched
+// from the interrupt.
+//#define XPT2046_USE_EVENTS
+#ifdef XPT2046_USE_EVENTS
+    #define XPT2046_EVENT_QUEUE_SIZE 16    // Queued events (power of 2, up to 128)
+    #define XPT2046_RELEASE_SAMPLES 2      // Samples without pressure before pen-up
+//  #define XPT2046_TIM htim6              // Sample timer, started on pen-down
+//  #define XPT2046_USER_EXTI_CALLBACK     // Uncomment if HAL_GPIO_EXTI_Callback is defined elsewhere
+//  #define XPT2046_USER_TIM_CALLBACK      // Uncomment if HAL_TIM_PeriodElapsedCallback is defined elsewhere
+#endif
+
+#ifdef XPT2046_TIM
+extern TIM_HandleTypeDef XPT2046_TIM;
+#endif
+
+// Timing and filter statistics (uncomment to enable, uses the DWT cycle counter)
+// Read with XPT2046_GetStats() or run XPT2046_Benchmark().
+//#define XPT2046_USE_STATS
+#ifdef XPT2046_USE_STATS
+    #include "perf.h"
+#endif
+
+// Event trace (uncomment to log every SPI burst into the trace.h ring, next to
+// the display events of ST7789_USE_TRACE; print it with TRACE_Dump())
+//#define XPT2046_USE_TRACE
+#ifdef XPT2046_USE_TRACE
+    #include "trace.h"
+#endif
+
 // Calibration values (adjust based on your display)
 // These should be calibrated for your specific touchscreen
 #define XPT2046_X_MIN               160
@@ -32,6 +74,11 @@ extern SPI_HandleTypeDef XPT2046_SPI_PORT;
 #define XPT2046_X_MAX               3870
 #define XPT2046_Y_MAX               3910
 
+// Calibration storage (uncomment to keep XPT2046_Calibration() results across
+// resets): a flash page left out of the linker script, e.g. the last 1 KB
+// page of a 64 KB STM32F103. Load at boot with XPT2046_LoadCalibration().
+//#define XPT2046_CAL_FLASH_ADDR      0x0800FC00
+
 // Coordinate adjustments (set to 1 to enable)
 #define XPT2046_X_INV               0      // Invert X coordinate
 #define XPT2046_Y_INV               0      // Invert Y coordinate
@@ -39,13 +86,73 @@ extern SPI_HandleTypeDef XPT2046_SPI_PORT;
 
 // Touch detection threshold (increase if too sensitive)
 #define XPT2046_TOUCH_THRESHOLD     500
-#define XPT2046_READ_SAMPLES        7
+#define XPT2046_READ_SAMPLES        7      // Samples per axis, all read in one SPI burst
+
+// Smoothing of successive points (after the per-burst median)
+#define XPT2046_FILTER_NONE         0
+#define XPT2046_FILTER_AVERAGE      1      // Moving average of XPT2046_AVG_SAMPLES points
+#define XPT2046_FILTER_IIR          2      // Exponential, new point weighs 1/2^XPT2046_IIR_SHIFT
+#define XPT2046_FILTER_EURO         3      // 1-euro: strong at rest, little lag when moving
+#define XPT2046_FILTER              XPT2046_FILTER_AVERAGE
 
 // Number of samples to average (reduces noise)
 #define XPT2046_AVG_SAMPLES         10
+#define XPT2046_IIR_SHIFT           2
+#define XPT2046_EURO_MIN_CUTOFF     1000   // Cutoff at rest (mHz): lower = less jitter
+#define XPT2046_EURO_BETA           20     // Cutoff added per pixel/s of speed (mHz): higher = less lag
+#define XPT2046_EURO_D_CUTOFF       1000   // Cutoff of the speed estimate (mHz)
 
 /* ============== PUBLIC API ============== */
 
+#ifdef XPT2046_USE_EVENTS
+// Touch event kinds
+typedef enum {
+    XPT2046_EVENT_DOWN,
+    XPT2046_EVENT_MOVE,
+    XPT2046_EVENT_UP
+} XPT2046_EventType;
+
+// Touch event (screen coordinates, HAL tick when sampled)
+typedef struct {
+    uint8_t type;       // XPT2046_EventType
+    int16_t x;
+    int16_t y;
+    uint32_t time;
+} XPT2046_Event;
+#endif
+
+// Affine calibration in Q16.16, raw ADC -> screen:
+// x = (a * raw_x + b * raw_y + c) >> 16, y = (d * raw_x + e * raw_y + f) >> 16
+// Corrects offset, scale, axis swap, rotation and skew in one step.
+typedef struct {
+    int32_t a, b, c;
+    int32_t d, e, f;
+} XPT2046_CalMatrix;
+
+// One calibration target: where it was drawn and what the panel read
+typedef struct {
+    int16_t screen_x;
+    int16_t screen_y;
+    int16_t raw_x;
+    int16_t raw_y;
+} XPT2046_CalPoint;
+
+#ifdef XPT2046_USE_STATS
+// Counters since XPT2046_ResetStats() (cycle counts are core clock cycles)
+typedef struct {
+    uint32_t bursts;            // SPI bursts read
+    uint32_t accepted;          // Points passed on
+    uint32_t rejected_noise;    // Burst spread too wide
+    uint32_t rejected_jump;     // Point moved more than XPT2046_JUMP_THRESHOLD
+    uint32_t resets;            // Filter restarts after XPT2046_MAX_INVALID_SAMPLES
+    uint32_t last_point;        // Cycle count at the start of the last accepted burst
+    PERF_Stat burst_cycles;     // SPI burst, bus wait included
+    PERF_Stat bus_wait_cycles;  // Waiting for the SPI bus (display DMA)
+    PERF_Stat process_cycles;   // Median, calibration and smoothing
+    PERF_Stat down_cycles;      // PENIRQ edge to first point (event mode)
+} XPT2046_Stats;
+#endif
+
 /**
  * @brief Initialize XPT2046 touch controller
  */
@@ -82,6 +189,85 @@ bool XPT2046_ReadRaw(int16_t *x, int16_t *y);
  */
 void XPT2046_Calibrate(int16_t x_min, int16_t y_min, int16_t x_max, int16_t y_max);
 
+/**
+ * @brief Least-squares fit of a calibration matrix.
+ * @param points Captured targets (at least 3, not all on one line).
+ * @param count Number of points.
+ * @param matrix Filled in on success.
+ * @return false if the points cannot determine a matrix.
+ */
+bool XPT2046_SolveCalibration(const XPT2046_CalPoint *points, uint8_t count,
+                              XPT2046_CalMatrix *matrix);
+
+/**
+ * @brief Use a calibration matrix.
+ * The matrix maps to the screen size current at the time and is kept
+ * as-is by XPT2046_SetScreenSize().
+ * @param matrix Matrix, e.g. from XPT2046_SolveCalibration().
+ */
+void XPT2046_SetCalibration(const XPT2046_CalMatrix *matrix);
+
+/**
+ * @brief Get the calibration matrix in use.
+ * @param matrix Filled in with the current matrix.
+ */
+void XPT2046_GetCalibration(XPT2046_CalMatrix *matrix);
+
+#ifdef XPT2046_CAL_FLASH_ADDR
+/**
+ * @brief Store the calibration in flash (erases the page at XPT2046_CAL_FLASH_ADDR).
+ * @return true if written and verified.
+ */
+bool XPT2046_SaveCalibration(void);
+
+/**
+ * @brief Load the stored calibration.
+ * A record made for another screen size (rotation) is ignored.
+ * @return true if a valid record was applied.
+ */
+bool XPT2046_LoadCalibration(void);
+#endif
+
+#ifdef XPT2046_USE_SPI_BUS
+/**
+ * @brief Share the SPI through an arbiter.
+ * @param bus Bus set up with SPI_BusInit() on XPT2046_SPI_PORT.
+ * @param prescaler SPI_BAUDRATEPRESCALER_x giving at most 2 MHz.
+ */
+void XPT2046_AttachBus(SPI_Bus *bus, uint32_t prescaler);
+#endif
+
+#ifdef XPT2046_USE_EVENTS
+/**
+ * @brief Take the oldest queued touch event.
+ * Do not mix with XPT2046_Read(): both share the filter state.
+ * @param event Filled in when an event is available.
+ * @return true if an event was taken.
+ */
+bool XPT2046_PollEvent(XPT2046_Event *event);
+
+/**
+ * @brief Sample tick (call at a fixed rate from a timer interrupt).
+ * Returns straight away while the pen is up, so no SPI traffic happens then.
+ * Without an attached bus the sample runs in the next XPT2046_PollEvent().
+ */
+void XPT2046_Tick(void);
+
+/**
+ * @brief PENIRQ edge handler (called by the default HAL_GPIO_EXTI_Callback).
+ * @param pin EXTI pin number.
+ */
+void XPT2046_EXTI_Callback(uint16_t pin);
+
+#ifdef XPT2046_TIM
+/**
+ * @brief Timer handler (called by the default HAL_TIM_PeriodElapsedCallback).
+ * @param htim Timer that elapsed.
+ */
+void XPT2046_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+#endif
+#endif
+
 /**
  * @brief Set screen dimensions (must match ST7789 settings)
  * @param width Screen width in pixels
@@ -105,8 +291,29 @@ void XPT2046_HardwareTest(void);
  */
 void XPT2046_LiveTest(void);
 
+#ifdef XPT2046_USE_STATS
+/**
+ * @brief Copy the statistics.
+ * @param stats Filled in with the counters.
+ */
+void XPT2046_GetStats(XPT2046_Stats *stats);
+
+/**
+ * @brief Clear the statistics (also starts the cycle counter).
+ */
+void XPT2046_ResetStats(void);
+
+/**
+ * @brief Benchmark: draw under the finger and show live timing.
+ * Shows sample rate, rejection rates, burst and filter time, pen-down
+ * latency (event mode) and burst-to-pixel latency of the drawn dots.
+ */
+void XPT2046_Benchmark(void);
+#endif
+
 /**
  * @brief Run interactive 5-point calibration.
+ * Applies the fitted matrix (and stores it with XPT2046_CAL_FLASH_ADDR).
  */
 void XPT2046_Calibration(void);
 
@@ -115,4 +322,15 @@ void XPT2046_Calibration(void);
  */
 void XPT2046_RawDiagnostic(void);
 
+// Validation
+#if defined(XPT2046_USE_EVENTS) && !defined(XPT2046_IRQ_PIN)
+    #error "XPT2046_USE_EVENTS requires XPT2046_IRQ_PIN"
+#endif
+
+// 8-bit ring indices: a full 256-slot queue would look empty
+#if defined(XPT2046_USE_EVENTS) && (XPT2046_EVENT_QUEUE_SIZE == 0 || \
+    (XPT2046_EVENT_QUEUE_SIZE & (XPT2046_EVENT_QUEUE_SIZE - 1)) != 0 || XPT2046_EVENT_QUEUE_SIZE > 128)
+    #error "XPT2046_EVENT_QUEUE_SIZE must be a power of 2 up to 128"
+#endif
+
 #endif // __XPT2046_H
@@ -0,0 +1,79 @@
+/**
+ * @file xpt2046_gesture.h
+ */
+
+#ifndef __XPT2046_GESTURE_H
+#define __XPT2046_GESTURE_H
+
+/* ============== INCLUDES ===================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "xpt2046.h"
+
+/* ============== CONFIGURATION ============== */
+
+#define XPT2046_GESTURE_QUEUE_SIZE  32     // Queued gestures (power of 2)
+#define XPT2046_GESTURE_STEP        4      // Max pixels between move events (interpolated)
+#define XPT2046_GESTURE_SLOP        10     // Movement (pixels) that still counts as a tap
+#define XPT2046_GESTURE_TAP_MS      300    // Longest press reported as a tap
+#define XPT2046_GESTURE_LONG_MS     600    // Hold time for a long press
+#define XPT2046_GESTURE_SWIPE_MS    500    // Longest stroke reported as a swipe
+#define XPT2046_GESTURE_SWIPE_MIN   40     // Shortest stroke (pixels) reported as a swipe
+#define XPT2046_GESTURE_RELEASE     3      // Failed reads before pen-up (polling only)
+
+/* ============== PUBLIC API ============== */
+
+// Gesture kinds
+typedef enum {
+    XPT2046_GESTURE_DOWN,
+    XPT2046_GESTURE_MOVE,
+    XPT2046_GESTURE_UP,
+    XPT2046_GESTURE_TAP,
+    XPT2046_GESTURE_LONG_PRESS,
+    XPT2046_GESTURE_SWIPE_LEFT,
+    XPT2046_GESTURE_SWIPE_RIGHT,
+    XPT2046_GESTURE_SWIPE_UP,
+    XPT2046_GESTURE_SWIPE_DOWN
+} XPT2046_GestureType;
+
+// Gesture (screen coordinates, HAL tick)
+typedef struct {
+    uint8_t type;       // XPT2046_GestureType
+    int16_t x;          // Current point (end point for up, tap and swipes)
+    int16_t y;
+    int16_t dx;         // Offset from the pen-down point
+    int16_t dy;
+    uint32_t time;
+    uint32_t duration;  // Time since pen-down
+} XPT2046_Gesture;
+
+/**
+ * @brief Reset the gesture engine (after XPT2046_Init).
+ */
+void XPT2046_GestureInit(void);
+
+/**
+ * @brief Pull new touch input and run the recognizers.
+ * Call from the main loop. Drains XPT2046_PollEvent() in event mode,
+ * otherwise takes one XPT2046_Read() per call.
+ */
+void XPT2046_GestureUpdate(void);
+
+/**
+ * @brief Take the oldest gesture.
+ * Move events are interpolated to at most XPT2046_GESTURE_STEP pixels
+ * apart and merged into the newest pending move once the queue is half
+ * full, so a slow consumer sees fewer, larger moves but never misses a
+ * down, up or recognized gesture.
+ * @param gesture Filled in when a gesture is available.
+ * @return true if a gesture was taken.
+ */
+bool XPT2046_GesturePoll(XPT2046_Gesture *gesture);
+
+// Validation
+#if (XPT2046_GESTURE_QUEUE_SIZE & (XPT2046_GESTURE_QUEUE_SIZE - 1)) != 0 || XPT2046_GESTURE_QUEUE_SIZE > 128
+    #error "XPT2046_GESTURE_QUEUE_SIZE must be a power of 2 up to 128"
+#endif
+
+#endif // __XPT2046_GESTURE_H
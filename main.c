@@ -23,6 +23,7 @@
 /* USER CODE BEGIN Includes */
 
 #include <st7789.h>
+#include <st7789_bench.h>
 #include <xpt2046.h>
 
 /* USER CODE END Includes */
@@ -35,6 +36,19 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
+// What runs after initialization (set APP_MODE to one of these)
+#define APP_TOUCH_TEST        0   // XPT2046_Test()
+#define APP_DISPLAY_TEST      1   // ST7789_Test()
+#define APP_DISPLAY_BENCH     2   // ST7789_Benchmark(): results on screen and ITM / UART
+#define APP_DISPLAY_SWEEP     3   // ST7789_Benchmark() at several SPI clocks
+#define APP_TOUCH_HARDWARE    4   // XPT2046_HardwareTest()
+#define APP_TOUCH_LIVE        5   // XPT2046_LiveTest()
+#define APP_TOUCH_RAW         6   // XPT2046_RawDiagnostic()
+#define APP_TOUCH_CALIBRATE   7   // XPT2046_Calibration()
+#define APP_TOUCH_BENCH       8   // XPT2046_Benchmark() (needs XPT2046_USE_STATS)
+
+#define APP_MODE APP_TOUCH_TEST
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -47,6 +61,10 @@ SPI_HandleTypeDef hspi1;
 
 /* USER CODE BEGIN PV */
 
+#if defined(ST7789_USE_SPI_BUS) || defined(XPT2046_USE_SPI_BUS)
+static SPI_Bus spi1_bus;
+#endif
+
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -94,6 +112,17 @@ int main(void)
   MX_SPI1_Init();
   /* USER CODE BEGIN 2 */
 
+#if defined(ST7789_USE_SPI_BUS) || defined(XPT2046_USE_SPI_BUS)
+  // Display and touch share SPI1: 16 MHz for the display, 2 MHz for the touch ADC
+  SPI_BusInit(&spi1_bus, &hspi1);
+#endif
+#ifdef ST7789_USE_SPI_BUS
+  ST7789_AttachBus(&spi1_bus, SPI_BAUDRATEPRESCALER_4);
+#endif
+#ifdef XPT2046_USE_SPI_BUS
+  XPT2046_AttachBus(&spi1_bus, SPI_BAUDRATEPRESCALER_32);
+#endif
+
   // Initialize ST7789
   ST7789_Init();
 
@@ -103,23 +132,38 @@ int main(void)
   // SetScreenSize
   XPT2046_SetScreenSize(ST7789_WIDTH, ST7789_HEIGHT);
 
-  // Test
-
-//  ST7789_Test();
-
-//  HAL_Delay(2000);
-
-//  XPT2046_HardwareTest();
-
-//  HAL_Delay(2000);
-
-//  XPT2046_LiveTest();
+#ifdef XPT2046_CAL_FLASH_ADDR
+  // Stored calibration, if any (run XPT2046_Calibration() once to create it)
+  XPT2046_LoadCalibration();
+#endif
 
+  // Test / demo selected by APP_MODE
+#if APP_MODE == APP_TOUCH_TEST
   XPT2046_Test();
-
-//  XPT2046_RawDiagnostic();
-
-//  XPT2046_Calibration();
+#elif APP_MODE == APP_DISPLAY_TEST
+  ST7789_Test();
+#elif APP_MODE == APP_DISPLAY_BENCH
+  ST7789_Benchmark();
+#elif APP_MODE == APP_DISPLAY_SWEEP
+  static const uint32_t prescalers[] = {
+    SPI_BAUDRATEPRESCALER_2, SPI_BAUDRATEPRESCALER_4, SPI_BAUDRATEPRESCALER_8, SPI_BAUDRATEPRESCALER_16
+  };
+  for (uint8_t i = 0; i < sizeof(prescalers) / sizeof(prescalers[0]); i++)
+  {
+    ST7789_BenchmarkSweep(&prescalers[i], 1);
+    HAL_Delay(3000);
+  }
+#elif APP_MODE == APP_TOUCH_HARDWARE
+  XPT2046_HardwareTest();
+#elif APP_MODE == APP_TOUCH_LIVE
+  XPT2046_LiveTest();
+#elif APP_MODE == APP_TOUCH_RAW
+  XPT2046_RawDiagnostic();
+#elif APP_MODE == APP_TOUCH_CALIBRATE
+  XPT2046_Calibration();
+#elif APP_MODE == APP_TOUCH_BENCH
+  XPT2046_Benchmark();
+#endif
 
   /* USER CODE END 2 */
 
@@ -0,0 +1,263 @@
+/**
+ * @file spi_bus.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "spi_bus.h"
+#include <stddef.h>
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Check if a device is in the wait queue (IRQs disabled)
+ */
+static bool SPI_BusIsQueued(const SPI_Bus *bus, const SPI_BusDevice *dev)
+{
+    for (const SPI_BusDevice *d = bus->head; d != NULL; d = d->next)
+    {
+        if (d == dev) return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Append a device to the wait queue (IRQs disabled)
+ */
+static void SPI_BusPush(SPI_Bus *bus, SPI_BusDevice *dev)
+{
+    dev->next = NULL;
+
+    if (bus->tail != NULL)
+    {
+        bus->tail->next = dev;
+    }
+    else
+    {
+        bus->head = dev;
+    }
+
+    bus->tail = dev;
+}
+
+/**
+ * @brief Remove the oldest waiting device (IRQs disabled)
+ */
+static SPI_BusDevice *SPI_BusPop(SPI_Bus *bus)
+{
+    SPI_BusDevice *dev = bus->head;
+
+    if (dev != NULL)
+    {
+        bus->head = dev->next;
+        if (bus->head == NULL) bus->tail = NULL;
+        dev->next = NULL;
+    }
+
+    return dev;
+}
+
+/**
+ * @brief Switch the SPI clock to the device's prescaler
+ * BR may only change while the peripheral is disabled; the drivers
+ * re-enable it on their next transfer.
+ */
+static void SPI_BusApply(SPI_BusDevice *dev)
+{
+    SPI_HandleTypeDef *hspi = dev->bus->hspi;
+
+    if ((hspi->Instance->CR1 & SPI_CR1_BR) == dev->prescaler) return;
+
+    while (hspi->Instance->SR & SPI_SR_BSY);
+
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Instance->CR1 = (hspi->Instance->CR1 & ~SPI_CR1_BR) | dev->prescaler;
+    hspi->Init.BaudRatePrescaler = dev->prescaler;
+}
+
+/**
+ * @brief Finish handing the bus to a new owner (IRQs enabled again)
+ */
+static void SPI_BusGranted(SPI_BusDevice *dev)
+{
+    // Blocking acquirers spin on the owner and switch the clock themselves
+    if (!dev->notify) return;
+
+    dev->notify = false;
+    SPI_BusApply(dev);
+
+    if (dev->grant != NULL)
+    {
+        dev->grant(dev);
+    }
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Set up a bus
+ */
+void SPI_BusInit(SPI_Bus *bus, SPI_HandleTypeDef *hspi)
+{
+    bus->hspi = hspi;
+    bus->owner = NULL;
+    bus->head = NULL;
+    bus->tail = NULL;
+}
+
+/**
+ * @brief Register a device
+ */
+void SPI_BusAddDevice(SPI_BusDevice *dev, SPI_Bus *bus, uint32_t prescaler,
+                      SPI_BusGrant grant, void *context)
+{
+    dev->bus = bus;
+    dev->prescaler = prescaler & SPI_CR1_BR;
+    dev->grant = grant;
+    dev->context = context;
+    dev->next = NULL;
+    dev->notify = false;
+}
+
+/**
+ * @brief Take the bus if free
+ */
+bool SPI_BusTryAcquire(SPI_BusDevice *dev)
+{
+    SPI_Bus *bus = dev->bus;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->owner == NULL)
+    {
+        bus->owner = dev;
+    }
+
+    bool owned = (bus->owner == dev);
+
+    __set_PRIMASK(primask);
+
+    if (owned) SPI_BusApply(dev);
+
+    return owned;
+}
+
+/**
+ * @brief Take the bus, waiting in turn
+ */
+void SPI_BusAcquire(SPI_BusDevice *dev)
+{
+    SPI_Bus *bus = dev->bus;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->owner == NULL)
+    {
+        bus->owner = dev;
+    }
+    else if (bus->owner != dev && !SPI_BusIsQueued(bus, dev))
+    {
+        dev->notify = false;
+        SPI_BusPush(bus, dev);
+    }
+
+    __set_PRIMASK(primask);
+
+    while (bus->owner != dev);
+
+    SPI_BusApply(dev);
+}
+
+/**
+ * @brief Ask for the bus, granted through the callback
+ */
+void SPI_BusRequest(SPI_BusDevice *dev)
+{
+    SPI_Bus *bus = dev->bus;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->owner == NULL)
+    {
+        bus->owner = dev;
+        dev->notify = true;
+        __set_PRIMASK(primask);
+
+        SPI_BusGranted(dev);
+        return;
+    }
+
+    if (bus->owner != dev && !SPI_BusIsQueued(bus, dev))
+    {
+        dev->notify = true;
+        SPI_BusPush(bus, dev);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Check for waiting devices
+ */
+bool SPI_BusIsContended(const SPI_BusDevice *dev)
+{
+    return dev->bus->head != NULL;
+}
+
+/**
+ * @brief Let waiting devices go first
+ */
+bool SPI_BusYield(SPI_BusDevice *dev)
+{
+    SPI_Bus *bus = dev->bus;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->owner != dev || bus->head == NULL)
+    {
+        __set_PRIMASK(primask);
+        return false;
+    }
+
+    SPI_BusDevice *next = SPI_BusPop(bus);
+    bus->owner = next;
+    dev->notify = true;
+    SPI_BusPush(bus, dev);
+
+    __set_PRIMASK(primask);
+
+    SPI_BusGranted(next);
+    return true;
+}
+
+/**
+ * @brief Give up the bus
+ */
+void SPI_BusRelease(SPI_BusDevice *dev)
+{
+    SPI_Bus *bus = dev->bus;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->owner != dev)
+    {
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    SPI_BusDevice *next = SPI_BusPop(bus);
+    bus->owner = next;
+
+    __set_PRIMASK(primask);
+
+    if (next != NULL)
+    {
+        SPI_BusGranted(next);
+    }
+}
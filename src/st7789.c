@@ -4,6 +4,7 @@
 
 /* ============== INCLUDES ===================== */
 #include "st7789.h"
+#include "st7789_color.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -26,6 +27,14 @@
 #define ST7789_PTLON      0x12	// Partial Display Mode On
 #define ST7789_NORON      0x13	// Normal Display Mode On
 #define ST7789_PTLAR      0x30	// Partial Display Area
+#define ST7789_VSCRDEF    0x33	// Vertical Scrolling Definition
+#define ST7789_VSCSAD     0x37	// Vertical Scroll Start Address
+#define ST7789_IDMOFF     0x38	// Idle Mode Off (full color)
+#define ST7789_IDMON      0x39	// Idle Mode On (8 colors)
+
+// Frame Rate Control
+#define ST7789_FRCTRL1    0xB3	// Frame Rate Control (idle/partial mode)
+#define ST7789_FRCTRL2    0xC6	// Frame Rate Control (normal mode)
 
 // Display Mode Control
 #define ST7789_INVOFF     0x20	// Display Inversion Off
@@ -50,573 +59,4039 @@
 // Color Mode
 #define ST7789_COLOR_MODE_16bit 0x55  // RGB565
 
-// GPIO Macros
+// Frame memory rows (scroll areas always add up to this)
+#define ST7789_GRAM_ROWS  320
+
+// Frame rate = 10 MHz / ((320 + porches) * (250 + 16 * RTN) * 2^DIV), porches 0x0C + 0x0C
+#define ST7789_FR_LINE_CLOCKS   (10000000UL / (ST7789_GRAM_ROWS + 0x0C + 0x0C))
+#define ST7789_FR_RTN_MAX       0x1F
+#define ST7789_FR_DIV_MAX       3
+
+// Current rotation (constant unless ST7789_RUNTIME_ROTATION, so checks fold away)
+#ifdef ST7789_RUNTIME_ROTATION
+    #define ROTATION        (st7789_display.rotation)
+#else
+    #define ROTATION        ST7789_ROTATION
+#endif
+#define IS_LANDSCAPE()      ((ROTATION & 1) != 0)
+#define IS_MIRROR_Y()       (ROTATION == 0 || ROTATION == 1)   // MADCTL MY set
+
+// Screen axis that runs along frame memory rows, and its panel offset
+#define ST7789_SCAN_LINES   (IS_LANDSCAPE() ? ST7789_WIDTH : ST7789_HEIGHT)
+#define ST7789_SCAN_SHIFT   (IS_LANDSCAPE() ? ST7789_X_SHIFT : ST7789_Y_SHIFT)
+
+// Command list encoding: cmd, argc [| CMD_DELAY], args..., [delay ms]
+#define CMD_DELAY   0x80
+
+// Reset to Sleep Out (ms, datasheet): SLPOUT is ignored before this
+#define SLPOUT_AFTER_RESET_MS   120
+
+// GPIO Macros (CS/DC toggle on every command: write BSRR directly)
 #ifdef ST7789_USE_CS
-    #define CS_LOW()   HAL_GPIO_WritePin(ST7789_CS_PORT, ST7789_CS_PIN, GPIO_PIN_RESET)
-    #define CS_HIGH()  HAL_GPIO_WritePin(ST7789_CS_PORT, ST7789_CS_PIN, GPIO_PIN_SET)
+    #define PANEL_CS_LOW(p)   ((p)->cs_port->BSRR = (uint32_t)(p)->cs_pin << 16)
+    #define PANEL_CS_HIGH(p)  ((p)->cs_port->BSRR = (p)->cs_pin)
 #else
-    #define CS_LOW()
-    #define CS_HIGH()
+    #define PANEL_CS_LOW(p)   ((void)(p))
+    #define PANEL_CS_HIGH(p)  ((void)(p))
 #endif
 
-#define DC_LOW()   HAL_GPIO_WritePin(ST7789_DC_PORT, ST7789_DC_PIN, GPIO_PIN_RESET)
-#define DC_HIGH()  HAL_GPIO_WritePin(ST7789_DC_PORT, ST7789_DC_PIN, GPIO_PIN_SET)
-#define RST_LOW()  HAL_GPIO_WritePin(ST7789_RST_PORT, ST7789_RST_PIN, GPIO_PIN_RESET)
-#define RST_HIGH() HAL_GPIO_WritePin(ST7789_RST_PORT, ST7789_RST_PIN, GPIO_PIN_SET)
+#define PANEL_DC_HIGH(p)  ((p)->dc_port->BSRR = (p)->dc_pin)
+
+// On a shared bus, every CS assertion holds the bus
+#ifdef ST7789_USE_SPI_BUS
+    #define CS_LOW()   ST7789_BusBegin(st7789_current)
+    #define CS_HIGH()  ST7789_BusEnd(st7789_current)
+#else
+    #define CS_LOW()   PANEL_CS_LOW(st7789_current)
+    #define CS_HIGH()  PANEL_CS_HIGH(st7789_current)
+#endif
+#define DC_LOW()   (st7789_current->dc_port->BSRR = (uint32_t)st7789_current->dc_pin << 16)
+#define DC_HIGH()  PANEL_DC_HIGH(st7789_current)
+#define RST_LOW()  HAL_GPIO_WritePin(st7789_current->rst_port, st7789_current->rst_pin, GPIO_PIN_RESET)
+#define RST_HIGH() HAL_GPIO_WritePin(st7789_current->rst_port, st7789_current->rst_pin, GPIO_PIN_SET)
 
 #define ABS(x) ((x) > 0 ? (x) : -(x))
 
-/* ============== PRIVATE VARIABLES ============== */
+// Pixels ST7789_BlitStream asks its source for at a time
+#define BLIT_STREAM_PIXELS  64
 
-#ifdef ST7789_USE_DMA
-static uint16_t dma_buffer[ST7789_WIDTH * ST7789_DMA_BUFFER_LINES];
-#endif
+// Pixels buffered per anti-aliased span before it is sent
+#define SPAN_PIXELS  64
 
-/* ============== PRIVATE FUNCTIONS ============== */
+// Pixels received per SPI read (3 bytes each)
+#define READ_CHUNK_PIXELS  32
 
-/**
- * @brief Write command to ST7789
- */
-static inline void ST7789_WriteCommand(uint8_t cmd)
-{
-    CS_LOW();
-    DC_LOW();
-    HAL_SPI_Transmit(&ST7789_SPI_PORT, &cmd, 1, HAL_MAX_DELAY);
-    CS_HIGH();
-}
+// SPI transfer size unit: 16-bit frames count halfwords
+#ifdef ST7789_USE_SPI_16BIT
+    #define SPI_UNITS(p, bytes)  ((p)->spi_wide ? (bytes) / 2 : (bytes))
+#else
+    #define SPI_UNITS(p, bytes)  (bytes)
+#endif
 
-/**
- * @brief Write single byte data
- */
-static inline void ST7789_WriteData8(uint8_t data)
-{
-    CS_LOW();
-    DC_HIGH();
-    HAL_SPI_Transmit(&ST7789_SPI_PORT, &data, 1, HAL_MAX_DELAY);
-    CS_HIGH();
-}
+// Statistics hooks
+#ifdef ST7789_USE_STATS
+#define STATS_NOW()                 PERF_Cycles()
+#define STATS_ADD(field, n)         (bus_stats.field += (n))
+#define STATS_TIME(field, start)    (bus_stats.field += PERF_Cycles() - (start))
+#else
+#define STATS_NOW()                 0
+#define STATS_ADD(field, n)         ((void)0)
+#define STATS_TIME(field, start)    ((void)(start))
+#endif
 
-/**
- * @brief Write bulk data with DMA support
- */
-static void ST7789_WriteData(uint8_t *data, size_t len)
-{
-    CS_LOW();
-    DC_HIGH();
+// What a TRACE_LCD_WAIT event waited for
+#define WAIT_DMA_IDLE       0
+#define WAIT_QUEUE_SLOT     1
+#define WAIT_LINE_BUFFER    2
 
-    while (len > 0)
-    {
-        uint16_t chunk = (len > 65535) ? 65535 : len;
+// Trace hook
+#ifdef ST7789_USE_TRACE
+#define TRACE_HOOK(id, arg)         TRACE_Event(id, arg)
+#else
+#define TRACE_HOOK(id, arg)         ((void)0)
+#endif
 
-        #ifdef ST7789_USE_DMA
-        if (chunk >= ST7789_DMA_MIN_SIZE)
-        {
-            HAL_SPI_Transmit_DMA(&ST7789_SPI_PORT, data, chunk);
-            while (ST7789_SPI_PORT.hdmatx->State != HAL_DMA_STATE_READY);
-        }
-        else
-        {
-            HAL_SPI_Transmit(&ST7789_SPI_PORT, data, chunk, HAL_MAX_DELAY);
-        }
-        #else
-        HAL_SPI_Transmit(&ST7789_SPI_PORT, data, chunk, HAL_MAX_DELAY);
-        #endif
+/* ============== PUBLIC VARIABLES ============== */
 
-        data += chunk;
-        len -= chunk;
-    }
+// Panel described by the configuration macros
+static st7789_t st7789_default = {
+    .spi = &ST7789_SPI_PORT,
+#ifdef ST7789_USE_CS
+    .cs_port = ST7789_CS_PORT,
+    .cs_pin = ST7789_CS_PIN,
+#endif
+    .dc_port = ST7789_DC_PORT,
+    .dc_pin = ST7789_DC_PIN,
+    .rst_port = ST7789_RST_PORT,
+    .rst_pin = ST7789_RST_PIN,
+    .display = {
+        ST7789_DEFAULT_WIDTH,
+        ST7789_DEFAULT_HEIGHT,
+        ST7789_DEFAULT_X_SHIFT,
+        ST7789_DEFAULT_Y_SHIFT,
+        ST7789_ROTATION
+    },
+    .frame_rtna = 0x0F,
+#ifdef ST7789_USE_POWER_MANAGER
+    .power = {ST7789_IDLE_TIMEOUT_MS, 0, true, ST7789_FR_RTN_MAX, false},
+#endif
+};
 
-    CS_HIGH();
-}
+st7789_t *st7789_current = &st7789_default;
 
-/**
- * @brief Set drawing window
- */
-static void ST7789_SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
-{
-    x0 += ST7789_X_SHIFT;
-    x1 += ST7789_X_SHIFT;
-    y0 += ST7789_Y_SHIFT;
-    y1 += ST7789_Y_SHIFT;
+/* ============== PRIVATE VARIABLES ============== */
 
-    // Column Address Set
-    ST7789_WriteCommand(ST7789_CASET);
-    uint8_t data[] = {
-        x0 >> 8, x0 & 0xFF,
-        x1 >> 8, x1 & 0xFF
-    };
-    ST7789_WriteData(data, 4);
+// Power-on configuration, sent in one CS assertion (see ST7789_SendCommandList).
+// Registers take writes in sleep mode, so this goes out before Sleep Out.
+static const uint8_t init_cmds[] = {
+    ST7789_COLMOD, 1, ST7789_COLOR_MODE_16bit,          // 16-bit RGB565
+    0xB2, 5, 0x0C, 0x0C, 0x00, 0x33, 0x33,              // Porch control
+    0xB7, 1, 0x35,                                      // Gate control
+    0xBB, 1, 0x19,                                      // VCOM
+    0xC0, 1, 0x2C,                                      // LCM control
+    0xC2, 1, 0x01,                                      // VDV and VRH enable
+    0xC3, 1, 0x12,                                      // VRH
+    0xC4, 1, 0x20,                                      // VDV
+    0xD0, 2, 0xA4, 0xA1,                                // Power control
+    0xE0, 14, 0xD0, 0x04, 0x0D, 0x11, 0x13, 0x2B, 0x3F, // Positive voltage gamma
+              0x54, 0x4C, 0x18, 0x0D, 0x0B, 0x1F, 0x23,
+    0xE1, 14, 0xD0, 0x04, 0x0C, 0x11, 0x13, 0x2C, 0x3F, // Negative voltage gamma
+              0x44, 0x51, 0x2F, 0x1F, 0x1F, 0x20, 0x23,
+    ST7789_INVOFF, 0,                                   // Inversion off
+    ST7789_NORON, 0,                                    // Normal display mode
+};
 
-    // Row Address Set
-    ST7789_WriteCommand(ST7789_RASET);
-    data[0] = y0 >> 8;
-    data[1] = y0 & 0xFF;
-    data[2] = y1 >> 8;
-    data[3] = y1 & 0xFF;
-    ST7789_WriteData(data, 4);
+static const uint8_t slpout_cmd[] = {
+    ST7789_SLPOUT, CMD_DELAY, 5,                        // Sleep out (5 ms before the next command)
+};
 
-    // Write to RAM
-    ST7789_WriteCommand(ST7789_RAMWR);
-}
+// MADCTL and panel offsets per rotation
+static const struct {
+    uint8_t madctl;
+    uint16_t x_shift;
+    uint16_t y_shift;
+} rotations[4] = {
+    {MADCTL_MX | MADCTL_MY | MADCTL_RGB, ST7789_R0_X_SHIFT, ST7789_R0_Y_SHIFT},  // Portrait
+    {MADCTL_MY | MADCTL_MV | MADCTL_RGB, ST7789_R1_X_SHIFT, ST7789_R1_Y_SHIFT},  // Landscape
+    {MADCTL_RGB,                         ST7789_R2_X_SHIFT, ST7789_R2_Y_SHIFT},  // Portrait Inverted
+    {MADCTL_MX | MADCTL_MV | MADCTL_RGB, ST7789_R3_X_SHIFT, ST7789_R3_Y_SHIFT},  // Landscape Inverted
+};
 
-/**
- * @brief Hardware reset
- */
-static void ST7789_HardReset(void)
-{
-    RST_HIGH();
-    HAL_Delay(5);
-    RST_LOW();
-    HAL_Delay(20);
-    RST_HIGH();
-    HAL_Delay(150);
-}
+// Triangle edge walked one row at a time (16.16 fixed point)
+typedef struct {
+    int64_t x;       // X at current row
+    int64_t step;    // X increment per row
+} ST7789_Edge;
 
-/**
- * @brief Set drawing horizontal line
- */
-static void ST7789_DrawHorizontalLine(int16_t x0, int16_t y, int16_t x_left, int16_t x_right, uint16_t color)
-{
-    if (y < 0 || y >= ST7789_HEIGHT) return;
+// Row or column of individually colored pixels, sent as one window
+typedef struct {
+    int16_t x;          // First pixel
+    int16_t y;
+    uint16_t len;
+    bool vertical;
+    uint16_t pixels[SPAN_PIXELS];   // SPI byte order
+} ST7789_Span;
 
-    // Clamp x coordinates
-    if (x_left < 0) x_left = 0;
-    if (x_right >= ST7789_WIDTH) x_right = ST7789_WIDTH - 1;
+#ifdef ST7789_USE_DMA
+#define DMA_BUFFER_PIXELS (ST7789_MAX_WIDTH * ST7789_DMA_BUFFER_LINES)
+#define DMA_NO_BUFFER     0xFF
 
-    if (x_left > x_right) return;
+// Ping-pong line buffers: CPU fills one while DMA drains the other
+static uint16_t dma_buffer[2][DMA_BUFFER_PIXELS];
+static uint16_t dma_buffer_color[2];           // Cached solid color (SPI byte order)
+static uint32_t dma_buffer_fill[2];            // Pixels holding cached color (0 = none)
+static volatile uint8_t dma_buffer_refs[2];    // Queued transfers reading buffer
+static uint8_t dma_buffer_next = 0;            // Preferred buffer for next acquire
 
-    uint16_t width = x_right - x_left + 1;
-    ST7789_FillRect(x_left, y, width, 1, color);
-}
+// Panels whose DMA completions are dispatched from the SPI callback
+static st7789_t *dma_panels[ST7789_MAX_PANELS] = {&st7789_default};
+#endif
 
-/* ============== PUBLIC FUNCTIONS ============== */
+#ifdef ST7789_USE_FONTS
+// Glyphs drawn side by side through one address window
+typedef struct {
+    const char *str;
+    uint16_t count;
+    const FontDef *font;
+    uint16_t fg;                          // Colors in SPI byte order
+    uint16_t bg;
+#ifdef ST7789_USE_GLYPH_CACHE
+    uint8_t slot[ST7789_GLYPH_CACHE_ENTRIES];  // Cache entry per glyph or GLYPH_NO_SLOT
+#endif
+} ST7789_GlyphRun;
 
-/**
- * @brief Initialize ST7789
- */
-void ST7789_Init(void)
-{
-    #ifdef ST7789_USE_DMA
-    memset(dma_buffer, 0, sizeof(dma_buffer));
-    #endif
+// Position in a proportional glyph's RLE stream
+typedef struct {
+    const uint8_t *src;    // Next token
+    uint8_t run;           // Pixels left in current run
+    uint8_t level;         // Alpha level of current run
+} ST7789_RleState;
+#endif
 
-    // Hardware Reset
-    ST7789_HardReset();
+#ifdef ST7789_USE_GLYPH_CACHE
+#define GLYPH_ARENA_PIXELS (ST7789_GLYPH_CACHE_SIZE / 2)
+#define GLYPH_NO_SLOT      0xFF
 
-    // Software Reset
-    ST7789_WriteCommand(ST7789_SWRESET);
-    HAL_Delay(150);
+typedef struct {
+    const uint16_t *font;    // Font bitmap the glyph came from (NULL = free)
+    uint16_t fg;             // Colors in SPI byte order
+    uint16_t bg;
+    uint32_t offset;         // First pixel in glyph_arena
+    uint32_t pixels;
+    uint32_t stamp;          // glyph_clock at last use
+    char ch;
+} ST7789_Glyph;
 
-    // Sleep Out
-    ST7789_WriteCommand(ST7789_SLPOUT);
-    HAL_Delay(10);
+// Expanded glyphs packed from the start; evictions leave holes until compaction
+static uint16_t glyph_arena[GLYPH_ARENA_PIXELS];
+static ST7789_Glyph glyph_cache[ST7789_GLYPH_CACHE_ENTRIES];
+static uint32_t glyph_arena_end = 0;     // First pixel after the highest entry
+static uint32_t glyph_arena_used = 0;    // Pixels held by live entries
+static uint32_t glyph_clock = 0;         // Bumped once per glyph run
+static ST7789_GlyphCacheStats glyph_stats = {0, 0, 0};
+#endif
 
-    // Color Mode - 16bit RGB565
-    ST7789_WriteCommand(ST7789_COLMOD);
-    ST7789_WriteData8(ST7789_COLOR_MODE_16bit);
+#ifdef ST7789_USE_STATS
+static ST7789_Stats bus_stats;
+#endif
 
-    // Porch Control
-    ST7789_WriteCommand(0xB2);
-    uint8_t porch[] = {0x0C, 0x0C, 0x00, 0x33, 0x33};
-    ST7789_WriteData(porch, 5);
+#if defined(ST7789_USE_FONTS) && !defined(ST7789_USE_DMA) && !defined(ST7789_USE_FRAMEBUFFER)
+// One screen row of expanded glyph pixels (SPI byte order)
+static uint16_t text_buffer[ST7789_MAX_WIDTH];
+#endif
 
-    // Gate Control
-    ST7789_WriteCommand(0xB7);
-    ST7789_WriteData8(0x35);
+#ifdef ST7789_USE_FRAMEBUFFER
+// A full framebuffer holds the panel in any rotation; a band spans the widest row
+#if ST7789_FB_LINES >= ST7789_MAX_HEIGHT
+    #define FB_PIXELS (ST7789_PANEL_WIDTH * ST7789_PANEL_HEIGHT)
+#else
+    #define FB_PIXELS (ST7789_MAX_WIDTH * ST7789_FB_LINES)
+#endif
 
-    // VCOM Setting
-    ST7789_WriteCommand(0xBB);
-    ST7789_WriteData8(0x19);
+// Screen lines held in RAM for the current rotation
+#define FB_LINES  ((FB_PIXELS / ST7789_WIDTH < ST7789_HEIGHT) ? FB_PIXELS / ST7789_WIDTH : ST7789_HEIGHT)
 
-    // LCM Control
-    ST7789_WriteCommand(0xC0);
-    ST7789_WriteData8(0x2C);
+typedef struct {
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+} ST7789_Rect;    // Inclusive bounds
 
-    // VDV and VRH Enable
-    ST7789_WriteCommand(0xC2);
-    ST7789_WriteData8(0x01);
+// Pixels stored in SPI byte order so flushing needs no conversion
+static uint16_t framebuffer[FB_PIXELS];
+static uint16_t fb_band_y = 0;          // First screen line held in RAM
+static uint16_t fb_band_color = 0;      // Banded mode: color each band starts with
+static ST7789_Rect fb_dirty[ST7789_FB_MAX_DIRTY];
+static uint8_t fb_dirty_count = 0;
+#endif
 
-    // VRH Set
-    ST7789_WriteCommand(0xC3);
-    ST7789_WriteData8(0x12);
+// Image being streamed by ST7789_BlitWrite
+static struct {
+    int16_t x;          // Screen position of the image origin
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t col;       // Next source pixel
+    uint16_t row;
+    uint16_t x0;        // Visible source columns [x0, x1) and rows [y0, y1)
+    uint16_t x1;
+    uint16_t y0;
+    uint16_t y1;
+    bool swap;          // Swap bytes while copying
+#ifdef ST7789_USE_DMA
+    uint8_t buffer;     // Line buffer being filled (DMA_NO_BUFFER = none)
+    uint32_t fill;      // Pixels in it
+#endif
+} blit;
 
-    // VDV Set
-    ST7789_WriteCommand(0xC4);
-    ST7789_WriteData8(0x20);
+// Compressed image being decoded by ST7789_DrawCompressedImage
+static struct {
+    const ST7789_Image *image;
+    const uint8_t *data;    // RLE: next token byte
+    uint32_t pos;           // Packed: next pixel (row-major)
+    uint16_t run;           // RLE: pixels left in the current token
+    uint16_t value;         // RLE: repeated index or color
+    bool literal;           // RLE: token holds literal values
+} decoder;
 
-    // Frame Rate Control
-    ST7789_WriteCommand(0xC6);
-    ST7789_WriteData8(0x0F);
+#ifdef ST7789_USE_DLIST
+// Display list command types
+#define DLIST_FILL    0
+#define DLIST_LINE    1
+#define DLIST_CIRCLE  2
+#define DLIST_IMAGE   3
+#define DLIST_TEXT    4
 
-    // Power Control
-    ST7789_WriteCommand(0xD0);
-    uint8_t power[] = {0xA4, 0xA1};
-    ST7789_WriteData(power, 2);
+// Command flags
+#define DLIST_STEEP   0x01    // Line: major axis is y
+#define DLIST_UP      0x02    // Line: minor coordinate decreases
+#define DLIST_SWAP    0x04    // Image: native byte order
 
-    // Positive Voltage Gamma
-    ST7789_WriteCommand(0xE0);
-    uint8_t pvgamma[] = {0xD0, 0x04, 0x0D, 0x11, 0x13, 0x2B, 0x3F,
-                         0x54, 0x4C, 0x18, 0x0D, 0x0B, 0x1F, 0x23};
-    ST7789_WriteData(pvgamma, 14);
+// Recorded command; text characters follow it in the arena
+typedef struct {
+    uint8_t type;           // DLIST_*
+    uint8_t flags;          // DLIST_STEEP, DLIST_UP, DLIST_SWAP
+    uint16_t color;         // SPI byte order
+    int16_t x0;             // Bounds, inclusive and clipped to the region
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+    int16_t a;              // Line start (major, minor axis) / circle center / image or text origin
+    int16_t b;
+    uint16_t c;             // Line major length / outer radius / image width / text length
+    uint16_t d;             // Line minor length / inner radius / text background
+    const void *data;       // Image pixels / font
+} ST7789_DListCmd;
 
-    // Negative Voltage Gamma
-    ST7789_WriteCommand(0xE1);
-    uint8_t nvgamma[] = {0xD0, 0x04, 0x0C, 0x11, 0x13, 0x2C, 0x3F,
-                         0x44, 0x51, 0x2F, 0x1F, 0x1F, 0x20, 0x23};
-    ST7789_WriteData(nvgamma, 14);
+#define DLIST_ARENA_WORDS (ST7789_DLIST_ARENA_SIZE / sizeof(uintptr_t))
 
-    // Set Rotation
-    ST7789_SetRotation(ST7789_ROTATION);
+static uintptr_t dlist_arena[DLIST_ARENA_WORDS];
 
-    // Inversion off
-    ST7789_WriteCommand(ST7789_INVOFF);
+// Display list being recorded or submitted
+static struct {
+    int16_t x;              // Region, clipped to the screen
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t bgcolor;       // SPI byte order
+    uint16_t used;          // Arena words in use
+    uint8_t count;          // Commands recorded
+    uint8_t active_count;   // Commands touching the current band
+    uint16_t offset[ST7789_DLIST_MAX_COMMANDS];   // Arena word of each command
+    uint8_t order[ST7789_DLIST_MAX_COMMANDS];     // Commands sorted by top row
+    uint8_t active[ST7789_DLIST_MAX_COMMANDS];    // Commands touching the band, in record order
+    uint16_t *band;         // Band pixels (region width per row)
+    int16_t top;            // First row of the band
+} dlist;
+#endif
 
-    // Normal Display Mode
-    ST7789_WriteCommand(ST7789_NORON);
-    HAL_Delay(10);
+/* ============== PRIVATE FUNCTIONS ============== */
 
-    // Display On
-    ST7789_WriteCommand(ST7789_DISPON);
-    HAL_Delay(10);
+#ifdef ST7789_USE_SPI_BUS
+/**
+ * @brief Take the shared bus (if attached) and select the panel
+ */
+static void ST7789_BusBegin(st7789_t *panel)
+{
+    if (panel->bus_dev.bus != NULL)
+    {
+        SPI_BusAcquire(&panel->bus_dev);
+    }
 
-    // Clear screen
-    ST7789_FillScreen(ST7789_BLACK);
+    PANEL_CS_LOW(panel);
 }
 
 /**
- * @brief Set display rotation
+ * @brief Deselect the panel and give the shared bus back
  */
-void ST7789_SetRotation(uint8_t rotation)
+static void ST7789_BusEnd(st7789_t *panel)
 {
-    ST7789_WriteCommand(ST7789_MADCTL);
+    PANEL_CS_HIGH(panel);
 
-    switch (rotation % 4)
+    if (panel->bus_dev.bus != NULL)
     {
-        case 0:  // Portrait
-            ST7789_WriteData8(MADCTL_MX | MADCTL_MY | MADCTL_RGB);
-            break;
-        case 1:  // Landscape
-            ST7789_WriteData8(MADCTL_MY | MADCTL_MV | MADCTL_RGB);
-            break;
-        case 2:  // Portrait Inverted
-            ST7789_WriteData8(MADCTL_RGB);
-            break;
-        case 3:  // Landscape Inverted
-            ST7789_WriteData8(MADCTL_MX | MADCTL_MV | MADCTL_RGB);
-            break;
+        SPI_BusRelease(&panel->bus_dev);
     }
 }
+#endif
 
 /**
- * @brief Invert display colors
+ * @brief Polled write of a few bytes straight to the SPI data register
+ * Avoids HAL call overhead for commands; waits until the bus is idle so DC
+ * can be toggled right after.
  */
-void ST7789_InvertDisplay(bool invert)
+static void ST7789_SpiWrite(const uint8_t *data, uint16_t len)
 {
-    ST7789_WriteCommand(invert ? ST7789_INVON : ST7789_INVOFF);
+    SPI_TypeDef *spi = st7789_current->spi->Instance;
+    uint32_t start = STATS_NOW();
+
+    if ((spi->CR1 & SPI_CR1_SPE) == 0)
+    {
+        __HAL_SPI_ENABLE(st7789_current->spi);
+    }
+
+    while (len--)
+    {
+        while ((spi->SR & SPI_SR_TXE) == 0);
+        *(volatile uint8_t*)&spi->DR = *data++;
+    }
+
+    while ((spi->SR & SPI_SR_TXE) == 0);
+    while (spi->SR & SPI_SR_BSY);
+
+    // Discard bytes clocked in while transmitting
+    __HAL_SPI_CLEAR_OVRFLAG(st7789_current->spi);
+
+    STATS_TIME(blocked_cycles, start);
 }
 
 /**
- * @brief Sleep mode control
+ * @brief Polled transfer of pixel data (CS low and DC high already)
  */
-void ST7789_Sleep(bool sleep)
+static void ST7789_SpiTransmit(const uint8_t *data, uint32_t len)
 {
-    ST7789_WriteCommand(sleep ? ST7789_SLPIN : ST7789_SLPOUT);
-    HAL_Delay(120);
+    uint32_t start = STATS_NOW();
+
+    STATS_ADD(polled_writes, 1);
+    STATS_ADD(polled_bytes, len);
+    TRACE_HOOK(TRACE_LCD_DATA, len);
+
+    while (len > 0)
+    {
+        // Even, so 16-bit frames never split
+        uint16_t chunk = (len > 65534) ? 65534 : len;
+
+        HAL_SPI_Transmit(st7789_current->spi, (uint8_t*)data, SPI_UNITS(st7789_current, chunk), HAL_MAX_DELAY);
+
+        data += chunk;
+        len -= chunk;
+    }
+
+    STATS_TIME(blocked_cycles, start);
 }
 
+#ifdef ST7789_USE_DMA
 /**
- * @brief Fill entire screen with color
+ * @brief Account for a burst giving up the bus (queue drained or yielding)
  */
-void ST7789_FillScreen(uint16_t color)
+static inline void ST7789_DmaStopped(st7789_t *panel)
 {
-    ST7789_FillRect(0, 0, ST7789_WIDTH, ST7789_HEIGHT, color);
+    #ifdef ST7789_USE_STATS
+    bus_stats.dma_cycles += PERF_Cycles() - panel->dma_start;
+    #endif
+    TRACE_HOOK(TRACE_LCD_DMA_STOP, (uint8_t)(panel->dma_head - panel->dma_tail));
+    (void)panel;
 }
 
 /**
- * @brief Fill rectangle
+ * @brief End of a burst with an empty queue: raise CS, hand the bus back, notify
  */
-void ST7789_FillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+static void ST7789_DmaFinish(st7789_t *panel)
 {
-    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
-
-    if (x + w > ST7789_WIDTH) w = ST7789_WIDTH - x;
-
-    if (y + h > ST7789_HEIGHT) h = ST7789_HEIGHT - y;
+    ST7789_DmaStopped(panel);
+    PANEL_CS_HIGH(panel);
+    panel->dma_active = false;
 
-    ST7789_SetWindow(x, y, x + w - 1, y + h - 1);
-
-    #ifdef ST7789_USE_DMA
-    // Fill buffer with color
-    for (uint16_t i = 0; i < ST7789_WIDTH * ST7789_DMA_BUFFER_LINES; i++)
+    #ifdef ST7789_USE_SPI_BUS
+    if (panel->bus_dev.bus != NULL)
     {
-        dma_buffer[i] = color;
+        SPI_BusRelease(&panel->bus_dev);
     }
+    #endif
 
-    uint32_t total_pixels = (uint32_t)w * h;
-    uint32_t buffer_pixels = ST7789_WIDTH * ST7789_DMA_BUFFER_LINES;
-
-    CS_LOW();
-    DC_HIGH();
-
-    while (total_pixels >= buffer_pixels)
+    if (panel->dma_done_cb != NULL)
     {
-        ST7789_WriteData((uint8_t*)dma_buffer, buffer_pixels * 2);
-        total_pixels -= buffer_pixels;
+        panel->dma_done_cb();
     }
+}
 
-    if (total_pixels > 0)
-    {
-        ST7789_WriteData((uint8_t*)dma_buffer, total_pixels * 2);
-    }
+/**
+ * @brief Start DMA for next chunk of the transfer at queue tail
+ * If the HAL refuses (SPI busy or in error) the queue is dropped, so that
+ * nothing waits for a completion that never comes.
+ */
+static void ST7789_DmaStart(st7789_t *panel)
+{
+    ST7789_Transfer *xfer = &panel->dma_queue[panel->dma_tail & (ST7789_DMA_QUEUE_SIZE - 1)];
 
-    CS_HIGH();
-    #else
-    uint8_t colorH = color >> 8;
-    uint8_t colorL = color & 0xFF;
-    uint32_t pixels = (uint32_t)w * h;
+    uint32_t max_chunk = 65535;
 
-    CS_LOW();
-    DC_HIGH();
+    #ifdef ST7789_USE_SPI_BUS
+    // Short chunks give waiting devices a slot; even so CS never rises mid-pixel
+    if (panel->bus_dev.bus != NULL) max_chunk = ST7789_BUS_CHUNK;
+    #endif
 
-    // Use 128-byte buffer for optimization
-    uint8_t buffer[128];
-    for (uint16_t i = 0; i < 128; i += 2)
-    {
-        buffer[i] = colorH;
-        buffer[i + 1] = colorL;
-    }
+    #ifdef ST7789_USE_SPI_16BIT
+    // Whole frames only
+    if (panel->spi_wide) max_chunk &= ~1UL;
+    #endif
 
-    while (pixels >= 64)
-    {
-        HAL_SPI_Transmit(&ST7789_SPI_PORT, buffer, 128, HAL_MAX_DELAY);
-        pixels -= 64;
-    }
+    panel->dma_chunk = (xfer->len > max_chunk) ? max_chunk : xfer->len;
+    if (HAL_SPI_Transmit_DMA(panel->spi, (uint8_t*)xfer->data,
+                             SPI_UNITS(panel, panel->dma_chunk)) == HAL_OK) return;
 
-    while (pixels--)
+    // Refused: drop what is queued, releasing the line buffers it holds
+    while (panel->dma_tail != panel->dma_head)
     {
-        HAL_SPI_Transmit(&ST7789_SPI_PORT, &colorH, 1, HAL_MAX_DELAY);
-        HAL_SPI_Transmit(&ST7789_SPI_PORT, &colorL, 1, HAL_MAX_DELAY);
+        xfer = &panel->dma_queue[panel->dma_tail & (ST7789_DMA_QUEUE_SIZE - 1)];
+        if (xfer->buffer != DMA_NO_BUFFER)
+        {
+            dma_buffer_refs[xfer->buffer]--;
+        }
+        panel->dma_tail++;
     }
 
-    CS_HIGH();
-    #endif
+    ST7789_DmaFinish(panel);
 }
 
 /**
- * @brief Draw single pixel
+ * @brief Select the panel and send the chunk at queue tail (burst start or resume)
  */
-void ST7789_DrawPixel(uint16_t x, uint16_t y, uint16_t color)
+static void ST7789_DmaBegin(st7789_t *panel)
 {
-    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
+    #ifdef ST7789_USE_STATS
+    panel->dma_start = PERF_Cycles();
+    #endif
+    TRACE_HOOK(TRACE_LCD_DMA_START, panel->dma_queue[panel->dma_tail & (ST7789_DMA_QUEUE_SIZE - 1)].len);
 
-    ST7789_SetWindow(x, y, x, y);
-    uint8_t data[] = {color >> 8, color & 0xFF};
-    ST7789_WriteData(data, 2);
+    PANEL_CS_LOW(panel);
+    PANEL_DC_HIGH(panel);
+    ST7789_DmaStart(panel);
 }
 
+#ifdef ST7789_USE_SPI_BUS
 /**
- * @brief Draw line - Bresenham's algorithm
+ * @brief Bus granted to a queued burst
  */
-void ST7789_DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color)
+static void ST7789_BusGranted(SPI_BusDevice *dev)
 {
-    int16_t steep = ABS(y1 - y0) > ABS(x1 - x0);
+    ST7789_DmaBegin((st7789_t*)dev->context);
+}
+#endif
 
-    if (steep)
+/**
+ * @brief Queue data for background transfer (DC high)
+ */
+static void ST7789_DmaEnqueue(const uint8_t *data, uint32_t len, uint8_t buffer)
+{
+    st7789_t *panel = st7789_current;
+
+    STATS_ADD(dma_transfers, 1);
+    STATS_ADD(dma_bytes, len);
+    TRACE_HOOK(TRACE_LCD_DMA_QUEUE, len);
+
+    // Wait for a free slot
+    if ((uint8_t)(panel->dma_head - panel->dma_tail) >= ST7789_DMA_QUEUE_SIZE)
     {
-        uint16_t tmp;
-        tmp = x0; x0 = y0; y0 = tmp;
-        tmp = x1; x1 = y1; y1 = tmp;
+        uint32_t start = STATS_NOW();
+        TRACE_HOOK(TRACE_LCD_WAIT, WAIT_QUEUE_SLOT);
+
+        while ((uint8_t)(panel->dma_head - panel->dma_tail) >= ST7789_DMA_QUEUE_SIZE);
+
+        STATS_TIME(blocked_cycles, start);
     }
 
-    if (x0 > x1)
+    ST7789_Transfer *xfer = &panel->dma_queue[panel->dma_head & (ST7789_DMA_QUEUE_SIZE - 1)];
+    xfer->data = data;
+    xfer->len = len;
+    xfer->buffer = buffer;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (buffer != DMA_NO_BUFFER)
     {
-        uint16_t tmp;
-        tmp = x0; x0 = x1; x1 = tmp;
-        tmp = y0; y0 = y1; y1 = tmp;
+        dma_buffer_refs[buffer]++;
     }
 
-    int16_t dx = x1 - x0;
-    int16_t dy = ABS(y1 - y0);
-    int16_t err = dx / 2;
-    int16_t ystep = (y0 < y1) ? 1 : -1;
-
-    for (; x0 <= x1; x0++)
+    panel->dma_head++;
+    if (!panel->dma_active)
     {
-        if (steep)
-        {
-            ST7789_DrawPixel(y0, x0, color);
-        }
-        else
-        {
-            ST7789_DrawPixel(x0, y0, color);
-        }
-        err -= dy;
-        if (err < 0)
+        panel->dma_active = true;
+
+        #ifdef ST7789_USE_SPI_BUS
+        // Starts here if the bus is free, otherwise once it is handed over
+        if (panel->bus_dev.bus != NULL)
         {
-            y0 += ystep;
-            err += dx;
+            SPI_BusRequest(&panel->bus_dev);
+            __set_PRIMASK(primask);
+            return;
         }
+        #endif
+
+        ST7789_DmaBegin(panel);
     }
+
+    __set_PRIMASK(primask);
 }
 
 /**
- * @brief Draw rectangle outline
+ * @brief Wait until no panel on 'hspi' (any panel if NULL) has DMA in flight
  */
-void ST7789_DrawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+static void ST7789_WaitBusIdle(const SPI_HandleTypeDef *hspi)
 {
-    ST7789_DrawLine(x, y, x + w - 1, y, color);
-    ST7789_DrawLine(x + w - 1, y, x + w - 1, y + h - 1, color);
-    ST7789_DrawLine(x + w - 1, y + h - 1, x, y + h - 1, color);
-    ST7789_DrawLine(x, y + h - 1, x, y, color);
+    for (uint8_t i = 0; i < ST7789_MAX_PANELS; i++)
+    {
+        st7789_t *panel = dma_panels[i];
+        if (panel == NULL || (hspi != NULL && panel->spi != hspi) || !panel->dma_active) continue;
+
+        uint32_t start = STATS_NOW();
+        TRACE_HOOK(TRACE_LCD_WAIT, WAIT_DMA_IDLE);
+
+        while (panel->dma_active);
+
+        STATS_TIME(blocked_cycles, start);
+    }
 }
 
 /**
- * @brief Draw circle outline - Midpoint algorithm
+ * @brief Get a line buffer that DMA is not reading, alternating between the two
  */
-void ST7789_DrawCircle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+static uint8_t ST7789_AcquireBuffer(void)
 {
-    int16_t f = 1 - r;
-    int16_t ddF_x = 1;
-    int16_t ddF_y = -2 * r;
-    int16_t x = 0;
+    uint8_t idx = dma_buffer_next;
+
+    if (dma_buffer_refs[idx] != 0 && dma_buffer_refs[idx ^ 1] == 0)
+    {
+        idx ^= 1;
+    }
+
+    if (dma_buffer_refs[idx] != 0)
+    {
+        uint32_t start = STATS_NOW();
+        TRACE_HOOK(TRACE_LCD_WAIT, WAIT_LINE_BUFFER);
+
+        while (dma_buffer_refs[idx] != 0);
+
+        STATS_TIME(blocked_cycles, start);
+    }
+
+    dma_buffer_next = idx ^ 1;
+    return idx;
+}
+
+/**
+ * @brief Get a line buffer holding at least 'pixels' of a solid color
+ */
+static uint8_t ST7789_GetFillBuffer(uint16_t color, uint32_t pixels)
+{
+    uint16_t swapped = (color >> 8) | (color << 8);
+    uint8_t idx;
+
+    if (pixels > DMA_BUFFER_PIXELS) pixels = DMA_BUFFER_PIXELS;
+
+    if (dma_buffer_fill[0] != 0 && dma_buffer_color[0] == swapped)
+    {
+        idx = 0;
+    }
+    else if (dma_buffer_fill[1] != 0 && dma_buffer_color[1] == swapped)
+    {
+        idx = 1;
+    }
+    else
+    {
+        idx = ST7789_AcquireBuffer();
+        dma_buffer_color[idx] = swapped;
+        dma_buffer_fill[idx] = 0;
+    }
+
+    // Extend cached fill; DMA only reads the part already filled
+    if (pixels > dma_buffer_fill[idx])
+    {
+        ST7789_ColorFill(&dma_buffer[idx][dma_buffer_fill[idx]], swapped, pixels - dma_buffer_fill[idx]);
+        dma_buffer_fill[idx] = pixels;
+    }
+
+    return idx;
+}
+
+/**
+ * @brief Send the first 'len' bytes of a line buffer
+ */
+static void ST7789_WriteBuffer(uint8_t idx, uint32_t len)
+{
+    if (len >= ST7789_DMA_MIN_SIZE)
+    {
+        ST7789_DmaEnqueue((const uint8_t*)dma_buffer[idx], len, idx);
+        return;
+    }
+
+    ST7789_WaitIdle();
+
+    CS_LOW();
+    DC_HIGH();
+    ST7789_SpiTransmit((const uint8_t*)dma_buffer[idx], len);
+    CS_HIGH();
+}
+#endif
+
+/**
+ * @brief Write command to ST7789
+ */
+static inline void ST7789_WriteCommand(uint8_t cmd)
+{
+    ST7789_WaitIdle();
+
+    STATS_ADD(commands, 1);
+    TRACE_HOOK(TRACE_LCD_COMMAND, cmd);
+
+    CS_LOW();
+    DC_LOW();
+    ST7789_SpiWrite(&cmd, 1);
+    CS_HIGH();
+}
+
+/**
+ * @brief Write single byte data
+ */
+static inline void ST7789_WriteData8(uint8_t data)
+{
+    ST7789_WaitIdle();
+
+    STATS_ADD(polled_writes, 1);
+    STATS_ADD(polled_bytes, 1);
+
+    CS_LOW();
+    DC_HIGH();
+    ST7789_SpiWrite(&data, 1);
+    CS_HIGH();
+}
+
+#if !defined(ST7789_USE_DMA) || defined(ST7789_USE_FRAMEBUFFER) || defined(ST7789_USE_GLYPH_CACHE)
+/**
+ * @brief Write bulk data with DMA support
+ * With DMA, large writes are queued and return immediately: data must stay
+ * valid until the queue drains (see ST7789_WaitIdle).
+ */
+static void ST7789_WriteData(const uint8_t *data, size_t len)
+{
+    #ifdef ST7789_USE_DMA
+    if (len >= ST7789_DMA_MIN_SIZE)
+    {
+        ST7789_DmaEnqueue(data, len, DMA_NO_BUFFER);
+        return;
+    }
+
+    // Small writes go out blocking, after anything already queued
+    ST7789_WaitIdle();
+    #endif
+
+    CS_LOW();
+    DC_HIGH();
+    ST7789_SpiTransmit(data, len);
+    CS_HIGH();
+}
+#endif
+
+/**
+ * @brief Number of commands in an encoded list of 'size' bytes
+ */
+static uint8_t ST7789_CommandCount(const uint8_t *list, size_t size)
+{
+    const uint8_t *end = list + size;
+    uint8_t count = 0;
+
+    while (list < end)
+    {
+        uint8_t argc = list[1];
+
+        list += 2 + (argc & ~CMD_DELAY) + ((argc & CMD_DELAY) ? 1 : 0);
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Send command list in one CS assertion, toggling DC per byte group
+ * @param list Encoded as: cmd, argc [| CMD_DELAY], args..., [delay ms]
+ * @param count Number of commands in list
+ */
+static void ST7789_SendCommandList(const uint8_t *list, uint8_t count)
+{
+    ST7789_WaitIdle();
+
+    CS_LOW();
+
+    while (count--)
+    {
+        uint8_t argc = list[1];
+
+        STATS_ADD(commands, 1);
+        STATS_ADD(polled_bytes, argc & ~CMD_DELAY);
+        TRACE_HOOK(TRACE_LCD_COMMAND, list[0]);
+
+        DC_LOW();
+        ST7789_SpiWrite(list, 1);
+        list += 2;
+
+        if (argc & ~CMD_DELAY)
+        {
+            DC_HIGH();
+            ST7789_SpiWrite(list, argc & ~CMD_DELAY);
+            list += argc & ~CMD_DELAY;
+        }
+
+        if (argc & CMD_DELAY)
+        {
+            HAL_Delay(*list++);
+        }
+    }
+
+    CS_HIGH();
+}
+
+/**
+ * @brief First frame memory row of screen lines [start, start + count) on the scan axis
+ */
+static uint16_t ST7789_GramRow(uint16_t start, uint16_t count)
+{
+    // MY set: lines run bottom-up through frame memory
+    if (IS_MIRROR_Y()) return ST7789_GRAM_ROWS - (start + ST7789_SCAN_SHIFT + count);
+
+    return start + ST7789_SCAN_SHIFT;
+}
+
+/**
+ * @brief Line period RTN (and divider) for the closest frame rate not above 'hz'
+ */
+static uint8_t ST7789_FrameRateRtn(uint8_t hz, uint8_t *div)
+{
+    uint8_t d = 0;
+    uint32_t clocks = ST7789_FR_LINE_CLOCKS / (hz ? hz : 1);
+
+    // Rates below the slowest RTN need the divider (idle/partial modes only)
+    while (div != NULL && d < ST7789_FR_DIV_MAX && clocks > 250 + 16 * ST7789_FR_RTN_MAX)
+    {
+        d++;
+        clocks >>= 1;
+    }
+
+    if (div != NULL) *div = d;
+
+    if (clocks <= 250) return 0;
+
+    uint32_t rtn = (clocks - 250 + 15) / 16;
+    return (rtn > ST7789_FR_RTN_MAX) ? ST7789_FR_RTN_MAX : rtn;
+}
+
+/**
+ * @brief Frame rate produced by RTN and divider
+ */
+static uint8_t ST7789_FrameRateHz(uint8_t rtn, uint8_t div)
+{
+    return ST7789_FR_LINE_CLOCKS / ((250UL + 16 * rtn) << div);
+}
+
+#ifdef ST7789_USE_POWER_MANAGER
+/**
+ * @brief Note drawing activity, leaving idle first if needed
+ */
+static void ST7789_PowerActivity(void)
+{
+    st7789_current->power.last_activity = HAL_GetTick();
+
+    if (!st7789_current->power.idle) return;
+    st7789_current->power.idle = false;
+
+    const uint8_t list[] = {
+        ST7789_IDMOFF, 0,
+        ST7789_FRCTRL2, 1, st7789_current->frame_rtna,
+    };
+    ST7789_SendCommandList(list, 2);
+}
+#endif
+
+/**
+ * @brief Encode CASET/RASET/RAMWR, skipping ranges that did not change
+ * @return Number of commands written to list
+ */
+static uint8_t ST7789_EncodeWindow(uint8_t *list, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+    uint8_t count = 0;
+
+    #ifdef ST7789_USE_POWER_MANAGER
+    ST7789_PowerActivity();
+    #endif
+
+    x0 += ST7789_X_SHIFT;
+    x1 += ST7789_X_SHIFT;
+    y0 += ST7789_Y_SHIFT;
+    y1 += ST7789_Y_SHIFT;
+
+    // Column Address Set
+    if (!st7789_current->window.valid || x0 != st7789_current->window.x0 || x1 != st7789_current->window.x1)
+    {
+        *list++ = ST7789_CASET;
+        *list++ = 4;
+        *list++ = x0 >> 8;
+        *list++ = x0 & 0xFF;
+        *list++ = x1 >> 8;
+        *list++ = x1 & 0xFF;
+        count++;
+    }
+
+    // Row Address Set
+    if (!st7789_current->window.valid || y0 != st7789_current->window.y0 || y1 != st7789_current->window.y1)
+    {
+        *list++ = ST7789_RASET;
+        *list++ = 4;
+        *list++ = y0 >> 8;
+        *list++ = y0 & 0xFF;
+        *list++ = y1 >> 8;
+        *list++ = y1 & 0xFF;
+        count++;
+    }
+
+    st7789_current->window.x0 = x0;
+    st7789_current->window.x1 = x1;
+    st7789_current->window.y0 = y0;
+    st7789_current->window.y1 = y1;
+    st7789_current->window.valid = true;
+
+    STATS_ADD(windows, 1);
+    STATS_ADD(window_commands, count);
+    TRACE_HOOK(TRACE_LCD_WINDOW, (uint32_t)(x1 - x0 + 1) << 12 | (y1 - y0 + 1));
+
+    // Write to RAM (restarts at window origin)
+    *list++ = ST7789_RAMWR;
+    *list++ = 0;
+    count++;
+
+    return count;
+}
+
+/**
+ * @brief Set drawing window
+ */
+static void ST7789_SetWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+    uint8_t list[16];
+    uint8_t count = ST7789_EncodeWindow(list, x0, y0, x1, y1);
+
+    ST7789_SendCommandList(list, count);
+}
+
+#ifdef ST7789_USE_READBACK
+/**
+ * @brief Polled receive at the read clock (CS low already)
+ * The panel drives SDO at most every 150 ns, well below the write clock.
+ */
+static void ST7789_SpiRead(uint8_t *data, uint16_t len)
+{
+    SPI_HandleTypeDef *hspi = st7789_current->spi;
+    uint32_t cr1 = hspi->Instance->CR1;
+    uint32_t start = STATS_NOW();
+
+    // BR may only change while the peripheral is disabled
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Instance->CR1 = (cr1 & ~(SPI_CR1_BR | SPI_CR1_SPE)) | (ST7789_READ_PRESCALER & SPI_CR1_BR);
+
+    HAL_SPI_Receive(hspi, data, len, HAL_MAX_DELAY);
+
+    while (hspi->Instance->SR & SPI_SR_BSY);
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Instance->CR1 = cr1;
+
+    STATS_TIME(blocked_cycles, start);
+}
+
+/**
+ * @brief Read 'count' pixels of a window (RAMRD) into dst
+ * Frame memory comes back as 18-bit R, G, B bytes (color in the top 6 bits)
+ * after ST7789_RAMRD_DUMMY_BITS dummy clocks, whatever COLMOD says.
+ */
+static void ST7789_ReadWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t *dst, uint32_t count)
+{
+    const uint8_t shift = ST7789_RAMRD_DUMMY_BITS % 8;
+    uint8_t rx[READ_CHUNK_PIXELS * 3];
+    uint8_t list[16];
+    uint8_t carry = 0;
+
+    // Window commands only, RAMRD has to keep CS low while the data comes back
+    uint8_t commands = ST7789_EncodeWindow(list, x0, y0, x1, y1) - 1;
+    if (commands > 0)
+    {
+        ST7789_SendCommandList(list, commands);
+    }
+    else
+    {
+        ST7789_WaitIdle();
+    }
+
+    uint8_t cmd = ST7789_RAMRD;
+
+    STATS_ADD(commands, 1);
+    TRACE_HOOK(TRACE_LCD_COMMAND, cmd);
+
+    CS_LOW();
+    DC_LOW();
+    ST7789_SpiWrite(&cmd, 1);
+    DC_HIGH();
+
+    // Whole dummy bytes, plus the byte that starts the data when the dummy count is not a multiple of 8
+    uint8_t skip = ST7789_RAMRD_DUMMY_BITS / 8 + (shift != 0);
+    if (skip > 0)
+    {
+        ST7789_SpiRead(rx, skip);
+        carry = rx[skip - 1];
+    }
+
+    while (count > 0)
+    {
+        uint32_t n = (count > READ_CHUNK_PIXELS) ? READ_CHUNK_PIXELS : count;
+
+        ST7789_SpiRead(rx, n * 3);
+
+        if (shift != 0)
+        {
+            for (uint32_t i = 0; i < n * 3; i++)
+            {
+                uint8_t b = rx[i];
+                rx[i] = (carry << shift) | (b >> (8 - shift));
+                carry = b;
+            }
+        }
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            *dst++ = ST7789_Color565(rx[i * 3], rx[i * 3 + 1], rx[i * 3 + 2]);
+        }
+
+        count -= n;
+    }
+
+    CS_HIGH();
+}
+#endif
+
+/**
+ * @brief Hardware reset (false if the panel has no reset pin)
+ */
+static bool ST7789_HardReset(void)
+{
+    if (st7789_current->rst_port == NULL) return false;
+
+    // Low pulse of at least 10 us
+    RST_LOW();
+    HAL_Delay(1);
+    RST_HIGH();
+
+    return true;
+}
+
+/**
+ * @brief Draw the first frame: the splash callback, or a black screen
+ */
+static void ST7789_DrawSplash(void)
+{
+    if (st7789_current->splash != NULL)
+    {
+        st7789_current->splash();
+        return;
+    }
+
+    ST7789_FillScreen(ST7789_BLACK);
+}
+
+#ifdef ST7789_USE_SPI_16BIT
+/**
+ * @brief Switch the SPI and its TX DMA between 8- and 16-bit frames
+ * Waits for queued transfers: commands always go out as 8-bit frames.
+ */
+static void ST7789_SetFrameSize(bool wide)
+{
+    SPI_HandleTypeDef *hspi = st7789_current->spi;
+
+    if (st7789_current->spi_wide == wide) return;
+
+    ST7789_WaitIdle();
+    while (hspi->Instance->SR & SPI_SR_BSY);
+
+    // DFF may only change while the peripheral is disabled
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Init.DataSize = wide ? SPI_DATASIZE_16BIT : SPI_DATASIZE_8BIT;
+    hspi->Instance->CR1 = (hspi->Instance->CR1 & ~SPI_CR1_DFF) | (wide ? SPI_CR1_DFF : 0);
+
+    #ifdef ST7789_USE_DMA
+    DMA_HandleTypeDef *hdma = hspi->hdmatx;
+    hdma->Init.PeriphDataAlignment = wide ? DMA_PDATAALIGN_HALFWORD : DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment = wide ? DMA_MDATAALIGN_HALFWORD : DMA_MDATAALIGN_BYTE;
+    #ifdef DMA_SxCR_PSIZE
+    // F2/F4 stream (disabled between transfers, so CR may be written)
+    hdma->Instance->CR = (hdma->Instance->CR & ~(DMA_SxCR_PSIZE | DMA_SxCR_MSIZE)) |
+                         hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment;
+    #else
+    // F1 channel
+    hdma->Instance->CCR = (hdma->Instance->CCR & ~(DMA_CCR_PSIZE | DMA_CCR_MSIZE)) |
+                          hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment;
+    #endif
+    #endif
+
+    st7789_current->spi_wide = wide;
+}
+#endif
+
+/**
+ * @brief Fill rectangle given by inclusive corners, clipped
+ */
+static void ST7789_FillClipped(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint16_t color)
+{
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= ST7789_WIDTH) x1 = ST7789_WIDTH - 1;
+    if (y1 >= ST7789_HEIGHT) y1 = ST7789_HEIGHT - 1;
+
+    if (x0 > x1 || y0 > y1) return;
+
+    ST7789_FillRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, color);
+}
+
+/**
+ * @brief Draw one horizontal span from x_left to x_right (inclusive), clipped
+ */
+static void ST7789_DrawSpan(int32_t x_left, int32_t x_right, int32_t y, uint16_t color)
+{
+    ST7789_FillClipped(x_left, y, x_right, y, color);
+}
+
+/**
+ * @brief Draw one vertical span from y_top to y_bottom (inclusive), clipped
+ */
+static void ST7789_DrawVSpan(int32_t x, int32_t y_top, int32_t y_bottom, uint16_t color)
+{
+    ST7789_FillClipped(x, y_top, x, y_bottom, color);
+}
+
+/**
+ * @brief Send a span of individually colored pixels as one window
+ */
+static void ST7789_SpanFlush(ST7789_Span *span)
+{
+    if (span->len == 0) return;
+
+    uint16_t w = span->vertical ? 1 : span->len;
+    uint16_t h = span->vertical ? span->len : 1;
+
+    if (ST7789_BlitBegin(span->x, span->y, w, h, ST7789_ORDER_SPI))
+    {
+        ST7789_BlitWrite(span->pixels, span->len);
+    }
+    ST7789_BlitEnd();
+
+    span->len = 0;
+}
+
+/**
+ * @brief Append a pixel, starting a new span if it does not continue the current one
+ */
+static void ST7789_SpanPut(ST7789_Span *span, int32_t x, int32_t y, uint16_t pixel)
+{
+    if (span->len > 0)
+    {
+        bool next = span->vertical ? (x == span->x && y == span->y + span->len)
+                                   : (y == span->y && x == span->x + span->len);
+
+        if (!next || span->len == SPAN_PIXELS) ST7789_SpanFlush(span);
+    }
+
+    if (span->len == 0)
+    {
+        span->x = x;
+        span->y = y;
+    }
+
+    span->pixels[span->len++] = pixel;
+}
+
+/**
+ * @brief Integer square root
+ */
+static uint32_t ST7789_Sqrt(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > v) bit >>= 2;
+
+    for (; bit != 0; bit >>= 2)
+    {
+        if (v >= root + bit)
+        {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+    }
+
+    return (uint32_t)root;
+}
+
+/**
+ * @brief Floor of a / 256 for 24.8 fixed point
+ */
+static inline int32_t ST7789_FloorQ8(int32_t a)
+{
+    return (a >= 0) ? a / 256 : -((255 - a) / 256);
+}
+
+/**
+ * @brief Fill convex polygon (24.8 fixed point corners, pixel centers at +0.5)
+ * Pixels whose centers lie inside are filled, one span per row.
+ */
+static void ST7789_FillConvex(const int32_t *xs, const int32_t *ys, uint8_t n, uint16_t color)
+{
+    int32_t ymin = ys[0], ymax = ys[0];
+
+    for (uint8_t i = 1; i < n; i++)
+    {
+        if (ys[i] < ymin) ymin = ys[i];
+        if (ys[i] > ymax) ymax = ys[i];
+    }
+
+    // Rows whose center lies in [ymin, ymax)
+    int32_t row0 = ST7789_FloorQ8(ymin - 128 + 255);
+    int32_t row1 = ST7789_FloorQ8(ymax - 128 + 255) - 1;
+
+    if (row0 < 0) row0 = 0;
+    if (row1 >= ST7789_HEIGHT) row1 = ST7789_HEIGHT - 1;
+
+    for (int32_t row = row0; row <= row1; row++)
+    {
+        int32_t yc = row * 256 + 128;
+        int32_t xl = INT32_MAX, xr = INT32_MIN;
+
+        for (uint8_t i = 0; i < n; i++)
+        {
+            uint8_t j = (i + 1 == n) ? 0 : i + 1;
+            int32_t ya = ys[i], yb = ys[j];
+
+            // Half-open edges: a row through a shared corner counts once
+            if ((ya <= yc && yc < yb) || (yb <= yc && yc < ya))
+            {
+                int32_t x = xs[i] + (int32_t)((int64_t)(xs[j] - xs[i]) * (yc - ya) / (yb - ya));
+
+                if (x < xl) xl = x;
+                if (x > xr) xr = x;
+            }
+        }
+
+        if (xl > xr) continue;
+
+        // Columns whose center lies in [xl, xr)
+        ST7789_DrawSpan(ST7789_FloorQ8(xl - 128 + 255), ST7789_FloorQ8(xr - 128 + 255) - 1, row, color);
+    }
+}
+
+/**
+ * @brief Sine of an angle in degrees (Q14, Bhaskara approximation, error < 0.002)
+ */
+static int32_t ST7789_SinQ14(int32_t deg)
+{
+    deg %= 360;
+    if (deg < 0) deg += 360;
+
+    int32_t sign = 1;
+    if (deg >= 180)
+    {
+        deg -= 180;
+        sign = -1;
+    }
+
+    int32_t p = deg * (180 - deg);
+
+    return sign * ((4 * p) << 14) / (40500 - p);
+}
+
+/**
+ * @brief Half-width of a circle row dy away from the center (dy <= r)
+ * Same inside rule as the arcs: x^2 + y^2 <= r^2 + r.
+ */
+static inline int32_t ST7789_CircleHalfWidth(uint32_t r, uint32_t dy)
+{
+    return ST7789_Sqrt(r * r + r - dy * dy);
+}
+
+/**
+ * @brief Emit a circle outline run [xa, xb] at offset y in all eight octants
+ */
+static void ST7789_CircleRuns(int32_t x0, int32_t y0, int32_t xa, int32_t xb, int32_t y, uint16_t color)
+{
+    // Top and bottom: horizontal runs; left and right: the same runs transposed
+    if (xa == 0)
+    {
+        ST7789_DrawSpan(x0 - xb, x0 + xb, y0 + y, color);
+        ST7789_DrawSpan(x0 - xb, x0 + xb, y0 - y, color);
+        ST7789_DrawVSpan(x0 + y, y0 - xb, y0 + xb, color);
+        ST7789_DrawVSpan(x0 - y, y0 - xb, y0 + xb, color);
+        return;
+    }
+
+    ST7789_DrawSpan(x0 + xa, x0 + xb, y0 + y, color);
+    ST7789_DrawSpan(x0 - xb, x0 - xa, y0 + y, color);
+    ST7789_DrawSpan(x0 + xa, x0 + xb, y0 - y, color);
+    ST7789_DrawSpan(x0 - xb, x0 - xa, y0 - y, color);
+    ST7789_DrawVSpan(x0 + y, y0 + xa, y0 + xb, color);
+    ST7789_DrawVSpan(x0 + y, y0 - xb, y0 - xa, color);
+    ST7789_DrawVSpan(x0 - y, y0 + xa, y0 + xb, color);
+    ST7789_DrawVSpan(x0 - y, y0 - xb, y0 - xa, color);
+}
+
+/**
+ * @brief Set up a triangle edge (ya < yb) and advance it to row y
+ *
+ * The value at a row depends only on the endpoints and the row, so edges
+ * shared by adjacent triangles land on exactly the same x.
+ */
+static void ST7789_EdgeInit(ST7789_Edge *edge, int32_t xa, int32_t ya,
+                            int32_t xb, int32_t yb, int32_t y)
+{
+    edge->step = (int64_t)(xb - xa) * 65536 / (yb - ya);
+    edge->x = (int64_t)xa * 65536 + edge->step * (y - ya);
+}
+
+#ifdef ST7789_USE_FRAMEBUFFER
+/**
+ * @brief Clip rows to the band held in RAM
+ * @return false if nothing is left
+ */
+static bool ST7789_FbClip(uint16_t *y, uint16_t *h)
+{
+    uint16_t y0 = *y;
+    uint16_t y1 = *y + *h;
+
+    if (y0 < fb_band_y) y0 = fb_band_y;
+    if (y1 > fb_band_y + FB_LINES) y1 = fb_band_y + FB_LINES;
+    if (y0 >= y1) return false;
+
+    *y = y0;
+    *h = y1 - y0;
+    return true;
+}
+
+/**
+ * @brief Pointer to pixel in framebuffer (screen coordinates)
+ */
+static inline uint16_t *ST7789_FbPixel(uint16_t x, uint16_t y)
+{
+    return &framebuffer[(uint32_t)(y - fb_band_y) * ST7789_WIDTH + x];
+}
+
+/**
+ * @brief Area of rectangle in pixels
+ */
+static inline uint32_t ST7789_RectArea(const ST7789_Rect *r)
+{
+    return (uint32_t)(r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+/**
+ * @brief Bounding box of two rectangles
+ */
+static ST7789_Rect ST7789_RectUnion(const ST7789_Rect *a, const ST7789_Rect *b)
+{
+    ST7789_Rect u;
+
+    u.x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+    u.y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+    u.x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+    u.y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+
+    return u;
+}
+
+/**
+ * @brief Add rectangle to dirty list, merging when it costs no extra pixels
+ */
+static void ST7789_FbMarkDirty(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    ST7789_Rect r = {x, y, x + w - 1, y + h - 1};
+    bool merged = true;
+
+    // Merge repeatedly: a grown rectangle may now absorb others
+    while (merged)
+    {
+        merged = false;
+
+        for (uint8_t i = 0; i < fb_dirty_count; i++)
+        {
+            ST7789_Rect u = ST7789_RectUnion(&r, &fb_dirty[i]);
+
+            if (ST7789_RectArea(&u) <= ST7789_RectArea(&r) + ST7789_RectArea(&fb_dirty[i]))
+            {
+                r = u;
+                fb_dirty[i] = fb_dirty[--fb_dirty_count];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (fb_dirty_count < ST7789_FB_MAX_DIRTY)
+    {
+        fb_dirty[fb_dirty_count++] = r;
+        return;
+    }
+
+    // List full: merge with the rectangle that grows the least
+    uint8_t best = 0;
+    uint32_t best_growth = UINT32_MAX;
+
+    for (uint8_t i = 0; i < fb_dirty_count; i++)
+    {
+        ST7789_Rect u = ST7789_RectUnion(&r, &fb_dirty[i]);
+        uint32_t growth = ST7789_RectArea(&u) - ST7789_RectArea(&fb_dirty[i]);
+
+        if (growth < best_growth)
+        {
+            best_growth = growth;
+            best = i;
+        }
+    }
+
+    fb_dirty[best] = ST7789_RectUnion(&r, &fb_dirty[best]);
+}
+
+/**
+ * @brief Fill rectangle in framebuffer (x/w already clipped to screen)
+ */
+static void ST7789_FbFill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    if (!ST7789_FbClip(&y, &h)) return;
+
+    // Previous flush may still be reading the framebuffer
+    ST7789_WaitIdle();
+
+    uint16_t swapped = (color >> 8) | (color << 8);
+
+    for (uint16_t row = 0; row < h; row++)
+    {
+        ST7789_ColorFill(ST7789_FbPixel(x, y + row), swapped, w);
+    }
+
+    ST7789_FbMarkDirty(x, y, w, h);
+}
+#endif
+
+/**
+ * @brief Copy pixels, optionally swapping bytes
+ */
+static inline void ST7789_CopyPixels(uint16_t *dst, const uint16_t *src, uint32_t count, bool swap)
+{
+    if (!swap)
+    {
+        memcpy(dst, src, count * 2);
+        return;
+    }
+
+    // Two pixels per word
+    uint32_t i = 0;
+
+    for (; i + 1 < count; i += 2)
+    {
+        uint32_t pair;
+
+        memcpy(&pair, &src[i], 4);
+        pair = __REV16(pair);
+        memcpy(&dst[i], &pair, 4);
+    }
+
+    if (i < count) dst[i] = (src[i] >> 8) | (src[i] << 8);
+}
+
+/**
+ * @brief Copy image pixels, swapping bytes for native-order sources
+ */
+static inline void ST7789_BlitCopy(uint16_t *dst, const uint16_t *src, uint32_t count)
+{
+    ST7789_CopyPixels(dst, src, count, blit.swap);
+}
+
+/**
+ * @brief Send visible image pixels starting at source column 'col'
+ * With the framebuffer the pixels belong to one source row; otherwise
+ * they simply continue the address window.
+ */
+static void ST7789_BlitEmit(uint16_t col, const uint16_t *src, uint32_t count)
+{
+    #ifdef ST7789_USE_FRAMEBUFFER
+    uint16_t y = blit.y + blit.row;
+    uint16_t h = 1;
+
+    if (!ST7789_FbClip(&y, &h)) return;
+
+    ST7789_BlitCopy(ST7789_FbPixel(blit.x + col, y), src, count);
+    #elif defined(ST7789_USE_DMA)
+    (void)col;
+
+    // Pack into line buffers; a full one goes out while the next fills
+    while (count > 0)
+    {
+        if (blit.buffer == DMA_NO_BUFFER)
+        {
+            blit.buffer = ST7789_AcquireBuffer();
+            dma_buffer_fill[blit.buffer] = 0;
+            blit.fill = 0;
+        }
+
+        uint32_t chunk = DMA_BUFFER_PIXELS - blit.fill;
+        if (chunk > count) chunk = count;
+
+        ST7789_BlitCopy(&dma_buffer[blit.buffer][blit.fill], src, chunk);
+        blit.fill += chunk;
+        src += chunk;
+        count -= chunk;
+
+        if (blit.fill == DMA_BUFFER_PIXELS)
+        {
+            ST7789_WriteBuffer(blit.buffer, blit.fill * 2);
+            blit.buffer = DMA_NO_BUFFER;
+        }
+    }
+    #else
+    (void)col;
+
+    if (!blit.swap)
+    {
+        #ifdef ST7789_USE_SPI_16BIT
+        if (st7789_current->spi_wide)
+        {
+            CS_LOW();
+            DC_HIGH();
+            ST7789_SpiTransmit((const uint8_t*)src, count * 2);
+            CS_HIGH();
+            return;
+        }
+        #endif
+
+        ST7789_WriteData((const uint8_t*)src, count * 2);
+        return;
+    }
+
+    // Swap through a small stack buffer
+    uint16_t swapped[32];
+
+    while (count > 0)
+    {
+        uint32_t chunk = (count > 32) ? 32 : count;
+
+        ST7789_BlitCopy(swapped, src, chunk);
+        ST7789_WriteData((const uint8_t*)swapped, chunk * 2);
+        src += chunk;
+        count -= chunk;
+    }
+    #endif
+}
+
+/**
+ * @brief Read one index (bpp 8) or color (bpp 16) from the RLE stream
+ */
+static inline uint16_t ST7789_DecodeValue(void)
+{
+    uint16_t value;
+
+    if (decoder.image->bpp == 16)
+    {
+        // High byte first in the stream, kept in SPI order in memory
+        memcpy(&value, decoder.data, 2);
+        decoder.data += 2;
+    }
+    else
+    {
+        value = *decoder.data++;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Load the next RLE token
+ */
+static void ST7789_DecodeToken(void)
+{
+    uint8_t bpp = decoder.image->bpp;
+    uint8_t token = *decoder.data++;
+
+    if (bpp < 8)
+    {
+        decoder.value = token >> (8 - bpp);
+        decoder.run = (token & ((1u << (8 - bpp)) - 1)) + 1;
+        decoder.literal = false;
+    }
+    else
+    {
+        decoder.run = (token & 0x7F) + 1;
+        decoder.literal = !(token & 0x80);
+        if (!decoder.literal) decoder.value = ST7789_DecodeValue();
+    }
+}
+
+/**
+ * @brief Map an index or color from the stream to a pixel (SPI order)
+ */
+static inline uint16_t ST7789_DecodeColor(uint16_t value)
+{
+    const ST7789_Image *image = decoder.image;
+
+    if (image->bpp == 16) return value;
+
+    return (value < image->colors) ? image->palette[value] : 0;
+}
+
+/**
+ * @brief Skip pixels without expanding them
+ */
+static void ST7789_DecodeSkip(uint32_t count)
+{
+    if (!(decoder.image->flags & ST7789_IMAGE_RLE))
+    {
+        decoder.pos += count;
+        return;
+    }
+
+    while (count > 0)
+    {
+        if (decoder.run == 0) ST7789_DecodeToken();
+
+        uint32_t n = (decoder.run < count) ? decoder.run : count;
+
+        if (decoder.literal) decoder.data += n * (decoder.image->bpp / 8);
+        decoder.run -= n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief Expand the next pixels into dst (SPI order)
+ */
+static void ST7789_DecodeExpand(uint16_t *dst, uint32_t count)
+{
+    const ST7789_Image *image = decoder.image;
+
+    if (image->flags & ST7789_IMAGE_RLE)
+    {
+        while (count > 0)
+        {
+            if (decoder.run == 0) ST7789_DecodeToken();
+
+            uint32_t n = (decoder.run < count) ? decoder.run : count;
+
+            decoder.run -= n;
+            count -= n;
+
+            if (decoder.literal)
+            {
+                while (n--) *dst++ = ST7789_DecodeColor(ST7789_DecodeValue());
+            }
+            else
+            {
+                uint16_t color = ST7789_DecodeColor(decoder.value);
+                while (n--) *dst++ = color;
+            }
+        }
+        return;
+    }
+
+    if (image->bpp == 16)
+    {
+        memcpy(dst, image->data + decoder.pos * 2, count * 2);
+        decoder.pos += count;
+        return;
+    }
+
+    // Packed indices, rows start on a byte boundary
+    uint8_t bpp = image->bpp;
+    uint8_t mask = (1u << bpp) - 1;
+    uint32_t stride = ((uint32_t)image->width * bpp + 7) / 8;
+
+    while (count > 0)
+    {
+        uint32_t row = decoder.pos / image->width;
+        uint32_t col = decoder.pos % image->width;
+        uint32_t n = image->width - col;
+        if (n > count) n = count;
+
+        const uint8_t *src = image->data + row * stride;
+        uint32_t bit = col * bpp;
+
+        decoder.pos += n;
+        count -= n;
+
+        while (n--)
+        {
+            uint8_t index = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & mask;
+            *dst++ = ST7789_DecodeColor(index);
+            bit += bpp;
+        }
+    }
+}
+
+/**
+ * @brief Decode visible image pixels starting at source column 'col'
+ * Same destinations as ST7789_BlitEmit, without an intermediate copy.
+ */
+static void ST7789_DecodeEmit(uint16_t col, uint32_t count)
+{
+    #ifdef ST7789_USE_FRAMEBUFFER
+    uint16_t y = blit.y + blit.row;
+    uint16_t h = 1;
+
+    if (!ST7789_FbClip(&y, &h))
+    {
+        ST7789_DecodeSkip(count);
+        return;
+    }
+
+    ST7789_DecodeExpand(ST7789_FbPixel(blit.x + col, y), count);
+    #elif defined(ST7789_USE_DMA)
+    (void)col;
+
+    while (count > 0)
+    {
+        if (blit.buffer == DMA_NO_BUFFER)
+        {
+            blit.buffer = ST7789_AcquireBuffer();
+            dma_buffer_fill[blit.buffer] = 0;
+            blit.fill = 0;
+        }
+
+        uint32_t chunk = DMA_BUFFER_PIXELS - blit.fill;
+        if (chunk > count) chunk = count;
+
+        ST7789_DecodeExpand(&dma_buffer[blit.buffer][blit.fill], chunk);
+        blit.fill += chunk;
+        count -= chunk;
+
+        if (blit.fill == DMA_BUFFER_PIXELS)
+        {
+            ST7789_WriteBuffer(blit.buffer, blit.fill * 2);
+            blit.buffer = DMA_NO_BUFFER;
+        }
+    }
+    #else
+    (void)col;
+
+    uint16_t pixels[32];
+
+    while (count > 0)
+    {
+        uint32_t chunk = (count > 32) ? 32 : count;
+
+        ST7789_DecodeExpand(pixels, chunk);
+        ST7789_WriteData((const uint8_t*)pixels, chunk * 2);
+        count -= chunk;
+    }
+    #endif
+}
+
+#ifdef ST7789_USE_DLIST
+/**
+ * @brief Command number 'i' of the display list
+ */
+static inline ST7789_DListCmd *ST7789_DListGet(uint8_t i)
+{
+    return (ST7789_DListCmd*)&dlist_arena[dlist.offset[i]];
+}
+
+/**
+ * @brief Record a command with bounds [x0, x1] x [y0, y1] and 'extra' trailing bytes
+ * @param out Set to the new command, NULL if it lies outside the region
+ * @return false if the list is full
+ */
+static bool ST7789_DListAdd(ST7789_DListCmd **out, uint8_t type, int32_t x0, int32_t y0,
+                            int32_t x1, int32_t y1, uint16_t color, uint32_t extra)
+{
+    *out = NULL;
+
+    if (x0 < dlist.x) x0 = dlist.x;
+    if (y0 < dlist.y) y0 = dlist.y;
+    if (x1 > dlist.x + dlist.w - 1) x1 = dlist.x + dlist.w - 1;
+    if (y1 > dlist.y + dlist.h - 1) y1 = dlist.y + dlist.h - 1;
+
+    if (x0 > x1 || y0 > y1) return true;
+
+    uint32_t words = (sizeof(ST7789_DListCmd) + extra + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+
+    if (dlist.count >= ST7789_DLIST_MAX_COMMANDS || dlist.used + words > DLIST_ARENA_WORDS) return false;
+
+    ST7789_DListCmd *cmd = (ST7789_DListCmd*)&dlist_arena[dlist.used];
+    dlist.offset[dlist.count++] = dlist.used;
+    dlist.used += words;
+
+    cmd->type = type;
+    cmd->flags = 0;
+    cmd->color = (color >> 8) | (color << 8);
+    cmd->x0 = x0;
+    cmd->y0 = y0;
+    cmd->x1 = x1;
+    cmd->y1 = y1;
+    cmd->data = NULL;
+
+    *out = cmd;
+    return true;
+}
+
+/**
+ * @brief Band pixel at screen (x, row)
+ */
+static inline uint16_t *ST7789_DListPixel(int32_t x, int32_t row)
+{
+    return &dlist.band[(row - dlist.top) * dlist.w + (x - dlist.x)];
+}
+
+/**
+ * @brief Fill columns [xa, xb] of a band row, clipped to the command bounds
+ */
+static void ST7789_DListSpan(const ST7789_DListCmd *cmd, int32_t xa, int32_t xb, int32_t row)
+{
+    if (xa < cmd->x0) xa = cmd->x0;
+    if (xb > cmd->x1) xb = cmd->x1;
+    if (xa > xb) return;
+
+    ST7789_ColorFill(ST7789_DListPixel(xa, row), cmd->color, xb - xa + 1);
+}
+
+/**
+ * @brief Last major-axis step of line run k (Bresenham as in ST7789_DrawLine)
+ */
+static inline int32_t ST7789_DListRunEnd(const ST7789_DListCmd *cmd, int32_t k)
+{
+    int32_t end = (cmd->c / 2 + k * cmd->c) / cmd->d;
+
+    return (end > cmd->c) ? cmd->c : end;
+}
+
+/**
+ * @brief Rasterize the rows of a line inside [row0, row1]
+ * The runs are computed directly from their index, so the band does not
+ * depend on the rows before it.
+ */
+static void ST7789_DListLine(const ST7789_DListCmd *cmd, int32_t row0, int32_t row1)
+{
+    int32_t step = (cmd->flags & DLIST_UP) ? -1 : 1;
+
+    if (!(cmd->flags & DLIST_STEEP))
+    {
+        // One horizontal run per row
+        int32_t k0 = (row0 - cmd->b) * step;
+        int32_t k1 = (row1 - cmd->b) * step;
+
+        if (k0 > k1)
+        {
+            int32_t tmp = k0;
+            k0 = k1;
+            k1 = tmp;
+        }
+
+        if (k0 < 0) k0 = 0;
+        if (k1 > cmd->d) k1 = cmd->d;
+
+        for (int32_t k = k0; k <= k1; k++)
+        {
+            int32_t start = (k == 0) ? 0 : ST7789_DListRunEnd(cmd, k - 1) + 1;
+
+            ST7789_DListSpan(cmd, cmd->a + start, cmd->a + ST7789_DListRunEnd(cmd, k), cmd->b + k * step);
+        }
+        return;
+    }
+
+    // Vertical runs: start at the first one reaching row0
+    int32_t n0 = row0 - cmd->a;
+    int32_t n1 = row1 - cmd->a;
+
+    if (n0 < 0) n0 = 0;
+    if (n1 > cmd->c) n1 = cmd->c;
+
+    // Run k reaches step n once k * major >= n * minor - major / 2
+    int32_t num = n0 * cmd->d - cmd->c / 2;
+
+    for (int32_t k = (num > 0) ? (num + cmd->c - 1) / cmd->c : 0; k <= cmd->d; k++)
+    {
+        int32_t start = (k == 0) ? 0 : ST7789_DListRunEnd(cmd, k - 1) + 1;
+        int32_t end = ST7789_DListRunEnd(cmd, k);
+        int32_t col = cmd->b + k * step;
+
+        if (start > n1) break;
+        if (col < cmd->x0 || col > cmd->x1) continue;
+
+        if (start < n0) start = n0;
+        if (end > n1) end = n1;
+
+        for (int32_t n = start; n <= end; n++)
+        {
+            *ST7789_DListPixel(col, cmd->a + n) = cmd->color;
+        }
+    }
+}
+
+/**
+ * @brief Rasterize the rows of a ring inside [row0, row1] (same rule as ST7789_FillArc)
+ */
+static void ST7789_DListCircle(const ST7789_DListCmd *cmd, int32_t row0, int32_t row1)
+{
+    uint32_t outer2 = (uint32_t)cmd->c * cmd->c + cmd->c;
+    int32_t inner2 = (cmd->d > 0) ? (int32_t)(cmd->d - 1) * (cmd->d - 1) + (cmd->d - 1) : -1;
+
+    for (int32_t row = row0; row <= row1; row++)
+    {
+        int32_t dy = row - cmd->b;
+        int32_t xo = ST7789_Sqrt(outer2 - (uint32_t)(dy * dy));
+        int32_t xi = (inner2 >= dy * dy) ? (int32_t)ST7789_Sqrt(inner2 - dy * dy) : -1;
+
+        if (xi < 0)
+        {
+            ST7789_DListSpan(cmd, cmd->a - xo, cmd->a + xo, row);
+            continue;
+        }
+
+        ST7789_DListSpan(cmd, cmd->a - xo, cmd->a - xi - 1, row);
+        ST7789_DListSpan(cmd, cmd->a + xi + 1, cmd->a + xo, row);
+    }
+}
+
+#ifdef ST7789_USE_FONTS
+/**
+ * @brief Rasterize the rows of a text line inside [row0, row1]
+ */
+static void ST7789_DListText(const ST7789_DListCmd *cmd, int32_t row0, int32_t row1)
+{
+    const FontDef *font = cmd->data;
+    const char *str = (const char*)(cmd + 1);
+
+    for (int32_t row = row0; row <= row1; row++)
+    {
+        uint16_t *dst = ST7789_DListPixel(cmd->x0, row);
+        int32_t gy = row - cmd->b;
+        int32_t px = cmd->x0;
+
+        while (px <= cmd->x1)
+        {
+            int32_t i = (px - cmd->a) / font->width;
+            int32_t j = (px - cmd->a) - i * font->width;
+            uint16_t line = font->data[(str[i] - 32) * font->height + gy] << j;
+
+            for (; j < font->width && px <= cmd->x1; j++, px++, line <<= 1)
+            {
+                *dst++ = (line & 0x8000) ? cmd->color : cmd->d;
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Rasterize the part of a command inside the band (rows up to 'bottom')
+ */
+static void ST7789_DListRaster(const ST7789_DListCmd *cmd, int32_t bottom)
+{
+    int32_t row0 = (cmd->y0 > dlist.top) ? cmd->y0 : dlist.top;
+    int32_t row1 = (cmd->y1 < bottom) ? cmd->y1 : bottom;
+
+    switch (cmd->type)
+    {
+    case DLIST_FILL:
+        for (int32_t row = row0; row <= row1; row++)
+        {
+            ST7789_ColorFill(ST7789_DListPixel(cmd->x0, row), cmd->color, cmd->x1 - cmd->x0 + 1);
+        }
+        break;
+
+    case DLIST_LINE:
+        ST7789_DListLine(cmd, row0, row1);
+        break;
+
+    case DLIST_CIRCLE:
+        ST7789_DListCircle(cmd, row0, row1);
+        break;
+
+    case DLIST_IMAGE:
+        for (int32_t row = row0; row <= row1; row++)
+        {
+            const uint16_t *src = (const uint16_t*)cmd->data + (uint32_t)(row - cmd->b) * cmd->c + (cmd->x0 - cmd->a);
+
+            ST7789_CopyPixels(ST7789_DListPixel(cmd->x0, row), src, cmd->x1 - cmd->x0 + 1,
+                              (cmd->flags & DLIST_SWAP) != 0);
+        }
+        break;
+
+    #ifdef ST7789_USE_FONTS
+    case DLIST_TEXT:
+        ST7789_DListText(cmd, row0, row1);
+        break;
+    #endif
+
+    default:
+        break;
+    }
+}
+#endif
+
+#ifdef ST7789_USE_FONTS
+/**
+ * @brief Expand one glyph bitmap row into pixels
+ */
+static inline uint16_t *ST7789_ExpandGlyphLine(uint16_t *dst, uint16_t line, uint8_t width,
+                                               uint16_t fg, uint16_t bg)
+{
+    for (uint8_t j = 0; j < width; j++)
+    {
+        *dst++ = (line << j) & 0x8000 ? fg : bg;
+    }
+
+    return dst;
+}
+
+#ifdef ST7789_USE_GLYPH_CACHE
+/**
+ * @brief Drop the least recently used glyph not needed by the current run
+ */
+static uint8_t ST7789_GlyphCacheEvict(void)
+{
+    uint8_t victim = GLYPH_NO_SLOT;
+
+    for (uint8_t i = 0; i < ST7789_GLYPH_CACHE_ENTRIES; i++)
+    {
+        const ST7789_Glyph *g = &glyph_cache[i];
+        if (g->font == NULL || g->stamp == glyph_clock) continue;
+
+        if (victim == GLYPH_NO_SLOT || g->stamp < glyph_cache[victim].stamp)
+        {
+            victim = i;
+        }
+    }
+
+    if (victim != GLYPH_NO_SLOT)
+    {
+        glyph_cache[victim].font = NULL;
+        glyph_arena_used -= glyph_cache[victim].pixels;
+        glyph_stats.evictions++;
+    }
+
+    return victim;
+}
+
+/**
+ * @brief Slide live glyphs down to close the holes left by evictions
+ */
+static void ST7789_GlyphCacheCompact(void)
+{
+    uint32_t end = 0;
+
+    // A queued transfer (to any panel) may still be reading a glyph
+    #ifdef ST7789_USE_DMA
+    ST7789_WaitBusIdle(NULL);
+    #endif
+
+    for (;;)
+    {
+        // Lowest entry not yet moved
+        ST7789_Glyph *next = NULL;
+        for (uint8_t i = 0; i < ST7789_GLYPH_CACHE_ENTRIES; i++)
+        {
+            ST7789_Glyph *g = &glyph_cache[i];
+            if (g->font != NULL && g->offset >= end && (next == NULL || g->offset < next->offset))
+            {
+                next = g;
+            }
+        }
+
+        if (next == NULL) break;
+
+        if (next->offset != end)
+        {
+            memmove(&glyph_arena[end], &glyph_arena[next->offset], next->pixels * 2);
+            next->offset = end;
+        }
+        end += next->pixels;
+    }
+
+    glyph_arena_end = end;
+}
+
+/**
+ * @brief Find a glyph in the cache, expanding it on a miss
+ * @return Cache entry, or GLYPH_NO_SLOT if it cannot be cached
+ */
+static uint8_t ST7789_GlyphCacheGet(char ch, const FontDef *font, uint16_t fg, uint16_t bg)
+{
+    uint8_t slot = GLYPH_NO_SLOT;
+
+    for (uint8_t i = 0; i < ST7789_GLYPH_CACHE_ENTRIES; i++)
+    {
+        ST7789_Glyph *g = &glyph_cache[i];
+
+        if (g->font == NULL)
+        {
+            if (slot == GLYPH_NO_SLOT) slot = i;
+        }
+        else if (g->font == font->data && g->ch == ch && g->fg == fg && g->bg == bg)
+        {
+            g->stamp = glyph_clock;
+            glyph_stats.hits++;
+            return i;
+        }
+    }
+
+    glyph_stats.misses++;
+
+    uint32_t pixels = (uint32_t)font->width * font->height;
+    if (pixels > GLYPH_ARENA_PIXELS) return GLYPH_NO_SLOT;
+
+    // Need a free entry and enough free pixels
+    while (slot == GLYPH_NO_SLOT || GLYPH_ARENA_PIXELS - glyph_arena_used < pixels)
+    {
+        uint8_t victim = ST7789_GlyphCacheEvict();
+        if (victim == GLYPH_NO_SLOT) return GLYPH_NO_SLOT;
+        if (slot == GLYPH_NO_SLOT) slot = victim;
+    }
+
+    if (GLYPH_ARENA_PIXELS - glyph_arena_end < pixels)
+    {
+        ST7789_GlyphCacheCompact();
+    }
+
+    ST7789_Glyph *g = &glyph_cache[slot];
+    g->font = font->data;
+    g->ch = ch;
+    g->fg = fg;
+    g->bg = bg;
+    g->offset = glyph_arena_end;
+    g->pixels = pixels;
+    g->stamp = glyph_clock;
+
+    uint16_t *dst = &glyph_arena[g->offset];
+    const uint16_t *bits = &font->data[(ch - 32) * font->height];
+    for (uint16_t i = 0; i < font->height; i++)
+    {
+        dst = ST7789_ExpandGlyphLine(dst, bits[i], font->width, fg, bg);
+    }
+
+    glyph_arena_end += pixels;
+    glyph_arena_used += pixels;
+    return slot;
+}
+#endif
+
+/**
+ * @brief Expand row 'row' of every glyph in the run into dst
+ */
+static void ST7789_ExpandGlyphRow(uint16_t *dst, const ST7789_GlyphRun *run, uint16_t row)
+{
+    const FontDef *font = run->font;
+
+    for (uint16_t c = 0; c < run->count; c++)
+    {
+        #ifdef ST7789_USE_GLYPH_CACHE
+        if (run->slot[c] != GLYPH_NO_SLOT)
+        {
+            const ST7789_Glyph *g = &glyph_cache[run->slot[c]];
+            memcpy(dst, &glyph_arena[g->offset + row * font->width], font->width * 2);
+            dst += font->width;
+            continue;
+        }
+        #endif
+
+        uint16_t line = font->data[(run->str[c] - 32) * font->height + row];
+        dst = ST7789_ExpandGlyphLine(dst, line, font->width, run->fg, run->bg);
+    }
+}
+
+/**
+ * @brief Draw 'count' glyphs side by side through a single address window
+ */
+static void ST7789_WriteGlyphRun(uint16_t x, uint16_t y, const char *str, uint16_t count,
+                                 const FontDef *font, uint16_t color, uint16_t bgcolor)
+{
+    uint16_t run_width = count * font->width;
+
+    if (count == 0 || x + run_width > ST7789_WIDTH || y + font->height > ST7789_HEIGHT) return;
+
+    ST7789_GlyphRun run;
+    run.str = str;
+    run.count = count;
+    run.font = font;
+    run.fg = (color >> 8) | (color << 8);
+    run.bg = (bgcolor >> 8) | (bgcolor << 8);
+
+    #ifdef ST7789_USE_GLYPH_CACHE
+    // Glyphs of this run share a stamp, so they cannot evict each other
+    glyph_clock++;
+    for (uint16_t c = 0; c < count; c++)
+    {
+        run.slot[c] = ST7789_GlyphCacheGet(str[c], font, run.fg, run.bg);
+    }
+    #endif
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    uint16_t row_y = y;
+    uint16_t rows = font->height;
+    if (!ST7789_FbClip(&row_y, &rows)) return;
+
+    ST7789_WaitIdle();
+
+    for (uint16_t i = row_y - y; i < row_y - y + rows; i++)
+    {
+        ST7789_ExpandGlyphRow(ST7789_FbPixel(x, y + i), &run, i);
+    }
+
+    ST7789_FbMarkDirty(x, row_y, run_width, rows);
+    #else
+    ST7789_SetWindow(x, y, x + run_width - 1, y + font->height - 1);
+
+    #ifdef ST7789_USE_GLYPH_CACHE
+    // A lone cached glyph is already laid out in window order
+    if (count == 1 && run.slot[0] != GLYPH_NO_SLOT)
+    {
+        const ST7789_Glyph *g = &glyph_cache[run.slot[0]];
+        ST7789_WriteData((const uint8_t*)&glyph_arena[g->offset], g->pixels * 2);
+        return;
+    }
+    #endif
+
+    #ifdef ST7789_USE_DMA
+    // Pack as many glyph rows per line buffer as fit; DMA sends one while the next expands
+    uint16_t rows_per_buffer = DMA_BUFFER_PIXELS / run_width;
+
+    for (uint16_t i = 0; i < font->height; i += rows_per_buffer)
+    {
+        uint16_t rows = font->height - i;
+        if (rows > rows_per_buffer) rows = rows_per_buffer;
+
+        uint8_t idx = ST7789_AcquireBuffer();
+        dma_buffer_fill[idx] = 0;
+
+        for (uint16_t r = 0; r < rows; r++)
+        {
+            ST7789_ExpandGlyphRow(&dma_buffer[idx][r * run_width], &run, i + r);
+        }
+
+        ST7789_WriteBuffer(idx, (uint32_t)rows * run_width * 2);
+    }
+    #else
+    for (uint16_t i = 0; i < font->height; i++)
+    {
+        ST7789_ExpandGlyphRow(text_buffer, &run, i);
+        ST7789_WriteData((const uint8_t*)text_buffer, run_width * 2);
+    }
+    #endif
+    #endif
+}
+
+/**
+ * @brief Find the glyph for a character, '?' if the font lacks it
+ */
+static const GlyphDef *ST7789_PropGlyph(const PropFontDef *font, char ch)
+{
+    uint8_t c = (uint8_t)ch;
+
+    if (c < font->first || c > font->last) c = '?';
+    if (c < font->first || c > font->last) return NULL;
+
+    return &font->glyphs[c - font->first];
+}
+
+/**
+ * @brief Decode cell rows [row, row + rows) of a proportional glyph
+ * @param dst Destination, or NULL to only advance the decoder
+ */
+static void ST7789_ExpandPropRows(uint16_t *dst, const PropFontDef *font, const GlyphDef *glyph,
+                                  ST7789_RleState *rle, uint16_t row, uint16_t rows,
+                                  const uint16_t *palette)
+{
+    uint8_t shift = 8 - font->bpp;
+    uint8_t mask = (1 << shift) - 1;
+
+    for (uint16_t r = row; r < row + rows; r++)
+    {
+        bool ink = r >= glyph->y_offset && r < glyph->y_offset + glyph->height;
+
+        for (uint16_t cx = 0; cx < glyph->advance; cx++)
+        {
+            uint16_t pixel = palette[0];
+
+            if (ink && cx >= glyph->x_offset && cx < glyph->x_offset + glyph->width)
+            {
+                if (rle->run == 0)
+                {
+                    uint8_t token = *rle->src++;
+                    rle->level = token >> shift;
+                    rle->run = (token & mask) + 1;
+                }
+                rle->run--;
+                pixel = palette[rle->level];
+            }
+
+            if (dst != NULL) *dst++ = pixel;
+        }
+    }
+}
+
+/**
+ * @brief Draw one proportional glyph cell through its own address window
+ */
+static void ST7789_WritePropGlyph(uint16_t x, uint16_t y, const PropFontDef *font,
+                                  const GlyphDef *glyph, const uint16_t *palette)
+{
+    ST7789_RleState rle = {font->data + glyph->offset, 0, 0};
+    uint16_t w = glyph->advance;
+    uint16_t h = font->height;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    uint16_t row_y = y;
+    uint16_t rows = h;
+    if (!ST7789_FbClip(&row_y, &rows)) return;
+
+    ST7789_WaitIdle();
+
+    // Rows outside the band still have to be decoded to keep the stream in step
+    for (uint16_t i = 0; i < row_y - y + rows; i++)
+    {
+        uint16_t *dst = (i >= row_y - y) ? ST7789_FbPixel(x, y + i) : NULL;
+        ST7789_ExpandPropRows(dst, font, glyph, &rle, i, 1, palette);
+    }
+
+    ST7789_FbMarkDirty(x, row_y, w, rows);
+    #else
+    ST7789_SetWindow(x, y, x + w - 1, y + h - 1);
+
+    #ifdef ST7789_USE_DMA
+    uint16_t rows_per_buffer = DMA_BUFFER_PIXELS / w;
+
+    for (uint16_t i = 0; i < h; i += rows_per_buffer)
+    {
+        uint16_t rows = h - i;
+        if (rows > rows_per_buffer) rows = rows_per_buffer;
+
+        uint8_t idx = ST7789_AcquireBuffer();
+        dma_buffer_fill[idx] = 0;
+
+        ST7789_ExpandPropRows(dma_buffer[idx], font, glyph, &rle, i, rows, palette);
+        ST7789_WriteBuffer(idx, (uint32_t)rows * w * 2);
+    }
+    #else
+    uint16_t rows_per_buffer = ST7789_WIDTH / w;
+
+    for (uint16_t i = 0; i < h; i += rows_per_buffer)
+    {
+        uint16_t rows = h - i;
+        if (rows > rows_per_buffer) rows = rows_per_buffer;
+
+        ST7789_ExpandPropRows(text_buffer, font, glyph, &rle, i, rows, palette);
+        ST7789_WriteData((const uint8_t*)text_buffer, (uint32_t)rows * w * 2);
+    }
+    #endif
+    #endif
+}
+#endif
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Initialize ST7789
+ */
+void ST7789_Init(void)
+{
+    st7789_current->window.valid = false;
+
+    #ifdef ST7789_USE_DMA
+    // Line buffers are shared with other panels
+    ST7789_WaitBusIdle(NULL);
+    memset(dma_buffer, 0, sizeof(dma_buffer));
+    dma_buffer_fill[0] = 0;
+    dma_buffer_fill[1] = 0;
+    #endif
+
+    // Software reset only without the reset pin (same recovery time)
+    if (!ST7789_HardReset())
+    {
+        static const uint8_t swreset[] = {ST7789_SWRESET, 0};
+        ST7789_SendCommandList(swreset, 1);
+    }
+
+    uint32_t reset_tick = HAL_GetTick();
+    HAL_Delay(ST7789_RESET_MS);
+
+    ST7789_SendCommandList(init_cmds, ST7789_CommandCount(init_cmds, sizeof(init_cmds)));
+
+    // Frame rate is per panel
+    uint8_t frctrl[] = {ST7789_FRCTRL2, 1, st7789_current->frame_rtna};
+    ST7789_SendCommandList(frctrl, 1);
+
+    ST7789_SetRotation(ST7789_ROTATION);
+
+    // Rest of the Sleep Out wait (+1 for the partial tick at reset)
+    uint32_t elapsed = HAL_GetTick() - reset_tick;
+    if (elapsed <= SLPOUT_AFTER_RESET_MS) HAL_Delay(SLPOUT_AFTER_RESET_MS + 1 - elapsed);
+
+    ST7789_SendCommandList(slpout_cmd, 1);
+
+    // First frame goes into frame memory while the display is still off
+    #ifdef ST7789_USE_FRAMEBUFFER
+    ST7789_FirstPage(ST7789_BLACK);
+    do
+    {
+        ST7789_DrawSplash();
+    } while (ST7789_NextPage());
+    #else
+    ST7789_DrawSplash();
+    #endif
+
+    // Display On (waits for queued splash data)
+    ST7789_WriteCommand(ST7789_DISPON);
+}
+
+/**
+ * @brief Set the first frame drawn by ST7789_Init
+ */
+void ST7789_SetSplash(ST7789_SplashCallback callback)
+{
+    st7789_current->splash = callback;
+}
+
+/**
+ * @brief Set up a handle for another panel
+ */
+bool ST7789_InitHandle(st7789_t *panel, SPI_HandleTypeDef *hspi,
+                       GPIO_TypeDef *cs_port, uint16_t cs_pin,
+                       GPIO_TypeDef *dc_port, uint16_t dc_pin,
+                       GPIO_TypeDef *rst_port, uint16_t rst_pin)
+{
+    #ifdef ST7789_USE_DMA
+    // The completion interrupt only finds registered panels
+    uint8_t slot = ST7789_MAX_PANELS;
+
+    for (uint8_t i = 0; i < ST7789_MAX_PANELS; i++)
+    {
+        if (dma_panels[i] == panel)
+        {
+            slot = i;
+            break;
+        }
+
+        if (dma_panels[i] == NULL && slot == ST7789_MAX_PANELS) slot = i;
+    }
+
+    if (slot == ST7789_MAX_PANELS) return false;
+    #endif
+
+    memset(panel, 0, sizeof(*panel));
+
+    panel->spi = hspi;
+    panel->cs_port = cs_port;
+    panel->cs_pin = cs_pin;
+    panel->dc_port = dc_port;
+    panel->dc_pin = dc_pin;
+    panel->rst_port = rst_port;
+    panel->rst_pin = rst_pin;
+    panel->display = st7789_default.display;
+    panel->frame_rtna = 0x0F;
+
+    #ifdef ST7789_USE_POWER_MANAGER
+    panel->power = st7789_default.power;
+    #endif
+
+    #ifdef ST7789_USE_DMA
+    dma_panels[slot] = panel;
+    #endif
+
+    return true;
+}
+
+/**
+ * @brief Direct following calls to a panel
+ */
+void ST7789_Select(st7789_t *panel)
+{
+    if (panel == st7789_current) return;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    // The framebuffer is shared: hand it over clean and unread
+    ST7789_Flush();
+    ST7789_WaitIdle();
+    #endif
+
+    #ifdef ST7789_USE_DMA
+    // Panels on the same bus take turns
+    ST7789_WaitBusIdle(panel->spi);
+    #endif
+
+    st7789_current = panel;
+}
+
+/**
+ * @brief Get the selected panel
+ */
+st7789_t *ST7789_GetSelected(void)
+{
+    return st7789_current;
+}
+
+#ifdef ST7789_USE_SPI_BUS
+/**
+ * @brief Share the selected panel's SPI through an arbiter
+ */
+void ST7789_AttachBus(SPI_Bus *bus, uint32_t prescaler)
+{
+    ST7789_WaitIdle();
+
+    #ifdef ST7789_USE_DMA
+    SPI_BusAddDevice(&st7789_current->bus_dev, bus, prescaler, ST7789_BusGranted, st7789_current);
+    #else
+    SPI_BusAddDevice(&st7789_current->bus_dev, bus, prescaler, NULL, st7789_current);
+    #endif
+}
+#endif
+
+/**
+ * @brief Set display rotation
+ */
+void ST7789_SetRotation(uint8_t rotation)
+{
+    rotation %= 4;
+
+    ST7789_WaitIdle();
+    st7789_current->window.valid = false;
+
+    st7789_display.rotation = rotation;
+
+    #ifdef ST7789_RUNTIME_ROTATION
+    st7789_display.width = (rotation & 1) ? ST7789_PANEL_HEIGHT : ST7789_PANEL_WIDTH;
+    st7789_display.height = (rotation & 1) ? ST7789_PANEL_WIDTH : ST7789_PANEL_HEIGHT;
+    st7789_display.x_shift = rotations[rotation].x_shift;
+    st7789_display.y_shift = rotations[rotation].y_shift;
+    #endif
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    // Old contents and dirty areas are in the previous orientation
+    fb_band_y = 0;
+    fb_dirty_count = 0;
+    #endif
+
+    ST7789_WriteCommand(ST7789_MADCTL);
+    ST7789_WriteData8(rotations[rotation].madctl);
+}
+
+/**
+ * @brief Get current visible width
+ */
+uint16_t ST7789_GetWidth(void)
+{
+    return ST7789_WIDTH;
+}
+
+/**
+ * @brief Get current visible height
+ */
+uint16_t ST7789_GetHeight(void)
+{
+    return ST7789_HEIGHT;
+}
+
+/**
+ * @brief Invert display colors
+ */
+void ST7789_InvertDisplay(bool invert)
+{
+    ST7789_WriteCommand(invert ? ST7789_INVON : ST7789_INVOFF);
+}
+
+/**
+ * @brief Sleep mode control
+ */
+void ST7789_Sleep(bool sleep)
+{
+    ST7789_WriteCommand(sleep ? ST7789_SLPIN : ST7789_SLPOUT);
+    HAL_Delay(120);
+}
+
+/**
+ * @brief Define the vertically scrolling band
+ */
+bool ST7789_SetScrollArea(uint16_t top, uint16_t height)
+{
+    // The panel scrolls along its rows, which are screen columns in landscape
+    if (IS_LANDSCAPE()) return false;
+
+    if (height == 0 || top + height > ST7789_HEIGHT) return false;
+
+    uint16_t tfa = ST7789_GramRow(top, height);
+    uint16_t bfa = ST7789_GRAM_ROWS - tfa - height;
+
+    const uint8_t list[] = {
+        ST7789_VSCRDEF, 6, tfa >> 8, tfa & 0xFF, height >> 8, height & 0xFF, bfa >> 8, bfa & 0xFF,
+    };
+    ST7789_SendCommandList(list, 1);
+
+    st7789_current->scroll.tfa = tfa;
+    st7789_current->scroll.height = height;
+    ST7789_SetScrollOffset(0);
+    return true;
+}
+
+/**
+ * @brief Scroll the band contents up by 'offset' lines
+ */
+void ST7789_SetScrollOffset(uint16_t offset)
+{
+    if (st7789_current->scroll.height == 0) return;
+
+    offset %= st7789_current->scroll.height;
+
+    // Memory runs the other way, so scrolling up moves the start address down
+    if (IS_MIRROR_Y() && offset != 0) offset = st7789_current->scroll.height - offset;
+
+    uint16_t vsp = st7789_current->scroll.tfa + offset;
+    const uint8_t list[] = {ST7789_VSCSAD, 2, vsp >> 8, vsp & 0xFF};
+    ST7789_SendCommandList(list, 1);
+}
+
+/**
+ * @brief Restrict scan-out to a band of lines
+ */
+void ST7789_SetPartialArea(uint16_t start, uint16_t count)
+{
+    uint16_t lines = ST7789_SCAN_LINES;
+
+    if (start >= lines || count == 0) return;
+    if (start + count > lines) count = lines - start;
+
+    uint16_t sr = ST7789_GramRow(start, count);
+    uint16_t er = sr + count - 1;
+
+    const uint8_t list[] = {
+        ST7789_PTLAR, 4, sr >> 8, sr & 0xFF, er >> 8, er & 0xFF,
+        ST7789_PTLON, 0,
+    };
+    ST7789_SendCommandList(list, 2);
+}
+
+/**
+ * @brief Leave partial mode
+ */
+void ST7789_SetNormalMode(void)
+{
+    ST7789_WriteCommand(ST7789_NORON);
+}
+
+/**
+ * @brief Enter/exit 8-color idle mode
+ */
+void ST7789_SetIdleMode(bool idle)
+{
+    ST7789_WriteCommand(idle ? ST7789_IDMON : ST7789_IDMOFF);
+}
+
+/**
+ * @brief Set normal mode frame rate
+ */
+uint8_t ST7789_SetFrameRate(uint8_t hz)
+{
+    st7789_current->frame_rtna = ST7789_FrameRateRtn(hz, NULL);
+
+    const uint8_t list[] = {ST7789_FRCTRL2, 1, st7789_current->frame_rtna};
+    ST7789_SendCommandList(list, 1);
+
+    return ST7789_FrameRateHz(st7789_current->frame_rtna, 0);
+}
+
+/**
+ * @brief Set frame rate used in idle and partial modes
+ */
+uint8_t ST7789_SetIdleFrameRate(uint8_t hz)
+{
+    uint8_t div;
+    uint8_t rtn = ST7789_FrameRateRtn(hz, &div);
+
+    // FRSEN: separate rate; same RTN for idle (B) and partial (C) modes
+    const uint8_t list[] = {ST7789_FRCTRL1, 3, 0x10 | div, rtn, rtn};
+    ST7789_SendCommandList(list, 1);
+
+    return ST7789_FrameRateHz(rtn, div);
+}
+
+#ifdef ST7789_USE_POWER_MANAGER
+/**
+ * @brief Configure what the power manager does when the screen is static
+ */
+void ST7789_PowerConfig(uint32_t timeout_ms, bool color8, uint8_t idle_hz)
+{
+    st7789_current->power.timeout = timeout_ms;
+    st7789_current->power.color8 = color8;
+
+    if (color8)
+    {
+        ST7789_SetIdleFrameRate(idle_hz);
+    }
+    else
+    {
+        st7789_current->power.idle_rtna = ST7789_FrameRateRtn(idle_hz, NULL);
+    }
+
+    st7789_current->power.last_activity = HAL_GetTick();
+}
+
+/**
+ * @brief Enter the low-power state once the screen has been static long enough
+ */
+void ST7789_PowerTask(void)
+{
+    if (st7789_current->power.idle || st7789_current->power.timeout == 0) return;
+    if (HAL_GetTick() - st7789_current->power.last_activity < st7789_current->power.timeout) return;
+    if (ST7789_IsBusy()) return;
+
+    if (st7789_current->power.color8)
+    {
+        ST7789_SetIdleMode(true);
+    }
+    else
+    {
+        const uint8_t list[] = {ST7789_FRCTRL2, 1, st7789_current->power.idle_rtna};
+        ST7789_SendCommandList(list, 1);
+    }
+
+    st7789_current->power.idle = true;
+}
+
+/**
+ * @brief Check if the power manager has idled the panel
+ */
+bool ST7789_PowerIsIdle(void)
+{
+    return st7789_current->power.idle;
+}
+#endif
+
+/**
+ * @brief Check if background transfers are pending
+ */
+bool ST7789_IsBusy(void)
+{
+    #ifdef ST7789_USE_DMA
+    return st7789_current->dma_active;
+    #else
+    return false;
+    #endif
+}
+
+/**
+ * @brief Wait for background transfers to finish
+ */
+void ST7789_WaitIdle(void)
+{
+    #ifdef ST7789_USE_DMA
+    if (!st7789_current->dma_active) return;
+
+    uint32_t start = STATS_NOW();
+    TRACE_HOOK(TRACE_LCD_WAIT, WAIT_DMA_IDLE);
+
+    while (st7789_current->dma_active);
+
+    STATS_TIME(blocked_cycles, start);
+    #endif
+}
+
+#ifdef ST7789_USE_DMA
+/**
+ * @brief Set queue drained callback
+ */
+void ST7789_SetDoneCallback(ST7789_DoneCallback callback)
+{
+    st7789_current->dma_done_cb = callback;
+}
+
+/**
+ * @brief DMA transfer complete - chain next chunk or finish burst
+ */
+void ST7789_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    // Only one panel per bus can have a burst in flight (others may be waiting for the bus)
+    st7789_t *panel = NULL;
+    for (uint8_t i = 0; i < ST7789_MAX_PANELS; i++)
+    {
+        st7789_t *p = dma_panels[i];
+        if (p == NULL || p->spi != hspi || !p->dma_active) continue;
+
+        #ifdef ST7789_USE_SPI_BUS
+        if (p->bus_dev.bus != NULL && p->bus_dev.bus->owner != &p->bus_dev) continue;
+        #endif
+
+        panel = p;
+        break;
+    }
+
+    if (panel == NULL) return;
+
+    ST7789_Transfer *xfer = &panel->dma_queue[panel->dma_tail & (ST7789_DMA_QUEUE_SIZE - 1)];
+    xfer->data += panel->dma_chunk;
+    xfer->len -= panel->dma_chunk;
+
+    if (xfer->len == 0)
+    {
+        if (xfer->buffer != DMA_NO_BUFFER)
+        {
+            dma_buffer_refs[xfer->buffer]--;
+        }
+        panel->dma_tail++;
+    }
+
+    if (panel->dma_tail != panel->dma_head)
+    {
+        #ifdef ST7789_USE_SPI_BUS
+        // Let waiting devices in; RAMWR carries on when CS drops again
+        if (panel->bus_dev.bus != NULL && SPI_BusIsContended(&panel->bus_dev))
+        {
+            ST7789_DmaStopped(panel);
+            PANEL_CS_HIGH(panel);
+            SPI_BusYield(&panel->bus_dev);
+            return;
+        }
+        #endif
+
+        ST7789_DmaStart(panel);
+        return;
+    }
+
+    // Queue drained
+    ST7789_DmaFinish(panel);
+}
+
+#ifndef ST7789_USER_SPI_CALLBACK
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    ST7789_SPI_TxCpltCallback(hspi);
+}
+#endif
+#endif
+
+#ifdef ST7789_USE_FRAMEBUFFER
+/**
+ * @brief Send dirty areas of framebuffer
+ */
+void ST7789_Flush(void)
+{
+    for (uint8_t i = 0; i < fb_dirty_count; i++)
+    {
+        ST7789_Rect *r = &fb_dirty[i];
+        uint16_t w = r->x1 - r->x0 + 1;
+
+        ST7789_SetWindow(r->x0, r->y0, r->x1, r->y1);
+
+        if (w == ST7789_WIDTH)
+        {
+            // Full-width rows are contiguous in RAM
+            ST7789_WriteData((const uint8_t*)ST7789_FbPixel(0, r->y0),
+                             (uint32_t)w * (r->y1 - r->y0 + 1) * 2);
+        }
+        else
+        {
+            for (uint16_t y = r->y0; y <= r->y1; y++)
+            {
+                ST7789_WriteData((const uint8_t*)ST7789_FbPixel(r->x0, y), w * 2);
+            }
+        }
+    }
+
+    fb_dirty_count = 0;
+}
+
+/**
+ * @brief Start frame (select first band)
+ */
+void ST7789_FirstPage(uint16_t bgcolor)
+{
+    // Full framebuffer: contents persist between frames
+    if (FB_LINES >= ST7789_HEIGHT) return;
+
+    fb_band_color = bgcolor;
+    fb_band_y = 0;
+    fb_dirty_count = 0;
+
+    ST7789_WaitIdle();
+    ST7789_ColorFill(framebuffer, (bgcolor >> 8) | (bgcolor << 8), ST7789_WIDTH * FB_LINES);
+}
+
+/**
+ * @brief Flush band and advance to next one
+ */
+bool ST7789_NextPage(void)
+{
+    ST7789_Flush();
+
+    if (fb_band_y + FB_LINES >= ST7789_HEIGHT)
+    {
+        fb_band_y = 0;
+        return false;
+    }
+
+    ST7789_WaitIdle();
+    fb_band_y += FB_LINES;
+
+    ST7789_ColorFill(framebuffer, (fb_band_color >> 8) | (fb_band_color << 8), ST7789_WIDTH * FB_LINES);
+    return true;
+}
+#endif
+
+#ifdef ST7789_USE_DLIST
+/**
+ * @brief Start a new display list
+ */
+void ST7789_DListBegin(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t bgcolor)
+{
+    int32_t x0 = (x < 0) ? 0 : x;
+    int32_t y0 = (y < 0) ? 0 : y;
+    int32_t x1 = (int32_t)x + w;
+    int32_t y1 = (int32_t)y + h;
+
+    if (x1 > ST7789_WIDTH) x1 = ST7789_WIDTH;
+    if (y1 > ST7789_HEIGHT) y1 = ST7789_HEIGHT;
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+
+    dlist.x = x0;
+    dlist.y = y0;
+    dlist.w = x1 - x0;
+    dlist.h = y1 - y0;
+    dlist.bgcolor = (bgcolor >> 8) | (bgcolor << 8);
+    dlist.used = 0;
+    dlist.count = 0;
+}
+
+/**
+ * @brief Record filled rectangle
+ */
+bool ST7789_DListFillRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    ST7789_DListCmd *cmd;
+
+    if (w == 0 || h == 0) return true;
+
+    return ST7789_DListAdd(&cmd, DLIST_FILL, x, y, (int32_t)x + w - 1, (int32_t)y + h - 1, color, 0);
+}
+
+/**
+ * @brief Record rectangle outline
+ */
+bool ST7789_DListDrawRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    bool ok = true;
+
+    if (w == 0 || h == 0) return true;
+
+    // Same edges as ST7789_DrawRect
+    ok &= ST7789_DListFillRect(x, y, w, 1, color);
+    if (h > 1)
+    {
+        ok &= ST7789_DListFillRect(x, y + h - 1, w, 1, color);
+    }
+
+    if (h > 2)
+    {
+        ok &= ST7789_DListFillRect(x, y + 1, 1, h - 2, color);
+        if (w > 1)
+        {
+            ok &= ST7789_DListFillRect(x + w - 1, y + 1, 1, h - 2, color);
+        }
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Record line
+ */
+bool ST7789_DListDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+    ST7789_DListCmd *cmd;
+    int16_t tmp;
+
+    // Axis-aligned lines are a single fill
+    if (y0 == y1 || x0 == x1)
+    {
+        if (x0 > x1) { tmp = x0; x0 = x1; x1 = tmp; }
+        if (y0 > y1) { tmp = y0; y0 = y1; y1 = tmp; }
+        return ST7789_DListAdd(&cmd, DLIST_FILL, x0, y0, x1, y1, color, 0);
+    }
+
+    int32_t bx0 = (x0 < x1) ? x0 : x1, bx1 = (x0 < x1) ? x1 : x0;
+    int32_t by0 = (y0 < y1) ? y0 : y1, by1 = (y0 < y1) ? y1 : y0;
+    bool steep = ABS(y1 - y0) > ABS(x1 - x0);
+
+    // Same normalization as ST7789_DrawLine
+    if (steep)
+    {
+        tmp = x0; x0 = y0; y0 = tmp;
+        tmp = x1; x1 = y1; y1 = tmp;
+    }
+
+    if (x0 > x1)
+    {
+        tmp = x0; x0 = x1; x1 = tmp;
+        tmp = y0; y0 = y1; y1 = tmp;
+    }
+
+    if (!ST7789_DListAdd(&cmd, DLIST_LINE, bx0, by0, bx1, by1, color, 0)) return false;
+    if (cmd == NULL) return true;
+
+    cmd->flags = (steep ? DLIST_STEEP : 0) | ((y1 < y0) ? DLIST_UP : 0);
+    cmd->a = x0;
+    cmd->b = y0;
+    cmd->c = x1 - x0;
+    cmd->d = ABS(y1 - y0);
+    return true;
+}
+
+/**
+ * @brief Record ring between radii r_inner and r_outer
+ */
+static bool ST7789_DListRing(int16_t x0, int16_t y0, uint16_t r_outer, uint16_t r_inner, uint16_t color)
+{
+    ST7789_DListCmd *cmd;
+
+    if (!ST7789_DListAdd(&cmd, DLIST_CIRCLE, (int32_t)x0 - r_outer, (int32_t)y0 - r_outer,
+                         (int32_t)x0 + r_outer, (int32_t)y0 + r_outer, color, 0)) return false;
+    if (cmd == NULL) return true;
+
+    cmd->a = x0;
+    cmd->b = y0;
+    cmd->c = r_outer;
+    cmd->d = r_inner;
+    return true;
+}
+
+/**
+ * @brief Record filled circle
+ */
+bool ST7789_DListFillCircle(int16_t x0, int16_t y0, uint16_t r, uint16_t color)
+{
+    return ST7789_DListRing(x0, y0, r, 0, color);
+}
+
+/**
+ * @brief Record circle outline
+ */
+bool ST7789_DListDrawCircle(int16_t x0, int16_t y0, uint16_t r, uint16_t color)
+{
+    return ST7789_DListRing(x0, y0, r, r, color);
+}
+
+/**
+ * @brief Record image
+ */
+bool ST7789_DListDrawImage(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                           const uint16_t *data, ST7789_PixelOrder order)
+{
+    ST7789_DListCmd *cmd;
+
+    if (w == 0 || h == 0) return true;
+
+    if (!ST7789_DListAdd(&cmd, DLIST_IMAGE, x, y, (int32_t)x + w - 1, (int32_t)y + h - 1, 0, 0)) return false;
+    if (cmd == NULL) return true;
+
+    cmd->flags = (order == ST7789_ORDER_NATIVE) ? DLIST_SWAP : 0;
+    cmd->a = x;
+    cmd->b = y;
+    cmd->c = w;
+    cmd->data = data;
+    return true;
+}
+
+#ifdef ST7789_USE_FONTS
+/**
+ * @brief Record text line
+ */
+bool ST7789_DListWriteString(int16_t x, int16_t y, const char *str, const FontDef *font,
+                             uint16_t color, uint16_t bgcolor)
+{
+    ST7789_DListCmd *cmd;
+    size_t len = strlen(str);
+
+    // Characters past the right edge are never drawn
+    size_t max = (ST7789_WIDTH - x + font->width - 1) / font->width;
+    if (x < ST7789_WIDTH && len > max) len = max;
+
+    if (len == 0 || x >= ST7789_WIDTH) return true;
+
+    if (!ST7789_DListAdd(&cmd, DLIST_TEXT, x, y, (int32_t)x + len * font->width - 1,
+                         (int32_t)y + font->height - 1, color, len)) return false;
+    if (cmd == NULL) return true;
+
+    cmd->a = x;
+    cmd->b = y;
+    cmd->c = len;
+    cmd->d = (bgcolor >> 8) | (bgcolor << 8);
+    cmd->data = font;
+    memcpy(cmd + 1, str, len);
+    return true;
+}
+#endif
+
+/**
+ * @brief Rasterize and send the display list
+ */
+uint16_t ST7789_DListSubmit(void)
+{
+    if (dlist.w == 0 || dlist.h == 0) return 0;
+
+    // Region must still fit (rotation may have changed)
+    if (dlist.x + dlist.w > ST7789_WIDTH || dlist.y + dlist.h > ST7789_HEIGHT) return 0;
+
+    // Full-width bands, as many rows as a line buffer holds
+    int32_t lines = DMA_BUFFER_PIXELS / dlist.w;
+    int32_t end = dlist.y + dlist.h - 1;
+
+    // Stable sort by top row: equal rows keep their paint order
+    for (uint8_t i = 0; i < dlist.count; i++)
+    {
+        uint8_t j = i;
+        int16_t y0 = ST7789_DListGet(i)->y0;
+
+        for (; j > 0 && ST7789_DListGet(dlist.order[j - 1])->y0 > y0; j--)
+        {
+            dlist.order[j] = dlist.order[j - 1];
+        }
+        dlist.order[j] = i;
+    }
+
+    uint8_t next = 0;
+    uint16_t windows = 0;
+    bool streaming = false;         // Window open for the following band pixels
+    int32_t solid_top = -1;         // First row of pending solid bands (-1 = none)
+    uint16_t solid_color = 0;
+    dlist.active_count = 0;
+
+    for (int32_t top = dlist.y; top <= end; top += lines)
+    {
+        int32_t bottom = (top + lines - 1 < end) ? top + lines - 1 : end;
+
+        // Drop finished commands, then add the ones starting in this band
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < dlist.active_count; i++)
+        {
+            if (ST7789_DListGet(dlist.active[i])->y1 >= top) dlist.active[n++] = dlist.active[i];
+        }
+
+        for (; next < dlist.count && ST7789_DListGet(dlist.order[next])->y0 <= bottom; next++)
+        {
+            uint8_t c = dlist.order[next];
+            uint8_t j = n++;
+
+            for (; j > 0 && dlist.active[j - 1] > c; j--)
+            {
+                dlist.active[j] = dlist.active[j - 1];
+            }
+            dlist.active[j] = c;
+        }
+        dlist.active_count = n;
+
+        // A fill covering the whole band hides everything recorded before it
+        uint8_t first = 0;
+        uint16_t base = dlist.bgcolor;
+
+        for (uint8_t i = n; i-- > 0;)
+        {
+            const ST7789_DListCmd *cmd = ST7789_DListGet(dlist.active[i]);
+
+            if (cmd->type == DLIST_FILL && cmd->x0 == dlist.x && cmd->x1 == dlist.x + dlist.w - 1 &&
+                cmd->y0 <= top && cmd->y1 >= bottom)
+            {
+                first = i + 1;
+                base = cmd->color;
+                break;
+            }
+        }
+
+        // Solid bands are merged into one window fill
+        if (first == n)
+        {
+            if (solid_top >= 0 && base != solid_color)
+            {
+                ST7789_FillRect(dlist.x, solid_top, dlist.w, top - solid_top, (solid_color >> 8) | (solid_color << 8));
+                windows++;
+                solid_top = -1;
+            }
+
+            if (solid_top < 0)
+            {
+                solid_top = top;
+                solid_color = base;
+            }
+
+            streaming = false;
+            continue;
+        }
+
+        if (solid_top >= 0)
+        {
+            ST7789_FillRect(dlist.x, solid_top, dlist.w, top - solid_top, (solid_color >> 8) | (solid_color << 8));
+            windows++;
+            solid_top = -1;
+        }
+
+        // Built while DMA is still sending the previous band
+        uint8_t idx = ST7789_AcquireBuffer();
+        uint32_t pixels = (uint32_t)(bottom - top + 1) * dlist.w;
+
+        dma_buffer_fill[idx] = 0;
+        dlist.band = dma_buffer[idx];
+        dlist.top = top;
+        ST7789_ColorFill(dlist.band, base, pixels);
+
+        for (uint8_t i = first; i < n; i++)
+        {
+            ST7789_DListRaster(ST7789_DListGet(dlist.active[i]), bottom);
+        }
+
+        // Consecutive drawn bands continue the same window
+        if (!streaming)
+        {
+            ST7789_SetWindow(dlist.x, top, dlist.x + dlist.w - 1, end);
+            windows++;
+            streaming = true;
+        }
+
+        ST7789_WriteBuffer(idx, pixels * 2);
+    }
+
+    if (solid_top >= 0)
+    {
+        ST7789_FillRect(dlist.x, solid_top, dlist.w, end + 1 - solid_top, (solid_color >> 8) | (solid_color << 8));
+        windows++;
+    }
+
+    return windows;
+}
+#endif
+
+/**
+ * @brief Fill entire screen with color
+ */
+void ST7789_FillScreen(uint16_t color)
+{
+    ST7789_FillRect(0, 0, ST7789_WIDTH, ST7789_HEIGHT, color);
+}
+
+/**
+ * @brief Fill rectangle
+ */
+void ST7789_FillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
+
+    if (x + w > ST7789_WIDTH) w = ST7789_WIDTH - x;
+
+    if (y + h > ST7789_HEIGHT) h = ST7789_HEIGHT - y;
+
+    if (w == 0 || h == 0) return;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    ST7789_FbFill(x, y, w, h, color);
+    return;
+    #endif
+
+    ST7789_SetWindow(x, y, x + w - 1, y + h - 1);
+
+    #ifdef ST7789_USE_DMA
+    // Only fill as much as needed; same color reuses the cached buffer
+    uint32_t total_pixels = (uint32_t)w * h;
+    uint8_t idx = ST7789_GetFillBuffer(color, total_pixels);
+
+    while (total_pixels >= DMA_BUFFER_PIXELS)
+    {
+        ST7789_WriteBuffer(idx, DMA_BUFFER_PIXELS * 2);
+        total_pixels -= DMA_BUFFER_PIXELS;
+    }
+
+    if (total_pixels > 0)
+    {
+        ST7789_WriteBuffer(idx, total_pixels * 2);
+    }
+    #else
+    uint32_t pixels = (uint32_t)w * h;
+
+    CS_LOW();
+    DC_HIGH();
+
+    // Use 128-byte buffer for optimization
+    uint16_t buffer[64];
+    ST7789_ColorFill(buffer, (color >> 8) | (color << 8), 64);
+
+    while (pixels >= 64)
+    {
+        ST7789_SpiTransmit((const uint8_t*)buffer, 128);
+        pixels -= 64;
+    }
+
+    if (pixels > 0)
+    {
+        ST7789_SpiTransmit((const uint8_t*)buffer, pixels * 2);
+    }
+
+    CS_HIGH();
+    #endif
+}
+
+/**
+ * @brief Draw single pixel
+ */
+void ST7789_DrawPixel(uint16_t x, uint16_t y, uint16_t color)
+{
+    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    ST7789_FbFill(x, y, 1, 1, color);
+    return;
+    #endif
+
+    // Window and pixel go out as one command stream (pixel as RAMWR args)
+    uint8_t list[18];
+    uint8_t count = ST7789_EncodeWindow(list, x, y, x, y);
+    uint8_t *ramwr = &list[(count - 1) * 6];
+
+    ramwr[1] = 2;
+    ramwr[2] = color >> 8;
+    ramwr[3] = color & 0xFF;
+
+    ST7789_SendCommandList(list, count);
+}
+
+/**
+ * @brief Draw run of pixels along a line's major axis
+ */
+static inline void ST7789_DrawRun(uint16_t x, uint16_t y, uint16_t len, bool vertical, uint16_t color)
+{
+    if (len == 1)
+    {
+        ST7789_DrawPixel(x, y, color);
+    }
+    else if (vertical)
+    {
+        ST7789_FillRect(x, y, 1, len, color);
+    }
+    else
+    {
+        ST7789_FillRect(x, y, len, 1, color);
+    }
+}
+
+/**
+ * @brief Draw line - Bresenham's algorithm, emitted as runs
+ */
+void ST7789_DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color)
+{
+    uint16_t tmp;
+
+    // Axis-aligned lines are a single rectangle
+    if (y0 == y1)
+    {
+        if (x0 > x1) { tmp = x0; x0 = x1; x1 = tmp; }
+        ST7789_DrawRun(x0, y0, x1 - x0 + 1, false, color);
+        return;
+    }
+
+    if (x0 == x1)
+    {
+        if (y0 > y1) { tmp = y0; y0 = y1; y1 = tmp; }
+        ST7789_DrawRun(x0, y0, y1 - y0 + 1, true, color);
+        return;
+    }
+
+    int16_t steep = ABS(y1 - y0) > ABS(x1 - x0);
+
+    if (steep)
+    {
+        tmp = x0; x0 = y0; y0 = tmp;
+        tmp = x1; x1 = y1; y1 = tmp;
+    }
+
+    if (x0 > x1)
+    {
+        tmp = x0; x0 = x1; x1 = tmp;
+        tmp = y0; y0 = y1; y1 = tmp;
+    }
+
+    int16_t dx = x1 - x0;
+    int16_t dy = ABS(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = (y0 < y1) ? 1 : -1;
+    uint16_t run_start = x0;
+
+    // Pixels sharing a minor coordinate go out as one window
+    for (; x0 <= x1; x0++)
+    {
+        err -= dy;
+        if (err < 0 || x0 == x1)
+        {
+            if (steep)
+            {
+                ST7789_DrawRun(y0, run_start, x0 - run_start + 1, true, color);
+            }
+            else
+            {
+                ST7789_DrawRun(run_start, y0, x0 - run_start + 1, false, color);
+            }
+
+            run_start = x0 + 1;
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+/**
+ * @brief Draw rectangle outline
+ */
+void ST7789_DrawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+    if (w == 0 || h == 0) return;
+
+    // Top and bottom edges, then sides without the corners
+    ST7789_FillRect(x, y, w, 1, color);
+    if (h > 1)
+    {
+        ST7789_FillRect(x, y + h - 1, w, 1, color);
+    }
+
+    if (h > 2)
+    {
+        ST7789_FillRect(x, y + 1, 1, h - 2, color);
+        if (w > 1)
+        {
+            ST7789_FillRect(x + w - 1, y + 1, 1, h - 2, color);
+        }
+    }
+}
+
+/**
+ * @brief Draw circle outline - Midpoint algorithm, emitted as runs
+ */
+void ST7789_DrawCircle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+    int16_t f = 1 - r;
+    int16_t ddF_x = 1;
+    int16_t ddF_y = -2 * r;
+    int16_t x = 0;
+    int16_t y = r;
+    int16_t run_start = 0;
+
+    // Points sharing y form one run per octant
+    while (x < y)
+    {
+        if (f >= 0)
+        {
+            ST7789_CircleRuns(x0, y0, run_start, x, y, color);
+            run_start = x + 1;
+            y--;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        x++;
+        ddF_x += 2;
+        f += ddF_x;
+    }
+
+    ST7789_CircleRuns(x0, y0, run_start, x, y, color);
+}
+
+/**
+ * @brief Draw filled circle
+ */
+void ST7789_FillCircle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+    if (r == 0) return;
+
+    int16_t x = 0;
     int16_t y = r;
+    int16_t d = 3 - 2 * r;  // Midpoint decision parameter
+
+    while (y >= x)
+    {
+        // Rows y0 +/- y only widen while y stays: draw them once, at their widest
+        if (d >= 0 || y == x)
+        {
+            ST7789_DrawSpan(x0 - x, x0 + x, y0 + y, color);  // Bottom
+            ST7789_DrawSpan(x0 - x, x0 + x, y0 - y, color);  // Up
+        }
+
+        if (x != y) {
+            ST7789_DrawSpan(x0 - y, x0 + y, y0 + x, color);  // Bottom
+            if (x != 0)
+            {
+                ST7789_DrawSpan(x0 - y, x0 + y, y0 - x, color);  // Up
+            }
+        }
+
+        // Update follow Midpoint Circle Algorithm
+        if (d < 0)
+        {
+            d = d + 4 * x + 6;
+        }
+        else
+        {
+            d = d + 4 * (x - y) + 10;
+            y--;
+        }
+        x++;
+    }
+}
+
+/**
+ * @brief Draw triangle outline
+ */
+void ST7789_DrawTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
+                         uint16_t x3, uint16_t y3, uint16_t color)
+{
+    ST7789_DrawLine(x1, y1, x2, y2, color);
+    ST7789_DrawLine(x2, y2, x3, y3, color);
+    ST7789_DrawLine(x3, y3, x1, y1, color);
+}
+
+/**
+ * @brief Draw filled triangle
+ *
+ * Scanline rasterizer with the usual top-left fill convention: pixel (x, y)
+ * is filled when its center lies inside the triangle, with centers exactly
+ * on a left or top edge counted in and those on a right or bottom edge
+ * counted out. Triangles that share an edge therefore tile without gaps or
+ * overdraw, e.g. two triangles splitting a w x h rectangle cover exactly
+ * the pixels of ST7789_FillRect(x, y, w, h).
+ */
+void ST7789_FillTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
+                         uint16_t x3, uint16_t y3, uint16_t color)
+{
+    int32_t ax = x1, ay = y1, bx = x2, by = y2, cx = x3, cy = y3, tmp;
+
+    // Sort vertices so that ay <= by <= cy
+    if (ay > by) { tmp = ax; ax = bx; bx = tmp; tmp = ay; ay = by; by = tmp; }
+    if (by > cy) { tmp = bx; bx = cx; cx = tmp; tmp = by; by = cy; cy = tmp; }
+    if (ay > by) { tmp = ax; ax = bx; bx = tmp; tmp = ay; ay = by; by = tmp; }
+
+    // Rows [ay, cy), clipped to the screen; a flat triangle covers no rows
+    int32_t y = ay;
+    int32_t y_end = (cy < ST7789_HEIGHT) ? cy : ST7789_HEIGHT;
+    if (y >= y_end) return;
+
+    // A flat top (ay == by) sets the short edge on the first row
+    ST7789_Edge long_edge, short_edge = {0};
+    ST7789_EdgeInit(&long_edge, ax, ay, cx, cy, y);
+    if (y < by) ST7789_EdgeInit(&short_edge, ax, ay, bx, by, y);
+
+    for (; y < y_end; y++)
+    {
+        if (y == by) ST7789_EdgeInit(&short_edge, bx, by, cx, cy, y);
+
+        int64_t xl = long_edge.x, xr = short_edge.x;
+        if (xl > xr) { int64_t t = xl; xl = xr; xr = t; }
+
+        // Pixels whose centers fall in [xl, xr)
+        int32_t px0 = (int32_t)((xl + 0xFFFF) >> 16);
+        int32_t px1 = (int32_t)((xr + 0xFFFF) >> 16) - 1;
+        ST7789_DrawSpan(px0, px1, y, color);
+
+        long_edge.x += long_edge.step;
+        short_edge.x += short_edge.step;
+    }
+}
+
+/**
+ * @brief Draw anti-aliased line - Wu's algorithm, emitted as spans
+ */
+void ST7789_DrawLineAA(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                       uint16_t color, uint16_t bgcolor)
+{
+    // Blend every coverage level against the background once per line
+    uint16_t palette[33];
+    int16_t fr = color >> 11, fg = (color >> 5) & 0x3F, fb = color & 0x1F;
+    int16_t br = bgcolor >> 11, bg = (bgcolor >> 5) & 0x3F, bb = bgcolor & 0x1F;
+
+    for (uint8_t a = 0; a <= 32; a++)
+    {
+        uint16_t r = br + ((fr - br) * a + 16) / 32;
+        uint16_t g = bg + ((fg - bg) * a + 16) / 32;
+        uint16_t b = bb + ((fb - bb) * a + 16) / 32;
+        uint16_t c = (r << 11) | (g << 5) | b;
+        palette[a] = (c >> 8) | (c << 8);
+    }
+
+    bool steep = ABS(y1 - y0) > ABS(x1 - x0);
+    int16_t tmp;
+
+    if (steep)
+    {
+        tmp = x0; x0 = y0; y0 = tmp;
+        tmp = x1; x1 = y1; y1 = tmp;
+    }
+
+    if (x0 > x1)
+    {
+        tmp = x0; x0 = x1; x1 = tmp;
+        tmp = y0; y0 = y1; y1 = tmp;
+    }
+
+    int32_t dx = x1 - x0;
+    int32_t gradient = (dx > 0) ? ((int32_t)(y1 - y0) * 65536 / dx) : 0;
+    int32_t intery = (int32_t)y0 * 65536;   // Minor coordinate, 16.16
+    int32_t row = y0;
+
+    // Two spans along the major axis: minor lines 'row' (lead) and 'row + 1' (trail)
+    ST7789_Span spans[2];
+    ST7789_Span *lead = &spans[0];
+    ST7789_Span *trail = &spans[1];
+
+    lead->len = trail->len = 0;
+    lead->vertical = trail->vertical = steep;
+
+    for (int32_t x = x0; x <= x1; x++, intery += gradient)
+    {
+        int32_t y = intery >> 16;
+        uint32_t frac = (intery >> 11) & 31;
+
+        // Moved to the next minor line: the one left behind is complete
+        if (y != row)
+        {
+            ST7789_SpanFlush((y > row) ? lead : trail);
+
+            ST7789_Span *swap = lead;
+            lead = trail;
+            trail = swap;
+            row = y;
+        }
+
+        if (steep)
+        {
+            ST7789_SpanPut(lead, y, x, palette[32 - frac]);
+            if (frac) ST7789_SpanPut(trail, y + 1, x, palette[frac]);
+        }
+        else
+        {
+            ST7789_SpanPut(lead, x, y, palette[32 - frac]);
+            if (frac) ST7789_SpanPut(trail, x, y + 1, palette[frac]);
+        }
+    }
+
+    ST7789_SpanFlush(lead);
+    ST7789_SpanFlush(trail);
+}
+
+/**
+ * @brief Draw thick line as a filled quadrilateral
+ */
+void ST7789_DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                          uint16_t width, uint16_t color)
+{
+    if (width == 0) return;
+
+    if (width == 1 && x0 >= 0 && y0 >= 0 && x1 >= 0 && y1 >= 0)
+    {
+        ST7789_DrawLine(x0, y0, x1, y1, color);
+        return;
+    }
+
+    int32_t dx = x1 - x0;
+    int32_t dy = y1 - y0;
+    uint32_t len = ST7789_Sqrt(((uint64_t)dx * dx + (uint64_t)dy * dy) << 16);    // 24.8
+
+    if (len == 0)
+    {
+        int32_t half = width / 2;
+        ST7789_FillClipped(x0 - half, y0 - half, x0 - half + width - 1, y0 - half + width - 1, color);
+        return;
+    }
+
+    // Half-width normal and half-pixel extension along the line (24.8)
+    int32_t nx = (int32_t)((int64_t)-dy * width * 32768 / len);
+    int32_t ny = (int32_t)((int64_t)dx * width * 32768 / len);
+    int32_t tx = (int32_t)((int64_t)dx * 32768 / len);
+    int32_t ty = (int32_t)((int64_t)dy * 32768 / len);
+
+    int32_t ax = x0 * 256 + 128 - tx, ay = y0 * 256 + 128 - ty;
+    int32_t bx = x1 * 256 + 128 + tx, by = y1 * 256 + 128 + ty;
+
+    int32_t xs[4] = {ax + nx, bx + nx, bx - nx, ax - nx};
+    int32_t ys[4] = {ay + ny, by + ny, by - ny, ay - ny};
+
+    ST7789_FillConvex(xs, ys, 4, color);
+}
+
+/**
+ * @brief Draw rounded rectangle outline
+ */
+void ST7789_DrawRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color)
+{
+    if (w == 0 || h == 0) return;
+
+    uint16_t r_max = ((w < h) ? w : h) / 2;
+    if (r > r_max) r = r_max;
+
+    // Corner circle centers
+    int32_t cxl = x + r, cxr = x + w - 1 - r;
+    int32_t cyt = y + r, cyb = y + h - 1 - r;
+
+    // Straight edges
+    ST7789_DrawSpan(cxl, cxr, y, color);
+    ST7789_DrawSpan(cxl, cxr, y + h - 1, color);
+    ST7789_DrawVSpan(x, cyt, cyb, color);
+    ST7789_DrawVSpan(x + w - 1, cyt, cyb, color);
+
+    // Corners: each row of a quarter circle is one run
+    for (uint16_t dy = 1; dy <= r; dy++)
+    {
+        int32_t hi = ST7789_CircleHalfWidth(r, dy);
+        int32_t lo = (dy < r) ? ST7789_CircleHalfWidth(r, dy + 1) + 1 : 0;
+        if (lo > hi) lo = hi;
+
+        ST7789_DrawSpan(cxl - hi, cxl - lo, cyt - dy, color);
+        ST7789_DrawSpan(cxr + lo, cxr + hi, cyt - dy, color);
+        ST7789_DrawSpan(cxl - hi, cxl - lo, cyb + dy, color);
+        ST7789_DrawSpan(cxr + lo, cxr + hi, cyb + dy, color);
+    }
+}
+
+/**
+ * @brief Fill rounded rectangle
+ */
+void ST7789_FillRoundRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t r, uint16_t color)
+{
+    if (w == 0 || h == 0) return;
+
+    uint16_t r_max = ((w < h) ? w : h) / 2;
+    if (r > r_max) r = r_max;
+
+    int32_t cxl = x + r, cxr = x + w - 1 - r;
+    int32_t cyt = y + r, cyb = y + h - 1 - r;
+
+    // Middle band in one window, corner rows as spans
+    ST7789_FillClipped(x, cyt, x + w - 1, cyb, color);
+
+    for (uint16_t dy = 1; dy <= r; dy++)
+    {
+        int32_t hw = ST7789_CircleHalfWidth(r, dy);
+
+        ST7789_DrawSpan(cxl - hw, cxr + hw, cyt - dy, color);
+        ST7789_DrawSpan(cxl - hw, cxr + hw, cyb + dy, color);
+    }
+}
+
+/**
+ * @brief Fill ring segment
+ */
+void ST7789_FillArc(int16_t x0, int16_t y0, uint16_t r_outer, uint16_t r_inner,
+                    int16_t start, int16_t end, uint16_t color)
+{
+    if (r_inner > r_outer)
+    {
+        uint16_t tmp = r_inner;
+        r_inner = r_outer;
+        r_outer = tmp;
+    }
+
+    int32_t sweep = ((end - start) % 360 + 360) % 360;
+    if (sweep == 0)
+    {
+        if (end == start) return;
+        sweep = 360;
+    }
+
+    // Sector edges (Q14); p is inside when it lies clockwise of s and anticlockwise of e
+    int32_t sx = ST7789_SinQ14(start + 90), sy = ST7789_SinQ14(start);
+    int32_t ex = ST7789_SinQ14(end + 90), ey = ST7789_SinQ14(end);
+    bool full = (sweep >= 360);
+    bool wide = (sweep > 180);
+
+    uint32_t outer2 = (uint32_t)r_outer * r_outer + r_outer;
+    int32_t inner2 = (r_inner > 0) ? (int32_t)(r_inner - 1) * (r_inner - 1) + (r_inner - 1) : -1;
+
+    for (int32_t dy = -(int32_t)r_outer; dy <= r_outer; dy++)
+    {
+        int32_t row = y0 + dy;
+        if (row < 0 || row >= ST7789_HEIGHT) continue;
+
+        int32_t xo = ST7789_Sqrt(outer2 - (uint32_t)(dy * dy));
+        int32_t xi = (inner2 >= dy * dy) ? (int32_t)ST7789_Sqrt(inner2 - dy * dy) : -1;
+
+        // Left and right parts of the ring (one part if the row misses the hole)
+        int32_t parts[2][2] = {{-xo, (xi < 0) ? xo : -xi - 1}, {xi + 1, xo}};
+        uint8_t count = (xi < 0) ? 1 : 2;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            int32_t a = parts[i][0], b = parts[i][1];
+
+            // Visible columns only
+            if (a < -x0) a = -x0;
+            if (b > ST7789_WIDTH - 1 - x0) b = ST7789_WIDTH - 1 - x0;
+            if (a > b) continue;
+
+            if (full)
+            {
+                ST7789_DrawSpan(x0 + a, x0 + b, row, color);
+                continue;
+            }
+
+            // Cross products with the sector edges, stepped along the row
+            int32_t cs = sx * dy - sy * a;
+            int32_t ce = a * ey - dy * ex;
+            int32_t run = INT32_MIN;
+
+            for (int32_t px = a; px <= b; px++, cs -= sy, ce += ey)
+            {
+                bool inside = wide ? (cs >= 0 || ce >= 0) : (cs >= 0 && ce >= 0);
+
+                if (inside && run == INT32_MIN)
+                {
+                    run = px;
+                }
+                else if (!inside && run != INT32_MIN)
+                {
+                    ST7789_DrawSpan(x0 + run, x0 + px - 1, row, color);
+                    run = INT32_MIN;
+                }
+            }
+
+            if (run != INT32_MIN) ST7789_DrawSpan(x0 + run, x0 + b, row, color);
+        }
+    }
+}
+
+/**
+ * @brief Draw 1-pixel circular arc
+ */
+void ST7789_DrawArc(int16_t x0, int16_t y0, uint16_t r, int16_t start, int16_t end, uint16_t color)
+{
+    ST7789_FillArc(x0, y0, r, r, start, end, color);
+}
+
+/**
+ * @brief Draw image from array
+ */
+void ST7789_DrawImage(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *data)
+{
+    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
+
+    if (ST7789_BlitBegin(x, y, w, h, ST7789_ORDER_SPI))
+    {
+        ST7789_BlitWrite(data, (uint32_t)w * h);
+    }
 
-    ST7789_DrawPixel(x0, y0 + r, color);
-    ST7789_DrawPixel(x0, y0 - r, color);
-    ST7789_DrawPixel(x0 + r, y0, color);
-    ST7789_DrawPixel(x0 - r, y0, color);
+    ST7789_BlitEnd();
+}
+
+/**
+ * @brief Start streaming an image
+ */
+bool ST7789_BlitBegin(int16_t x, int16_t y, uint16_t w, uint16_t h, ST7789_PixelOrder order)
+{
+    // Visible part in source coordinates
+    int32_t x0 = (x < 0) ? -x : 0;
+    int32_t y0 = (y < 0) ? -y : 0;
+    int32_t x1 = (int32_t)ST7789_WIDTH - x;
+    int32_t y1 = (int32_t)ST7789_HEIGHT - y;
+
+    if (x1 > w) x1 = w;
+    if (y1 > h) y1 = h;
+
+    bool visible = (x0 < x1 && y0 < y1);
+
+    if (!visible)
+    {
+        // No row matches: every write is dropped
+        x0 = x1 = 0;
+        y0 = y1 = 0;
+    }
+
+    blit.x = x;
+    blit.y = y;
+    blit.w = w;
+    blit.h = h;
+    blit.col = 0;
+    blit.row = 0;
+    blit.x0 = x0;
+    blit.x1 = x1;
+    blit.y0 = y0;
+    blit.y1 = y1;
+    blit.swap = (order == ST7789_ORDER_NATIVE);
+    #ifdef ST7789_USE_DMA
+    blit.buffer = DMA_NO_BUFFER;
+    blit.fill = 0;
+    #endif
+
+    if (!visible) return false;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    // Previous flush may still be reading the framebuffer
+    ST7789_WaitIdle();
+    #else
+    ST7789_SetWindow(x + x0, y + y0, x + x1 - 1, y + y1 - 1);
 
-    while (x < y)
+    #ifdef ST7789_USE_SPI_16BIT
+    // Native pixels are already in 16-bit frame order
+    if (blit.swap)
     {
-        if (f >= 0)
-        {
-            y--;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        x++;
-        ddF_x += 2;
-        f += ddF_x;
-
-        ST7789_DrawPixel(x0 + x, y0 + y, color);
-        ST7789_DrawPixel(x0 - x, y0 + y, color);
-        ST7789_DrawPixel(x0 + x, y0 - y, color);
-        ST7789_DrawPixel(x0 - x, y0 - y, color);
-        ST7789_DrawPixel(x0 + y, y0 + x, color);
-        ST7789_DrawPixel(x0 - y, y0 + x, color);
-        ST7789_DrawPixel(x0 + y, y0 - x, color);
-        ST7789_DrawPixel(x0 - y, y0 - x, color);
+        ST7789_SetFrameSize(true);
+        blit.swap = false;
     }
+    #endif
+    #endif
+
+    return true;
 }
 
 /**
- * @brief Draw filled circle
+ * @brief Push the next image pixels
  */
-void ST7789_FillCircle(uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+void ST7789_BlitWrite(const uint16_t *pixels, uint32_t count)
 {
-    if (r == 0) return;
+    while (count > 0 && blit.row < blit.h)
+    {
+        bool row_visible = (blit.row >= blit.y0 && blit.row < blit.y1);
 
-    int16_t x = 0;
-    int16_t y = r;
-    int16_t d = 3 - 2 * r;  // Midpoint decision parameter
+        #ifndef ST7789_USE_FRAMEBUFFER
+        // Full-width visible rows are contiguous in the window: send them in one go
+        if (row_visible && blit.x0 == 0 && blit.x1 == blit.w)
+        {
+            uint32_t run = (uint32_t)(blit.y1 - blit.row) * blit.w - blit.col;
+            if (run > count) run = count;
 
-    while (y >= x)
-    {
-        ST7789_DrawHorizontalLine(x0, y0 + y, x0 - x, x0 + x, color);  // Bottom
-        ST7789_DrawHorizontalLine(x0, y0 - y, x0 - x, x0 + x, color);  // Up
+            ST7789_BlitEmit(blit.col, pixels, run);
 
-        if (x != y) {
-            ST7789_DrawHorizontalLine(x0, y0 + x, x0 - y, x0 + y, color);  // Bottom
-            ST7789_DrawHorizontalLine(x0, y0 - x, x0 - y, x0 + y, color);  // Up
+            uint32_t pos = blit.col + run;
+            blit.row += pos / blit.w;
+            blit.col = pos % blit.w;
+            pixels += run;
+            count -= run;
+            continue;
         }
+        #endif
 
-        // Update follow Midpoint Circle Algorithm
-        if (d < 0)
+        // Rest of the current source row
+        uint32_t take = blit.w - blit.col;
+        if (take > count) take = count;
+
+        if (row_visible)
         {
-            d = d + 4 * x + 6;
+            uint32_t a = (blit.col > blit.x0) ? blit.col : blit.x0;
+            uint32_t b = (blit.col + take < blit.x1) ? blit.col + take : blit.x1;
+
+            if (a < b) ST7789_BlitEmit(a, pixels + (a - blit.col), b - a);
         }
-        else
+
+        pixels += take;
+        count -= take;
+        blit.col += take;
+
+        if (blit.col == blit.w)
         {
-            d = d + 4 * (x - y) + 10;
-            y--;
+            blit.col = 0;
+            blit.row++;
         }
-        x++;
     }
 }
 
 /**
- * @brief Draw triangle outline
+ * @brief Finish the image
  */
-void ST7789_DrawTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
-                         uint16_t x3, uint16_t y3, uint16_t color)
+void ST7789_BlitEnd(void)
 {
-    ST7789_DrawLine(x1, y1, x2, y2, color);
-    ST7789_DrawLine(x2, y2, x3, y3, color);
-    ST7789_DrawLine(x3, y3, x1, y1, color);
+    #ifdef ST7789_USE_FRAMEBUFFER
+    uint16_t y = blit.y + blit.y0;
+    uint16_t h = blit.y1 - blit.y0;
+
+    if (h > 0 && ST7789_FbClip(&y, &h))
+    {
+        ST7789_FbMarkDirty(blit.x + blit.x0, y, blit.x1 - blit.x0, h);
+    }
+    #else
+    #ifdef ST7789_USE_DMA
+    if (blit.buffer != DMA_NO_BUFFER && blit.fill > 0)
+    {
+        ST7789_WriteBuffer(blit.buffer, blit.fill * 2);
+    }
+    blit.buffer = DMA_NO_BUFFER;
+    #endif
+
+    #ifdef ST7789_USE_SPI_16BIT
+    ST7789_SetFrameSize(false);
+    #endif
+    #endif
+
+    // Late writes are dropped
+    blit.y0 = blit.y1 = 0;
 }
 
 /**
- * @brief Draw filled triangle
+ * @brief Stream an image from a source callback
  */
-void ST7789_FillTriangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
-                         uint16_t x3, uint16_t y3, uint16_t color)
+void ST7789_BlitStream(int16_t x, int16_t y, uint16_t w, uint16_t h, ST7789_PixelOrder order,
+                       ST7789_BlitSource source, void *context)
 {
-    int16_t deltax = ABS(x2 - x1);
-    int16_t deltay = ABS(y2 - y1);
-    int16_t x = x1, y = y1;
-    int16_t xinc1, xinc2, yinc1, yinc2;
-    int16_t den, num, numadd, numpixels;
+    uint16_t chunk[BLIT_STREAM_PIXELS];
+    uint32_t remaining = (uint32_t)w * h;
 
-    xinc1 = (x2 >= x1) ? 1 : -1;
-    xinc2 = xinc1;
-    yinc1 = (y2 >= y1) ? 1 : -1;
-    yinc2 = yinc1;
+    ST7789_BlitBegin(x, y, w, h, order);
 
-    if (deltax >= deltay)
-    {
-        xinc1 = 0;
-        yinc2 = 0;
-        den = deltax;
-        num = deltax / 2;
-        numadd = deltay;
-        numpixels = deltax;
-    }
-    else
+    while (remaining > 0)
     {
-        xinc2 = 0;
-        yinc1 = 0;
-        den = deltay;
-        num = deltay / 2;
-        numadd = deltax;
-        numpixels = deltay;
-    }
+        uint32_t max = (remaining > BLIT_STREAM_PIXELS) ? BLIT_STREAM_PIXELS : remaining;
+        uint32_t count = source(chunk, max, context);
 
-    for (int16_t curpixel = 0; curpixel <= numpixels; curpixel++)
-    {
-        ST7789_DrawLine(x, y, x3, y3, color);
+        if (count == 0) break;
+        if (count > max) count = max;
 
-        num += numadd;
-        if (num >= den)
-        {
-            num -= den;
-            x += xinc1;
-            y += yinc1;
-        }
-        x += xinc2;
-        y += yinc2;
+        ST7789_BlitWrite(chunk, count);
+        remaining -= count;
     }
+
+    ST7789_BlitEnd();
 }
 
 /**
- * @brief Draw image from array
+ * @brief Draw a compressed image
  */
-void ST7789_DrawImage(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *data)
+void ST7789_DrawCompressedImage(int16_t x, int16_t y, const ST7789_Image *image)
 {
-    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
-    if (x + w > ST7789_WIDTH || y + h > ST7789_HEIGHT) return;
+    uint16_t w = image->width;
 
-    ST7789_SetWindow(x, y, x + w - 1, y + h - 1);
-    ST7789_WriteData((uint8_t*)data, w * h * 2);
+    decoder.image = image;
+    decoder.data = image->data;
+    decoder.pos = 0;
+    decoder.run = 0;
+
+    if (ST7789_BlitBegin(x, y, w, image->height, ST7789_ORDER_SPI))
+    {
+        ST7789_DecodeSkip((uint32_t)blit.y0 * w);
+
+        for (blit.row = blit.y0; blit.row < blit.y1; blit.row++)
+        {
+            ST7789_DecodeSkip(blit.x0);
+            ST7789_DecodeEmit(blit.x0, blit.x1 - blit.x0);
+            ST7789_DecodeSkip(w - blit.x1);
+        }
+    }
+
+    ST7789_BlitEnd();
 }
 
 #ifdef ST7789_USE_FONTS
@@ -626,25 +4101,7 @@ void ST7789_DrawImage(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint
 void ST7789_WriteChar(uint16_t x, uint16_t y, char ch, FontDef font,
                       uint16_t color, uint16_t bgcolor)
 {
-    if (x + font.width > ST7789_WIDTH || y + font.height > ST7789_HEIGHT) return;
-
-    ST7789_SetWindow(x, y, x + font.width - 1, y + font.height - 1);
-
-    CS_LOW();
-    DC_HIGH();
-
-    for (uint16_t i = 0; i < font.height; i++)
-    {
-        uint16_t line = font.data[(ch - 32) * font.height + i];
-        for (uint16_t j = 0; j < font.width; j++)
-        {
-            uint16_t pixel_color = (line << j) & 0x8000 ? color : bgcolor;
-            uint8_t data[] = {pixel_color >> 8, pixel_color & 0xFF};
-            HAL_SPI_Transmit(&ST7789_SPI_PORT, data, 2, HAL_MAX_DELAY);
-        }
-    }
-
-    CS_HIGH();
+    ST7789_WriteGlyphRun(x, y, &ch, 1, &font, color, bgcolor);
 }
 
 /**
@@ -667,12 +4124,363 @@ void ST7789_WriteString(uint16_t x, uint16_t y, const char *str, FontDef font,
             }
         }
 
-        ST7789_WriteChar(x, y, *str, font, color, bgcolor);
-        x += font.width;
-        str++;
+        // Everything that fits on this line goes out as one glyph run
+        uint16_t count = 0;
+        while (str[count] != '\0' && x + (count + 1) * font.width <= ST7789_WIDTH) count++;
+
+        #ifdef ST7789_USE_GLYPH_CACHE
+        if (count > ST7789_GLYPH_CACHE_ENTRIES) count = ST7789_GLYPH_CACHE_ENTRIES;
+        #endif
+
+        ST7789_WriteGlyphRun(x, y, str, count, &font, color, bgcolor);
+        x += count * font.width;
+        str += count;
+    }
+}
+
+/**
+ * @brief Write string in a proportional font
+ */
+uint16_t ST7789_WriteStringProp(uint16_t x, uint16_t y, const char *str, const PropFontDef *font,
+                                uint16_t color, uint16_t bgcolor)
+{
+    // The palette holds 4 bpp at most; anything else is not a valid font
+    if (font->bpp != 1 && font->bpp != 2 && font->bpp != 4) return x;
+
+    // Blend every alpha level against the background once per string
+    uint16_t palette[16];
+    uint8_t levels = (1 << font->bpp) - 1;
+    int16_t fr = color >> 11, fg = (color >> 5) & 0x3F, fb = color & 0x1F;
+    int16_t br = bgcolor >> 11, bg = (bgcolor >> 5) & 0x3F, bb = bgcolor & 0x1F;
+
+    for (uint8_t a = 0; a <= levels; a++)
+    {
+        uint16_t r = br + ((fr - br) * a + levels / 2) / levels;
+        uint16_t g = bg + ((fg - bg) * a + levels / 2) / levels;
+        uint16_t b = bb + ((fb - bb) * a + levels / 2) / levels;
+        uint16_t c = (r << 11) | (g << 5) | b;
+        palette[a] = (c >> 8) | (c << 8);
+    }
+
+    uint16_t pen = x;
+
+    for (; *str; str++)
+    {
+        if (*str == '\n')
+        {
+            pen = x;
+            y += font->height;
+            continue;
+        }
+
+        const GlyphDef *glyph = ST7789_PropGlyph(font, *str);
+        if (glyph == NULL || glyph->advance == 0) continue;
+
+        if (pen + glyph->advance > ST7789_WIDTH || y + font->height > ST7789_HEIGHT) break;
+
+        ST7789_WritePropGlyph(pen, y, font, glyph, palette);
+        pen += glyph->advance;
+    }
+
+    return pen;
+}
+
+/**
+ * @brief Width of a single line in a proportional font
+ */
+uint16_t ST7789_MeasureStringProp(const char *str, const PropFontDef *font)
+{
+    uint16_t width = 0;
+
+    for (; *str && *str != '\n'; str++)
+    {
+        const GlyphDef *glyph = ST7789_PropGlyph(font, *str);
+        if (glyph != NULL) width += glyph->advance;
+    }
+
+    return width;
+}
+
+#ifdef ST7789_USE_GLYPH_CACHE
+/**
+ * @brief Read glyph cache counters
+ */
+void ST7789_GlyphCacheGetStats(ST7789_GlyphCacheStats *stats)
+{
+    *stats = glyph_stats;
+}
+
+/**
+ * @brief Drop all cached glyphs and reset the counters
+ */
+void ST7789_GlyphCacheClear(void)
+{
+    #ifdef ST7789_USE_DMA
+    ST7789_WaitBusIdle(NULL);
+    #endif
+
+    for (uint8_t i = 0; i < ST7789_GLYPH_CACHE_ENTRIES; i++)
+    {
+        glyph_cache[i].font = NULL;
+    }
+
+    glyph_arena_end = 0;
+    glyph_arena_used = 0;
+    glyph_stats.hits = 0;
+    glyph_stats.misses = 0;
+    glyph_stats.evictions = 0;
+}
+#endif
+#endif
+
+#ifdef ST7789_USE_STATS
+/**
+ * @brief Copy the bus statistics
+ * The DMA interrupt adds to dma_cycles, so the copy is taken with it masked.
+ */
+void ST7789_GetStats(ST7789_Stats *out)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *out = bus_stats;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Clear the bus statistics
+ */
+void ST7789_ResetStats(void)
+{
+    PERF_Init();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memset(&bus_stats, 0, sizeof(bus_stats));
+
+    #ifdef ST7789_USE_DMA
+    // Bursts in flight count from now
+    for (uint8_t i = 0; i < ST7789_MAX_PANELS; i++)
+    {
+        if (dma_panels[i] != NULL) dma_panels[i]->dma_start = PERF_Cycles();
+    }
+    #endif
+
+    __set_PRIMASK(primask);
+}
+#endif
+
+#ifdef ST7789_USE_READBACK
+// ST7789_Screenshot state passed through ST7789_ReadBands
+typedef struct {
+    ST7789_WriteCallback write;
+    void *context;
+    uint8_t padding;        // Bytes after each line (BMP lines are multiples of 4 bytes)
+} ST7789_Screenshot_t;
+
+/**
+ * @brief Store a little-endian value
+ */
+static void ST7789_PutLE(uint8_t *p, uint32_t value, uint8_t bytes)
+{
+    while (bytes--)
+    {
+        *p++ = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+/**
+ * @brief Send the lines of one band as BMP pixel data
+ */
+static void ST7789_ScreenshotBand(const uint16_t *pixels, uint16_t y, uint16_t rows, void *context)
+{
+    static const uint8_t zeros[3] = {0, 0, 0};
+    const ST7789_Screenshot_t *shot = context;
+
+    (void)y;
+
+    // BMP stores 16-bit pixels little-endian, as they are in RAM
+    for (uint16_t row = 0; row < rows; row++)
+    {
+        shot->write((const uint8_t*)&pixels[row * ST7789_WIDTH], ST7789_WIDTH * 2, shot->context);
+
+        if (shot->padding > 0)
+        {
+            shot->write(zeros, shot->padding, shot->context);
+        }
+    }
+}
+
+/**
+ * @brief Read the display ID
+ */
+uint32_t ST7789_ReadID(void)
+{
+    uint8_t cmd = ST7789_RDDID;
+    uint8_t rx[4];
+
+    ST7789_WaitIdle();
+
+    STATS_ADD(commands, 1);
+    TRACE_HOOK(TRACE_LCD_COMMAND, cmd);
+
+    CS_LOW();
+    DC_LOW();
+    ST7789_SpiWrite(&cmd, 1);
+    DC_HIGH();
+    ST7789_SpiRead(rx, sizeof(rx));
+    CS_HIGH();
+
+    // One dummy clock, then 24 ID bits
+    uint32_t raw = ((uint32_t)rx[0] << 24) | ((uint32_t)rx[1] << 16) | ((uint32_t)rx[2] << 8) | rx[3];
+    return (raw >> 7) & 0xFFFFFF;
+}
+
+/**
+ * @brief Read a screen area into RAM
+ */
+bool ST7789_ReadRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *buffer)
+{
+    if (w == 0 || h == 0 || x + w > ST7789_WIDTH || y + h > ST7789_HEIGHT) return false;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    ST7789_Flush();
+    #endif
+
+    ST7789_ReadWindow(x, y, x + w - 1, y + h - 1, buffer, (uint32_t)w * h);
+    return true;
+}
+
+/**
+ * @brief Read a screen area band by band
+ */
+bool ST7789_ReadBands(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                      uint16_t *buffer, uint32_t buffer_pixels,
+                      ST7789_ReadCallback callback, void *context)
+{
+    if (w == 0 || h == 0 || x + w > ST7789_WIDTH || y + h > ST7789_HEIGHT || buffer_pixels < w) return false;
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    ST7789_Flush();
+    #endif
+
+    uint32_t band_rows = buffer_pixels / w;
+
+    for (uint16_t row = 0; row < h; )
+    {
+        uint32_t left = h - row;
+        uint16_t rows = (left > band_rows) ? band_rows : left;
+
+        ST7789_ReadWindow(x, y + row, x + w - 1, y + row + rows - 1, buffer, (uint32_t)w * rows);
+        callback(buffer, y + row, rows, context);
+
+        row += rows;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stream the screen as a BMP file
+ */
+void ST7789_Screenshot(ST7789_WriteCallback write, void *context)
+{
+    uint16_t line[ST7789_MAX_WIDTH];
+    uint8_t header[66];
+
+    uint32_t line_bytes = ((uint32_t)ST7789_WIDTH * 2 + 3) & ~3UL;
+    uint32_t image_bytes = line_bytes * ST7789_HEIGHT;
+
+    // BITMAPFILEHEADER
+    memset(header, 0, sizeof(header));
+    header[0] = 'B';
+    header[1] = 'M';
+    ST7789_PutLE(&header[2], sizeof(header) + image_bytes, 4);
+    ST7789_PutLE(&header[10], sizeof(header), 4);
+
+    // BITMAPINFOHEADER: negative height = top-down lines, BI_BITFIELDS with RGB565 masks
+    ST7789_PutLE(&header[14], 40, 4);
+    ST7789_PutLE(&header[18], ST7789_WIDTH, 4);
+    ST7789_PutLE(&header[22], (uint32_t)-(int32_t)ST7789_HEIGHT, 4);
+    ST7789_PutLE(&header[26], 1, 2);
+    ST7789_PutLE(&header[28], 16, 2);
+    ST7789_PutLE(&header[30], 3, 4);
+    ST7789_PutLE(&header[34], image_bytes, 4);
+    ST7789_PutLE(&header[38], 2835, 4);
+    ST7789_PutLE(&header[42], 2835, 4);
+    ST7789_PutLE(&header[54], 0xF800, 4);
+    ST7789_PutLE(&header[58], 0x07E0, 4);
+    ST7789_PutLE(&header[62], 0x001F, 4);
+
+    ST7789_Screenshot_t shot = {write, context, line_bytes - ST7789_WIDTH * 2};
+
+    write(header, sizeof(header), context);
+    ST7789_ReadBands(0, 0, ST7789_WIDTH, ST7789_HEIGHT, line, ST7789_MAX_WIDTH, ST7789_ScreenshotBand, &shot);
+}
+
+#ifndef ST7789_USE_FRAMEBUFFER
+/**
+ * @brief Invert an area of the screen in place
+ */
+void ST7789_InvertRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    if (x >= ST7789_WIDTH || y >= ST7789_HEIGHT) return;
+
+    if (x + w > ST7789_WIDTH) w = ST7789_WIDTH - x;
+
+    if (y + h > ST7789_HEIGHT) h = ST7789_HEIGHT - y;
+
+    if (w == 0 || h == 0) return;
+
+    #ifdef ST7789_USE_DMA
+    // Bands as large as a line buffer, to save window and RAMRD setups. They do
+    // not overlap: the read of the next band waits for this write to drain.
+    uint32_t band_rows = DMA_BUFFER_PIXELS / w;
+    #else
+    uint16_t line[ST7789_MAX_WIDTH];
+    uint32_t band_rows = 1;
+    #endif
+
+    for (uint16_t row = 0; row < h; )
+    {
+        uint32_t left = h - row;
+        uint16_t rows = (left > band_rows) ? band_rows : left;
+        uint32_t pixels = (uint32_t)w * rows;
+
+        #ifdef ST7789_USE_DMA
+        uint8_t idx = ST7789_AcquireBuffer();
+        uint16_t *band = dma_buffer[idx];
+        dma_buffer_fill[idx] = 0;
+        #else
+        uint16_t *band = line;
+        #endif
+
+        ST7789_ReadWindow(x, y + row, x + w - 1, y + row + rows - 1, band, pixels);
+
+        // Inverted, back in SPI byte order
+        for (uint32_t i = 0; i < pixels; i++)
+        {
+            uint16_t color = ~band[i];
+            band[i] = (color >> 8) | (color << 8);
+        }
+
+        // Same window: only RAMWR goes out
+        ST7789_SetWindow(x, y + row, x + w - 1, y + row + rows - 1);
+
+        #ifdef ST7789_USE_DMA
+        ST7789_WriteBuffer(idx, pixels * 2);
+        #else
+        ST7789_WriteData((const uint8_t*)band, pixels * 2);
+        #endif
+
+        row += rows;
     }
 }
 #endif
+#endif
 
 /**
  * @brief Convert RGB to RGB565
@@ -0,0 +1,372 @@
+/**
+ * @file st7789_bench.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "st7789_bench.h"
+#include "perf.h"
+#include "testimg.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ============== PRIVATE DEFINES ============== */
+
+// Result table
+#define BENCH_MAX_TESTS 16
+
+#ifdef ST7789_BENCH_UART
+extern UART_HandleTypeDef ST7789_BENCH_UART;
+#endif
+
+/* ============== PRIVATE VARIABLES ============== */
+
+// One benchmark: run(op index, arg) draws once and returns the pixels drawn
+typedef struct {
+    const char *name;
+    uint32_t (*run)(uint32_t i, uint32_t arg);
+    uint32_t arg;
+} ST7789_BenchTest;
+
+#ifdef ST7789_USE_FONTS
+static const char bench_text[] = "ST7789 bench";
+#endif
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Color that changes every op (defeats the solid fill cache)
+ */
+static uint16_t ST7789_BenchColor(uint32_t i)
+{
+    return ST7789_Color565(i * 37, i * 91, i * 53) | 0x0821;
+}
+
+static uint32_t ST7789_BenchFillScreen(uint32_t i, uint32_t arg)
+{
+    (void)arg;
+    ST7789_FillScreen(ST7789_BenchColor(i));
+    return (uint32_t)ST7789_WIDTH * ST7789_HEIGHT;
+}
+
+static uint32_t ST7789_BenchFillRect(uint32_t i, uint32_t size)
+{
+    uint16_t x = (i * 37) % (ST7789_WIDTH - size + 1);
+    uint16_t y = (i * 23) % (ST7789_HEIGHT - size + 1);
+
+    ST7789_FillRect(x, y, size, size, ST7789_BenchColor(i));
+    return size * size;
+}
+
+static uint32_t ST7789_BenchDrawPixel(uint32_t i, uint32_t arg)
+{
+    (void)arg;
+    ST7789_DrawPixel((i * 7) % ST7789_WIDTH, (i * 13) % ST7789_HEIGHT, ST7789_BenchColor(i));
+    return 1;
+}
+
+static uint32_t ST7789_BenchDrawLine(uint32_t i, uint32_t arg)
+{
+    (void)arg;
+    uint16_t x0 = i % ST7789_WIDTH;
+    uint16_t x1 = ST7789_WIDTH - 1 - x0;
+    uint32_t dx = (x0 > x1) ? x0 - x1 : x1 - x0;
+    uint32_t dy = ST7789_HEIGHT - 1;
+
+    ST7789_DrawLine(x0, 0, x1, dy, ST7789_BenchColor(i));
+    return ((dx > dy) ? dx : dy) + 1;
+}
+
+static uint32_t ST7789_BenchFillCircle(uint32_t i, uint32_t r)
+{
+    ST7789_FillCircle(r + i % (ST7789_WIDTH - 2 * r), ST7789_HEIGHT / 2, r, ST7789_BenchColor(i));
+    return 355 * r * r / 113;
+}
+
+static uint32_t ST7789_BenchFillTriangle(uint32_t i, uint32_t size)
+{
+    uint16_t x = i % (ST7789_WIDTH - size + 1);
+
+    ST7789_FillTriangle(x, 0, x + size - 1, size - 1, x, size - 1, ST7789_BenchColor(i));
+    return size * (size + 1) / 2;
+}
+
+#ifdef ST7789_USE_FONTS
+static uint32_t ST7789_BenchWriteString(uint32_t i, uint32_t arg)
+{
+    const FontDef *font = (arg == 0) ? &Font_7x10 : (arg == 1) ? &Font_11x18 : &Font_16x26;
+    uint16_t width = (sizeof(bench_text) - 1) * font->width;
+
+    ST7789_WriteString(i % (ST7789_WIDTH - width + 1), (i * font->height) % (ST7789_HEIGHT - font->height + 1),
+                       bench_text, *font, ST7789_BenchColor(i), ST7789_BLACK);
+    return (uint32_t)width * font->height;
+}
+#endif
+
+static uint32_t ST7789_BenchDrawImage(uint32_t i, uint32_t arg)
+{
+    (void)arg;
+    ST7789_DrawImage(i % (ST7789_WIDTH - CAT_MEME_WIDTH + 1), (ST7789_HEIGHT - CAT_MEME_HEIGHT) / 2,
+                     CAT_MEME_WIDTH, CAT_MEME_HEIGHT, cat_meme);
+    return CAT_MEME_WIDTH * CAT_MEME_HEIGHT;
+}
+
+static const ST7789_BenchTest bench_tests[] = {
+    {"FillScreen", ST7789_BenchFillScreen, 0},
+    {"Rect 8", ST7789_BenchFillRect, 8},
+    {"Rect 32", ST7789_BenchFillRect, 32},
+    {"Rect 100", ST7789_BenchFillRect, 100},
+    {"DrawPixel", ST7789_BenchDrawPixel, 0},
+    {"DrawLine", ST7789_BenchDrawLine, 0},
+    {"FillCircle", ST7789_BenchFillCircle, 30},
+    {"FillTri", ST7789_BenchFillTriangle, 100},
+#ifdef ST7789_USE_FONTS
+    {"Text 7x10", ST7789_BenchWriteString, 0},
+    {"Text 11x18", ST7789_BenchWriteString, 1},
+    {"Text 16x26", ST7789_BenchWriteString, 2},
+#endif
+    {"DrawImage", ST7789_BenchDrawImage, 0},
+};
+
+#define BENCH_TESTS (sizeof(bench_tests) / sizeof(bench_tests[0]))
+
+/**
+ * @brief Send one report line to ITM / UART
+ */
+static void ST7789_BenchPrint(const char *line)
+{
+    #ifdef ST7789_BENCH_ITM
+    for (const char *p = line; *p; p++)
+    {
+        ITM_SendChar(*p);
+    }
+    ITM_SendChar('\n');
+    #endif
+
+    #ifdef ST7789_BENCH_UART
+    HAL_UART_Transmit(&ST7789_BENCH_UART, (uint8_t*)line, strlen(line), HAL_MAX_DELAY);
+    HAL_UART_Transmit(&ST7789_BENCH_UART, (uint8_t*)"\r\n", 2, HAL_MAX_DELAY);
+    #endif
+
+    (void)line;
+}
+
+/**
+ * @brief Format a result as: name, us per op, kilopixels/s, MB/s of pixel data
+ */
+static void ST7789_BenchFormat(char *buffer, size_t size, const ST7789_BenchResult *r)
+{
+    uint64_t cycles = r->cycles ? r->cycles : 1;
+    uint32_t us10 = (uint32_t)(cycles * 10000000 / SystemCoreClock / r->ops);
+    uint32_t kpix = (uint32_t)((uint64_t)r->pixels * SystemCoreClock / cycles / 1000);
+    uint32_t kbytes = kpix * 2;
+
+    snprintf(buffer, size, "%-11s%6lu.%lu%7lu%4lu.%02lu", r->name,
+             (unsigned long)(us10 / 10), (unsigned long)(us10 % 10), (unsigned long)kpix,
+             (unsigned long)(kbytes / 1000), (unsigned long)(kbytes % 1000 / 10));
+}
+
+/**
+ * @brief Set the display SPI clock (takes effect on the next transfer)
+ */
+static void ST7789_BenchSetPrescaler(uint32_t prescaler)
+{
+    SPI_HandleTypeDef *hspi = st7789_current->spi;
+
+    ST7789_WaitIdle();
+
+    #ifdef ST7789_USE_SPI_BUS
+    // The arbiter switches the clock when it hands the bus over
+    if (st7789_current->bus_dev.bus != NULL)
+    {
+        st7789_current->bus_dev.prescaler = prescaler & SPI_CR1_BR;
+        return;
+    }
+    #endif
+
+    while (hspi->Instance->SR & SPI_SR_BSY);
+
+    __HAL_SPI_DISABLE(hspi);
+    hspi->Instance->CR1 = (hspi->Instance->CR1 & ~SPI_CR1_BR) | (prescaler & SPI_CR1_BR);
+    hspi->Init.BaudRatePrescaler = prescaler & SPI_CR1_BR;
+}
+
+/**
+ * @brief Display SPI prescaler (SPI_BAUDRATEPRESCALER_* value)
+ */
+static uint32_t ST7789_BenchGetPrescaler(void)
+{
+    #ifdef ST7789_USE_SPI_BUS
+    if (st7789_current->bus_dev.bus != NULL) return st7789_current->bus_dev.prescaler;
+    #endif
+
+    return st7789_current->spi->Init.BaudRatePrescaler & SPI_CR1_BR;
+}
+
+/**
+ * @brief Clock of the APB bus the display SPI sits on
+ * SPI2 and SPI3 are on APB1; SPI1 (and SPI4-6 where present) on APB2.
+ */
+static uint32_t ST7789_BenchBusClock(void)
+{
+    SPI_TypeDef *spi = st7789_current->spi->Instance;
+
+    #ifdef SPI2
+    if (spi == SPI2) return HAL_RCC_GetPCLK1Freq();
+    #endif
+    #ifdef SPI3
+    if (spi == SPI3) return HAL_RCC_GetPCLK1Freq();
+    #endif
+
+    (void)spi;
+    return HAL_RCC_GetPCLK2Freq();
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Time every test
+ */
+uint8_t ST7789_BenchmarkRun(ST7789_BenchResult *results, uint8_t max)
+{
+    uint32_t min_cycles = (SystemCoreClock / 1000) * ST7789_BENCH_MIN_MS;
+    uint8_t count = 0;
+
+    PERF_Init();
+
+    for (uint8_t t = 0; t < BENCH_TESTS && count < max; t++)
+    {
+        const ST7789_BenchTest *test = &bench_tests[t];
+        ST7789_BenchResult *r = &results[count++];
+
+        ST7789_FillScreen(ST7789_BLACK);
+        #ifdef ST7789_USE_FRAMEBUFFER
+        ST7789_Flush();
+        #endif
+        ST7789_WaitIdle();
+
+        r->name = test->name;
+        r->ops = 0;
+        r->pixels = 0;
+
+        #ifdef ST7789_USE_STATS
+        ST7789_ResetStats();
+        #endif
+
+        uint32_t start = PERF_Cycles();
+
+        do
+        {
+            r->pixels += test->run(r->ops, test->arg);
+            r->ops++;
+
+            // Every op has to reach the panel
+            #ifdef ST7789_USE_FRAMEBUFFER
+            ST7789_Flush();
+            #endif
+        } while (r->ops < ST7789_BENCH_MIN_OPS || PERF_Cycles() - start < min_cycles);
+
+        ST7789_WaitIdle();
+        r->cycles = PERF_Cycles() - start;
+
+        #ifdef ST7789_USE_STATS
+        ST7789_Stats stats;
+        ST7789_GetStats(&stats);
+        r->windows = stats.windows;
+        r->blocked = (uint32_t)stats.blocked_cycles;
+        r->dma = (uint32_t)stats.dma_cycles;
+        #endif
+    }
+
+    return count;
+}
+
+/**
+ * @brief Run and report the benchmark
+ */
+void ST7789_Benchmark(void)
+{
+    ST7789_BenchResult results[BENCH_MAX_TESTS];
+    char buffer[64];
+
+    uint8_t count = ST7789_BenchmarkRun(results, BENCH_MAX_TESTS);
+
+    uint32_t prescaler = 2UL << (ST7789_BenchGetPrescaler() >> SPI_CR1_BR_Pos);
+    uint32_t spi_khz = ST7789_BenchBusClock() / prescaler / 1000;
+
+    // Build configuration, so reports from different builds can be told apart
+    char config[48];
+    snprintf(config, sizeof(config), "SPI %lu kHz (/%lu) DMA %s FB %s",
+             (unsigned long)spi_khz, (unsigned long)prescaler,
+    #ifdef ST7789_USE_DMA
+             "on",
+    #else
+             "off",
+    #endif
+    #ifdef ST7789_USE_FRAMEBUFFER
+             "on");
+    #else
+             "off");
+    #endif
+
+    static const char header[] = "test          us/op  kpx/s   MB/s";
+
+    ST7789_BenchPrint("ST7789 benchmark");
+    ST7789_BenchPrint(config);
+    ST7789_BenchPrint(header);
+
+    ST7789_FillScreen(ST7789_BLACK);
+
+    #ifdef ST7789_USE_FONTS
+    ST7789_WriteString(4, 4, "ST7789 benchmark", Font_11x18, ST7789_YELLOW, ST7789_BLACK);
+    ST7789_WriteString(4, 26, config, Font_7x10, ST7789_CYAN, ST7789_BLACK);
+    ST7789_WriteString(4, 40, header, Font_7x10, ST7789_GRAY, ST7789_BLACK);
+    #endif
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        ST7789_BenchFormat(buffer, sizeof(buffer), &results[i]);
+        ST7789_BenchPrint(buffer);
+
+        #ifdef ST7789_USE_FONTS
+        ST7789_WriteString(4, 52 + i * 12, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
+        #endif
+    }
+
+    #ifdef ST7789_USE_STATS
+    ST7789_BenchPrint("test       win/op px/win blocked%  dma%");
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        const ST7789_BenchResult *r = &results[i];
+        uint64_t cycles = r->cycles ? r->cycles : 1;
+
+        snprintf(buffer, sizeof(buffer), "%-11s%6lu%7lu%9lu%6lu", r->name,
+                 (unsigned long)(r->windows / r->ops),
+                 (unsigned long)(r->windows ? r->pixels / r->windows : 0),
+                 (unsigned long)(r->blocked * 100ULL / cycles),
+                 (unsigned long)(r->dma * 100ULL / cycles));
+        ST7789_BenchPrint(buffer);
+    }
+    #endif
+
+    #ifdef ST7789_USE_FRAMEBUFFER
+    ST7789_Flush();
+    #endif
+}
+
+/**
+ * @brief Run the benchmark at several SPI clocks
+ */
+void ST7789_BenchmarkSweep(const uint32_t *prescalers, uint8_t count)
+{
+    uint32_t original = ST7789_BenchGetPrescaler();
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        ST7789_BenchSetPrescaler(prescalers[i]);
+        ST7789_Benchmark();
+    }
+
+    ST7789_BenchSetPrescaler(original);
+}
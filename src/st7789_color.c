@@ -0,0 +1,333 @@
+/**
+ * @file st7789_color.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "st7789_color.h"
+#include <stddef.h>
+
+/* ============== PRIVATE DEFINES ============== */
+
+// Pixels converted per ST7789_BlitWrite() call (stack buffers)
+#define COLOR_CHUNK     64
+
+/* ============== PRIVATE VARIABLES ============== */
+
+// 4x4 Bayer matrix, 0..15
+static const uint8_t color_bayer[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5}
+};
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Per-byte saturating add of two 0x00RRGGBB words
+ */
+static inline uint32_t ST7789_ColorAddSat(uint32_t a, uint32_t b)
+{
+    #ifdef __ARM_FEATURE_DSP
+    return __UQADD8(a, b);
+    #else
+    // Add the low 7 bits, fix up bit 7, then force bytes that carried out to 0xFF
+    uint32_t sum = ((a & 0x7F7F7F7F) + (b & 0x7F7F7F7F)) ^ ((a ^ b) & 0x80808080);
+    uint32_t carry = ((a & b) | ((a | b) & ~sum)) & 0x80808080;
+
+    return sum | ((carry >> 7) * 0xFF);
+    #endif
+}
+
+/**
+ * @brief 0x00RRGGBB to RGB565 (truncating)
+ */
+static inline uint32_t ST7789_ColorTo565(uint32_t rgb)
+{
+    return ((rgb >> 8) & 0xF800) | ((rgb >> 5) & 0x07E0) | ((rgb >> 3) & 0x001F);
+}
+
+/**
+ * @brief Dither offsets for the four columns of a matrix row
+ * Red and blue lose 3 bits (offset 0..7), green loses 2 (offset 0..3).
+ */
+static void ST7789_ColorDitherRow(uint32_t offsets[4], uint16_t y)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        uint32_t t = color_bayer[y & 3][i];
+
+        offsets[i] = ((t >> 1) << 16) | ((t >> 2) << 8) | (t >> 1);
+    }
+}
+
+/**
+ * @brief Load pixel i from an RGB888 or 0xAARRGGBB source
+ */
+static inline uint32_t ST7789_ColorLoad(const uint8_t *rgb, const uint32_t *argb, uint32_t i)
+{
+    if (rgb)
+    {
+        const uint8_t *p = rgb + i * 3;
+        return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    }
+
+    return argb[i];
+}
+
+/**
+ * @brief Shared conversion loop: two pixels per 32-bit store
+ */
+static inline void ST7789_ColorConvert(uint16_t *dst, const uint8_t *rgb, const uint32_t *argb,
+                                       uint32_t count, uint16_t x, uint16_t y, uint8_t flags)
+{
+    uint32_t offsets[4] = {0, 0, 0, 0};
+    bool dither = (flags & ST7789_COLOR_DITHER) != 0;
+    bool spi = (flags & ST7789_COLOR_SPI) != 0;
+    uint32_t i = 0;
+
+    if (dither) ST7789_ColorDitherRow(offsets, y);
+
+    // Align the destination for word stores
+    if (count > 0 && ((uintptr_t)dst & 2))
+    {
+        uint32_t c = ST7789_ColorLoad(rgb, argb, 0);
+        if (dither) c = ST7789_ColorAddSat(c, offsets[x & 3]);
+        c = ST7789_ColorTo565(c);
+        dst[0] = spi ? (uint16_t)((c >> 8) | (c << 8)) : (uint16_t)c;
+        i = 1;
+    }
+
+    for (; i + 1 < count; i += 2)
+    {
+        uint32_t c0 = ST7789_ColorLoad(rgb, argb, i);
+        uint32_t c1 = ST7789_ColorLoad(rgb, argb, i + 1);
+
+        if (dither)
+        {
+            c0 = ST7789_ColorAddSat(c0, offsets[(x + i) & 3]);
+            c1 = ST7789_ColorAddSat(c1, offsets[(x + i + 1) & 3]);
+        }
+
+        uint32_t pair = ST7789_ColorTo565(c0) | (ST7789_ColorTo565(c1) << 16);
+        if (spi) pair = __REV16(pair);
+
+        memcpy(&dst[i], &pair, 4);
+    }
+
+    if (i < count)
+    {
+        uint32_t c = ST7789_ColorLoad(rgb, argb, i);
+        if (dither) c = ST7789_ColorAddSat(c, offsets[(x + i) & 3]);
+        c = ST7789_ColorTo565(c);
+        dst[i] = spi ? (uint16_t)((c >> 8) | (c << 8)) : (uint16_t)c;
+    }
+}
+
+/**
+ * @brief Interpolate two 0xRRGGBB colors, t = 0..256
+ * Red and blue share one multiply.
+ */
+static inline uint32_t ST7789_ColorLerp(uint32_t c0, uint32_t c1, uint32_t t)
+{
+    uint32_t s = 256 - t;
+    uint32_t rb = (((c0 & 0xFF00FF) * s + (c1 & 0xFF00FF) * t) >> 8) & 0xFF00FF;
+    uint32_t g = (((c0 & 0x00FF00) * s + (c1 & 0x00FF00) * t) >> 8) & 0x00FF00;
+
+    return rb | g;
+}
+
+/**
+ * @brief Integer square root of a 16-bit value
+ */
+static inline uint32_t ST7789_ColorSqrt16(uint32_t v)
+{
+    uint32_t root = 0;
+
+    for (uint32_t bit = 1u << 14; bit != 0; bit >>= 2)
+    {
+        if (v >= root + bit)
+        {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+    }
+
+    return root;
+}
+
+/**
+ * @brief Clip a rectangle to the screen
+ * @return false if nothing is visible
+ */
+static bool ST7789_ColorClip(int16_t *x, int16_t *y, uint16_t *w, uint16_t *h)
+{
+    int32_t x0 = (*x < 0) ? 0 : *x;
+    int32_t y0 = (*y < 0) ? 0 : *y;
+    int32_t x1 = *x + (int32_t)*w;
+    int32_t y1 = *y + (int32_t)*h;
+
+    if (x1 > ST7789_GetWidth()) x1 = ST7789_GetWidth();
+    if (y1 > ST7789_GetHeight()) y1 = ST7789_GetHeight();
+
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    *x = x0;
+    *y = y0;
+    *w = x1 - x0;
+    *h = y1 - y0;
+
+    return true;
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Convert RGB888 to RGB565
+ */
+void ST7789_ColorFromRGB888(uint16_t *dst, const uint8_t *src, uint32_t count,
+                            uint16_t x, uint16_t y, uint8_t flags)
+{
+    ST7789_ColorConvert(dst, src, NULL, count, x, y, flags);
+}
+
+/**
+ * @brief Convert ARGB8888 to RGB565
+ */
+void ST7789_ColorFromARGB8888(uint16_t *dst, const uint32_t *src, uint32_t count,
+                              uint16_t x, uint16_t y, uint8_t flags)
+{
+    ST7789_ColorConvert(dst, NULL, src, count, x, y, flags);
+}
+
+/**
+ * @brief Draw a 24-bit image
+ */
+void ST7789_DrawImageRGB888(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                            const uint8_t *rgb, bool dither)
+{
+    int16_t vx = x, vy = y;
+    uint16_t vw = w, vh = h;
+    uint16_t chunk[COLOR_CHUNK];
+    uint8_t flags = ST7789_COLOR_SPI | (dither ? ST7789_COLOR_DITHER : 0);
+
+    if (!ST7789_ColorClip(&vx, &vy, &vw, &vh)) return;
+
+    ST7789_BlitBegin(vx, vy, vw, vh, ST7789_ORDER_SPI);
+
+    for (uint16_t row = 0; row < vh; row++)
+    {
+        const uint8_t *src = rgb + ((uint32_t)(vy - y + row) * w + (vx - x)) * 3;
+
+        for (uint16_t col = 0; col < vw; col += COLOR_CHUNK)
+        {
+            uint16_t n = (vw - col < COLOR_CHUNK) ? vw - col : COLOR_CHUNK;
+
+            ST7789_ColorConvert(chunk, src + col * 3, NULL, n, vx + col, vy + row, flags);
+            ST7789_BlitWrite(chunk, n);
+        }
+    }
+
+    ST7789_BlitEnd();
+}
+
+/**
+ * @brief Fill a rectangle with a linear gradient
+ */
+void ST7789_FillLinearGradient(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                               int16_t x0, int16_t y0, uint32_t rgb0,
+                               int16_t x1, int16_t y1, uint32_t rgb1, bool dither)
+{
+    int32_t dx = x1 - x0;
+    int32_t dy = y1 - y0;
+    int64_t len2 = (int64_t)dx * dx + (int64_t)dy * dy;
+    uint32_t words[COLOR_CHUNK];
+    uint16_t chunk[COLOR_CHUNK];
+    uint8_t flags = ST7789_COLOR_SPI | (dither ? ST7789_COLOR_DITHER : 0);
+
+    if (!ST7789_ColorClip(&x, &y, &w, &h)) return;
+
+    // Gradient position t (Q16) advances by a constant step along a row
+    int32_t step = (len2 > 0) ? (int32_t)((int64_t)dx * 65536 / len2) : 0;
+
+    ST7789_BlitBegin(x, y, w, h, ST7789_ORDER_SPI);
+
+    for (uint16_t row = 0; row < h; row++)
+    {
+        int64_t num = (int64_t)(x - x0) * dx + (int64_t)(y + row - y0) * dy;
+        int32_t t = (len2 > 0) ? (int32_t)(num * 65536 / len2) : 0;
+
+        for (uint16_t col = 0; col < w; col += COLOR_CHUNK)
+        {
+            uint16_t n = (w - col < COLOR_CHUNK) ? w - col : COLOR_CHUNK;
+
+            for (uint16_t i = 0; i < n; i++, t += step)
+            {
+                int32_t tc = (t < 0) ? 0 : (t > 65536) ? 65536 : t;
+                words[i] = ST7789_ColorLerp(rgb0, rgb1, (uint32_t)tc >> 8);
+            }
+
+            ST7789_ColorConvert(chunk, NULL, words, n, x + col, y + row, flags);
+            ST7789_BlitWrite(chunk, n);
+        }
+    }
+
+    ST7789_BlitEnd();
+}
+
+/**
+ * @brief Fill a rectangle with a radial gradient
+ */
+void ST7789_FillRadialGradient(int16_t x, int16_t y, uint16_t w, uint16_t h,
+                               int16_t cx, int16_t cy, uint16_t radius,
+                               uint32_t rgb0, uint32_t rgb1, bool dither)
+{
+    uint32_t r2 = (uint32_t)radius * radius;
+    uint32_t words[COLOR_CHUNK];
+    uint16_t chunk[COLOR_CHUNK];
+    uint8_t flags = ST7789_COLOR_SPI | (dither ? ST7789_COLOR_DITHER : 0);
+
+    if (!ST7789_ColorClip(&x, &y, &w, &h)) return;
+
+    // t^2 * 65536 = d^2 * (2^32 / r^2) >> 16, so t (0..255) is a 16-bit root
+    uint32_t inv = (r2 > 0) ? (uint32_t)(((uint64_t)1 << 32) / r2 - 1) : 0;
+
+    ST7789_BlitBegin(x, y, w, h, ST7789_ORDER_SPI);
+
+    for (uint16_t row = 0; row < h; row++)
+    {
+        int32_t ddx = x - cx;
+        int32_t ddy = y + row - cy;
+        int64_t d2 = (int64_t)ddx * ddx + (int64_t)ddy * ddy;
+
+        for (uint16_t col = 0; col < w; col += COLOR_CHUNK)
+        {
+            uint16_t n = (w - col < COLOR_CHUNK) ? w - col : COLOR_CHUNK;
+
+            for (uint16_t i = 0; i < n; i++)
+            {
+                uint32_t t = 256;
+
+                if (d2 < r2)
+                {
+                    t = ST7789_ColorSqrt16((uint32_t)(((uint64_t)d2 * inv) >> 16));
+                }
+                words[i] = ST7789_ColorLerp(rgb0, rgb1, t);
+
+                // Next pixel: (dx + 1)^2 = dx^2 + 2dx + 1
+                d2 += 2 * ddx + 1;
+                ddx++;
+            }
+
+            ST7789_ColorConvert(chunk, NULL, words, n, x + col, y + row, flags);
+            ST7789_BlitWrite(chunk, n);
+        }
+    }
+
+    ST7789_BlitEnd();
+}
@@ -0,0 +1,474 @@
+/**
+ * @file st7789_layer.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "st7789_layer.h"
+#include "st7789_color.h"
+#include <string.h>
+#include <stddef.h>
+
+/* ============== PRIVATE DEFINES ============== */
+
+// RGB565 spread over 32 bits (green moved up) so one multiply scales all channels
+#define LAYER_SPREAD_MASK   0x07E0F81FUL
+
+// Two RGB565 pixels per word without each channel's lowest bit, and only that bit
+#define LAYER_HALF_MASK     0xF7DEF7DEUL
+#define LAYER_HALF_LSB      0x08210821UL
+
+/* ============== PRIVATE TYPES ============== */
+
+typedef struct {
+    int16_t x0;
+    int16_t y0;
+    int16_t x1;
+    int16_t y1;
+} LayerRect;    // Exclusive x1 / y1
+
+/* ============== PRIVATE VARIABLES ============== */
+
+static ST7789_Sprite *layer_sprites[ST7789_LAYER_MAX_SPRITES];
+static LayerRect layer_shown[ST7789_LAYER_MAX_SPRITES];    // Screen area last drawn
+static bool layer_changed[ST7789_LAYER_MAX_SPRITES];       // Content changed
+static uint8_t layer_count = 0;
+
+static LayerRect layer_dirty[ST7789_LAYER_MAX_DIRTY];
+static uint8_t layer_dirty_count = 0;
+
+static ST7789_LayerBackground layer_background = NULL;
+static void *layer_context = NULL;
+static uint16_t layer_color = 0;
+
+// Band being composited (native RGB565, row-major, rect width wide)
+static uint16_t layer_band[ST7789_LAYER_BAND_PIXELS];
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Rectangle has no pixels
+ */
+static inline bool ST7789_LayerRectEmpty(const LayerRect *r)
+{
+    return r->x0 >= r->x1 || r->y0 >= r->y1;
+}
+
+/**
+ * @brief Area of rectangle in pixels
+ */
+static inline uint32_t ST7789_LayerRectArea(const LayerRect *r)
+{
+    return (uint32_t)(r->x1 - r->x0) * (r->y1 - r->y0);
+}
+
+/**
+ * @brief Bounding box of two rectangles
+ */
+static LayerRect ST7789_LayerRectUnion(const LayerRect *a, const LayerRect *b)
+{
+    LayerRect u;
+
+    u.x0 = (a->x0 < b->x0) ? a->x0 : b->x0;
+    u.y0 = (a->y0 < b->y0) ? a->y0 : b->y0;
+    u.x1 = (a->x1 > b->x1) ? a->x1 : b->x1;
+    u.y1 = (a->y1 > b->y1) ? a->y1 : b->y1;
+
+    return u;
+}
+
+/**
+ * @brief Screen area covered by a sprite (empty if hidden or off screen)
+ */
+static LayerRect ST7789_LayerSpriteRect(const ST7789_Sprite *sprite)
+{
+    LayerRect r = {0, 0, 0, 0};
+
+    if (!(sprite->flags & ST7789_SPRITE_VISIBLE) || sprite->alpha == 0) return r;
+
+    int32_t x1 = sprite->x + (int32_t)sprite->width;
+    int32_t y1 = sprite->y + (int32_t)sprite->height;
+
+    r.x0 = (sprite->x < 0) ? 0 : sprite->x;
+    r.y0 = (sprite->y < 0) ? 0 : sprite->y;
+    r.x1 = (x1 > ST7789_GetWidth()) ? ST7789_GetWidth() : x1;
+    r.y1 = (y1 > ST7789_GetHeight()) ? ST7789_GetHeight() : y1;
+
+    if (ST7789_LayerRectEmpty(&r)) r = (LayerRect){0, 0, 0, 0};
+
+    return r;
+}
+
+/**
+ * @brief Add a screen area to the dirty list, merging when it costs no extra pixels
+ */
+static void ST7789_LayerMark(LayerRect r)
+{
+    if (ST7789_LayerRectEmpty(&r)) return;
+
+    bool merged = true;
+
+    // Merge repeatedly: a grown rectangle may now absorb others
+    while (merged)
+    {
+        merged = false;
+
+        for (uint8_t i = 0; i < layer_dirty_count; i++)
+        {
+            LayerRect u = ST7789_LayerRectUnion(&r, &layer_dirty[i]);
+
+            if (ST7789_LayerRectArea(&u) <= ST7789_LayerRectArea(&r) + ST7789_LayerRectArea(&layer_dirty[i]))
+            {
+                r = u;
+                layer_dirty[i] = layer_dirty[--layer_dirty_count];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (layer_dirty_count < ST7789_LAYER_MAX_DIRTY)
+    {
+        layer_dirty[layer_dirty_count++] = r;
+        return;
+    }
+
+    // List full: merge with the rectangle that grows the least
+    uint8_t best = 0;
+    uint32_t best_growth = UINT32_MAX;
+
+    for (uint8_t i = 0; i < layer_dirty_count; i++)
+    {
+        LayerRect u = ST7789_LayerRectUnion(&r, &layer_dirty[i]);
+        uint32_t growth = ST7789_LayerRectArea(&u) - ST7789_LayerRectArea(&layer_dirty[i]);
+
+        if (growth < best_growth)
+        {
+            best_growth = growth;
+            best = i;
+        }
+    }
+
+    layer_dirty[best] = ST7789_LayerRectUnion(&r, &layer_dirty[best]);
+}
+
+/**
+ * @brief Blend fg over bg with a 0..32 weight
+ */
+static inline uint16_t ST7789_LayerBlend(uint16_t bg, uint16_t fg, uint32_t alpha)
+{
+    uint32_t b = (bg | ((uint32_t)bg << 16)) & LAYER_SPREAD_MASK;
+    uint32_t f = (fg | ((uint32_t)fg << 16)) & LAYER_SPREAD_MASK;
+
+    b = (b + (((f - b) * alpha) >> 5)) & LAYER_SPREAD_MASK;
+
+    return (uint16_t)(b | (b >> 16));
+}
+
+/**
+ * @brief Average two pixel pairs (50% blend, two pixels per word)
+ */
+static inline uint32_t ST7789_LayerHalf2(uint32_t a, uint32_t b)
+{
+    return ((a & LAYER_HALF_MASK) >> 1) + ((b & LAYER_HALF_MASK) >> 1) + (a & b & LAYER_HALF_LSB);
+}
+
+/**
+ * @brief Copy opaque pixels, skipping the color key (two pixels per word)
+ */
+static void ST7789_LayerCopyKeyed(uint16_t *dst, const uint16_t *src, uint32_t count, uint16_t key)
+{
+    uint32_t key2 = key | ((uint32_t)key << 16);
+    uint32_t i = 0;
+
+    for (; i + 1 < count; i += 2)
+    {
+        uint32_t pair;
+
+        memcpy(&pair, &src[i], 4);
+
+        uint32_t diff = pair ^ key2;
+
+        if (diff == 0) continue;
+
+        if ((diff & 0xFFFF) && (diff >> 16))
+        {
+            memcpy(&dst[i], &pair, 4);
+        }
+        else if (diff & 0xFFFF)
+        {
+            dst[i] = src[i];
+        }
+        else
+        {
+            dst[i + 1] = src[i + 1];
+        }
+    }
+
+    if (i < count && src[i] != key) dst[i] = src[i];
+}
+
+/**
+ * @brief 50% blend of a row or a solid color (two pixels per word)
+ */
+static void ST7789_LayerHalfRow(uint16_t *dst, const uint16_t *src, uint16_t color, uint32_t count)
+{
+    uint32_t color2 = color | ((uint32_t)color << 16);
+    uint32_t i = 0;
+
+    for (; i + 1 < count; i += 2)
+    {
+        uint32_t bg, fg = color2;
+
+        memcpy(&bg, &dst[i], 4);
+        if (src) memcpy(&fg, &src[i], 4);
+
+        bg = ST7789_LayerHalf2(bg, fg);
+        memcpy(&dst[i], &bg, 4);
+    }
+
+    if (i < count) dst[i] = (uint16_t)ST7789_LayerHalf2(dst[i], src ? src[i] : color);
+}
+
+/**
+ * @brief Composite one row segment of a sprite onto the band
+ */
+static void ST7789_LayerBlendRow(const ST7789_Sprite *sprite, uint16_t *dst,
+                                 uint16_t sx, uint16_t sy, uint32_t count)
+{
+    const uint16_t *src = sprite->pixels ? sprite->pixels + (uint32_t)sy * sprite->width + sx : NULL;
+    const uint8_t *mask = sprite->mask ? sprite->mask + (uint32_t)sy * ((sprite->width + 7) / 8) : NULL;
+    const uint8_t *alpha_map = sprite->alpha_map ? sprite->alpha_map + (uint32_t)sy * sprite->width + sx : NULL;
+    bool keyed = (src != NULL) && (sprite->flags & ST7789_SPRITE_KEY);
+    uint8_t alpha = sprite->alpha;
+
+    // Fast paths: uniform opacity
+    if (mask == NULL && alpha_map == NULL)
+    {
+        if (alpha == 255)
+        {
+            if (src == NULL)
+            {
+                ST7789_ColorFill(dst, sprite->color, count);
+            }
+            else if (keyed)
+            {
+                ST7789_LayerCopyKeyed(dst, src, count, sprite->key);
+            }
+            else
+            {
+                memcpy(dst, src, count * 2);
+            }
+            return;
+        }
+
+        if (alpha == 128 && !keyed)
+        {
+            ST7789_LayerHalfRow(dst, src, sprite->color, count);
+            return;
+        }
+    }
+
+    uint32_t scale = alpha + 1;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (mask)
+        {
+            uint32_t bit = sx + i;
+            if (!(mask[bit >> 3] & (0x80 >> (bit & 7)))) continue;
+        }
+
+        uint16_t fg = src ? src[i] : sprite->color;
+        if (keyed && fg == sprite->key) continue;
+
+        uint32_t a = alpha_map ? (alpha_map[i] * scale) >> 8 : alpha;
+        uint32_t weight = (a + 4) >> 3;
+
+        if (weight >= 32)
+        {
+            dst[i] = fg;
+        }
+        else if (weight > 0)
+        {
+            dst[i] = ST7789_LayerBlend(dst[i], fg, weight);
+        }
+    }
+}
+
+/**
+ * @brief Composite and send one screen area, band by band
+ */
+static void ST7789_LayerDraw(const LayerRect *r)
+{
+    uint16_t w = r->x1 - r->x0;
+    uint16_t lines = ST7789_LAYER_BAND_PIXELS / w;
+
+    for (int16_t y = r->y0; y < r->y1; y += lines)
+    {
+        uint16_t n = (r->y1 - y < lines) ? r->y1 - y : lines;
+
+        // Background
+        for (uint16_t row = 0; row < n; row++)
+        {
+            uint16_t *dst = &layer_band[(uint32_t)row * w];
+
+            if (layer_background)
+            {
+                layer_background(dst, r->x0, y + row, w, layer_context);
+            }
+            else
+            {
+                ST7789_ColorFill(dst, layer_color, w);
+            }
+        }
+
+        // Sprites, bottom to top
+        for (uint8_t s = 0; s < layer_count; s++)
+        {
+            const ST7789_Sprite *sprite = layer_sprites[s];
+            LayerRect sr = ST7789_LayerSpriteRect(sprite);
+
+            int16_t x0 = (sr.x0 > r->x0) ? sr.x0 : r->x0;
+            int16_t x1 = (sr.x1 < r->x1) ? sr.x1 : r->x1;
+            int16_t y0 = (sr.y0 > y) ? sr.y0 : y;
+            int16_t y1 = (sr.y1 < y + n) ? sr.y1 : y + n;
+
+            if (x0 >= x1) continue;
+
+            for (int16_t sy = y0; sy < y1; sy++)
+            {
+                ST7789_LayerBlendRow(sprite, &layer_band[(uint32_t)(sy - y) * w + (x0 - r->x0)],
+                                     x0 - sprite->x, sy - sprite->y, x1 - x0);
+            }
+        }
+
+        if (ST7789_BlitBegin(r->x0, y, w, n, ST7789_ORDER_NATIVE))
+        {
+            ST7789_BlitWrite(layer_band, (uint32_t)w * n);
+        }
+        ST7789_BlitEnd();
+    }
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Reset the scene and set the background
+ */
+void ST7789_LayerInit(ST7789_LayerBackground background, void *context)
+{
+    layer_background = background;
+    layer_context = context;
+    layer_count = 0;
+    layer_dirty_count = 0;
+}
+
+/**
+ * @brief Use a solid background color
+ */
+void ST7789_LayerSetColor(uint16_t color)
+{
+    layer_background = NULL;
+    layer_color = color;
+
+    ST7789_LayerInvalidate(0, 0, ST7789_GetWidth(), ST7789_GetHeight());
+}
+
+/**
+ * @brief Add a sprite on top
+ */
+bool ST7789_LayerAdd(ST7789_Sprite *sprite)
+{
+    for (uint8_t i = 0; i < layer_count; i++)
+    {
+        if (layer_sprites[i] == sprite) return true;
+    }
+
+    if (layer_count >= ST7789_LAYER_MAX_SPRITES) return false;
+
+    layer_sprites[layer_count] = sprite;
+    layer_shown[layer_count] = (LayerRect){0, 0, 0, 0};
+    layer_changed[layer_count] = true;
+    layer_count++;
+
+    return true;
+}
+
+/**
+ * @brief Remove a sprite
+ */
+void ST7789_LayerRemove(ST7789_Sprite *sprite)
+{
+    for (uint8_t i = 0; i < layer_count; i++)
+    {
+        if (layer_sprites[i] != sprite) continue;
+
+        ST7789_LayerMark(layer_shown[i]);
+
+        // Keep the stacking order of the rest
+        for (uint8_t j = i + 1; j < layer_count; j++)
+        {
+            layer_sprites[j - 1] = layer_sprites[j];
+            layer_shown[j - 1] = layer_shown[j];
+            layer_changed[j - 1] = layer_changed[j];
+        }
+        layer_count--;
+        return;
+    }
+}
+
+/**
+ * @brief Mark a sprite for redraw
+ */
+void ST7789_LayerChanged(ST7789_Sprite *sprite)
+{
+    for (uint8_t i = 0; i < layer_count; i++)
+    {
+        if (layer_sprites[i] == sprite) layer_changed[i] = true;
+    }
+}
+
+/**
+ * @brief Mark a screen area for redraw
+ */
+void ST7789_LayerInvalidate(int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+    int32_t x1 = x + (int32_t)w;
+    int32_t y1 = y + (int32_t)h;
+    LayerRect r;
+
+    r.x0 = (x < 0) ? 0 : x;
+    r.y0 = (y < 0) ? 0 : y;
+    r.x1 = (x1 > ST7789_GetWidth()) ? ST7789_GetWidth() : x1;
+    r.y1 = (y1 > ST7789_GetHeight()) ? ST7789_GetHeight() : y1;
+
+    ST7789_LayerMark(r);
+}
+
+/**
+ * @brief Composite and send every area that changed
+ */
+void ST7789_LayerRender(void)
+{
+    // Moved, resized, hidden or restyled sprites: old and new areas
+    for (uint8_t i = 0; i < layer_count; i++)
+    {
+        LayerRect now = ST7789_LayerSpriteRect(layer_sprites[i]);
+        LayerRect *shown = &layer_shown[i];
+
+        if (layer_changed[i] || memcmp(&now, shown, sizeof(now)) != 0)
+        {
+            ST7789_LayerMark(*shown);
+            ST7789_LayerMark(now);
+            *shown = now;
+            layer_changed[i] = false;
+        }
+    }
+
+    for (uint8_t i = 0; i < layer_dirty_count; i++)
+    {
+        ST7789_LayerDraw(&layer_dirty[i]);
+    }
+    layer_dirty_count = 0;
+}
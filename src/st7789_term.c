@@ -0,0 +1,215 @@
+/**
+ * @file st7789_term.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "st7789_term.h"
+#include <string.h>
+
+#ifdef ST7789_USE_FONTS
+
+/* ============== PRIVATE VARIABLES ============== */
+
+static struct {
+    uint16_t top;           // First screen row
+    uint16_t cols;
+    uint16_t rows;
+    uint8_t font_width;
+    uint8_t font_height;
+    const uint16_t *font_data;
+    uint16_t color;
+    uint16_t bgcolor;
+    uint16_t col;           // Cursor column
+    uint16_t row;           // Cursor line (0 = top visible line)
+    uint16_t first;         // Band line currently shown at the top
+    bool hw_scroll;         // Band scrolls in hardware
+} term = {0, 0, 0, 0, 0, NULL, ST7789_WHITE, ST7789_BLACK, 0, 0, 0, false};
+
+// Band line contents, padded with spaces (only needed for software scrolling)
+static char term_text[ST7789_TERM_MAX_ROWS][ST7789_TERM_MAX_COLS];
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Console font as a FontDef
+ */
+static FontDef ST7789_TermFont(void)
+{
+    FontDef font = {term.font_width, term.font_height, term.font_data};
+    return font;
+}
+
+/**
+ * @brief Screen row of a visible console line
+ */
+static uint16_t ST7789_TermLineY(uint16_t line)
+{
+    // With hardware scrolling the band rotates underneath the lines
+    if (term.hw_scroll) line = (term.first + line) % term.rows;
+
+    return term.top + line * term.font_height;
+}
+
+/**
+ * @brief Repaint every line from the stored text
+ */
+static void ST7789_TermRedraw(void)
+{
+    char line[ST7789_TERM_MAX_COLS + 1];
+
+    for (uint16_t r = 0; r < term.rows; r++)
+    {
+        memcpy(line, term_text[(term.first + r) % term.rows], term.cols);
+        line[term.cols] = '\0';
+        ST7789_WriteString(0, term.top + r * term.font_height, line,
+                           ST7789_TermFont(), term.color, term.bgcolor);
+    }
+}
+
+/**
+ * @brief Move the cursor to the start of the next line, scrolling at the bottom
+ */
+static void ST7789_TermNewLine(void)
+{
+    term.col = 0;
+
+    if (term.row + 1 < term.rows)
+    {
+        term.row++;
+        return;
+    }
+
+    // The line leaving the top becomes the new bottom line
+    uint16_t y = ST7789_TermLineY(0);
+    memset(term_text[term.first], ' ', term.cols);
+    term.first = (term.first + 1) % term.rows;
+
+    if (term.hw_scroll)
+    {
+        ST7789_FillRect(0, y, term.cols * term.font_width, term.font_height, term.bgcolor);
+        ST7789_SetScrollOffset(term.first * term.font_height);
+    }
+    else
+    {
+        ST7789_TermRedraw();
+    }
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Set up the console band
+ */
+void ST7789_TermInit(uint16_t top, uint16_t height, FontDef font,
+                     uint16_t color, uint16_t bgcolor)
+{
+    if (top >= ST7789_HEIGHT) top = ST7789_HEIGHT - 1;
+    if (top + height > ST7789_HEIGHT) height = ST7789_HEIGHT - top;
+
+    term.top = top;
+    term.font_width = font.width;
+    term.font_height = font.height;
+    term.font_data = font.data;
+    term.color = color;
+    term.bgcolor = bgcolor;
+    term.cols = ST7789_WIDTH / font.width;
+    term.rows = height / font.height;
+
+    if (term.cols > ST7789_TERM_MAX_COLS) term.cols = ST7789_TERM_MAX_COLS;
+    if (term.rows > ST7789_TERM_MAX_ROWS) term.rows = ST7789_TERM_MAX_ROWS;
+    if (term.rows == 0) term.rows = 1;
+
+    term.hw_scroll = ST7789_SetScrollArea(top, term.rows * font.height);
+
+    ST7789_TermClear();
+}
+
+/**
+ * @brief Clear the console
+ */
+void ST7789_TermClear(void)
+{
+    memset(term_text, ' ', sizeof(term_text));
+
+    term.col = 0;
+    term.row = 0;
+    term.first = 0;
+
+    if (term.hw_scroll) ST7789_SetScrollOffset(0);
+
+    ST7789_FillRect(0, term.top, ST7789_WIDTH, term.rows * term.font_height, term.bgcolor);
+}
+
+/**
+ * @brief Change text colors
+ */
+void ST7789_TermSetColor(uint16_t color, uint16_t bgcolor)
+{
+    term.color = color;
+    term.bgcolor = bgcolor;
+}
+
+/**
+ * @brief Write one character
+ */
+void ST7789_TermPutc(char ch)
+{
+    if (term.rows == 0) return;
+
+    if (ch == '\n')
+    {
+        ST7789_TermNewLine();
+        return;
+    }
+
+    if (ch == '\r')
+    {
+        term.col = 0;
+        return;
+    }
+
+    if (term.col >= term.cols) ST7789_TermNewLine();
+
+    term_text[(term.first + term.row) % term.rows][term.col] = ch;
+    ST7789_WriteChar(term.col * term.font_width, ST7789_TermLineY(term.row), ch,
+                     ST7789_TermFont(), term.color, term.bgcolor);
+    term.col++;
+}
+
+/**
+ * @brief Write a string
+ */
+void ST7789_TermWrite(const char *str)
+{
+    // Runs of printable characters on one line go out as a single glyph run
+    while (*str)
+    {
+        if (*str == '\n' || *str == '\r' || term.col >= term.cols || term.rows == 0)
+        {
+            ST7789_TermPutc(*str++);
+            continue;
+        }
+
+        char run[ST7789_TERM_MAX_COLS + 1];
+        uint16_t count = 0;
+        uint16_t col = term.col;
+        char *text = term_text[(term.first + term.row) % term.rows];
+
+        while (str[count] != '\0' && str[count] != '\n' && str[count] != '\r' &&
+               col + count < term.cols)
+        {
+            run[count] = str[count];
+            text[col + count] = str[count];
+            count++;
+        }
+        run[count] = '\0';
+
+        ST7789_WriteString(col * term.font_width, ST7789_TermLineY(term.row), run,
+                           ST7789_TermFont(), term.color, term.bgcolor);
+        term.col += count;
+        str += count;
+    }
+}
+
+#endif
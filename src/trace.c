@@ -0,0 +1,150 @@
+/**
+ * @file trace.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdbool.h>
+
+/* ============== PRIVATE VARIABLES ============== */
+
+static TRACE_Entry trace_ring[TRACE_SIZE];
+static volatile uint32_t trace_head = 0;    // Events recorded since the last clear
+static volatile bool trace_paused = false;
+
+// Names of TRACE_Id values, indexed by ID
+static const char *const trace_names[TRACE_USER] = {
+    [TRACE_LCD_COMMAND]   = "lcd cmd",
+    [TRACE_LCD_WINDOW]    = "lcd window",
+    [TRACE_LCD_DATA]      = "lcd data",
+    [TRACE_LCD_DMA_QUEUE] = "lcd dma queue",
+    [TRACE_LCD_DMA_START] = "lcd dma start",
+    [TRACE_LCD_DMA_STOP]  = "lcd dma stop",
+    [TRACE_LCD_WAIT]      = "lcd wait",
+    [TRACE_TOUCH_BURST]   = "touch burst",
+    [TRACE_TOUCH_DONE]    = "touch done",
+};
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Send one line to ITM stimulus port 0
+ */
+static void TRACE_Print(const char *line)
+{
+    for (const char *p = line; *p; p++)
+    {
+        ITM_SendChar(*p);
+    }
+    ITM_SendChar('\n');
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Start the cycle counter and clear the ring
+ */
+void TRACE_Init(void)
+{
+    PERF_Init();
+    TRACE_Clear();
+}
+
+/**
+ * @brief Record an event
+ */
+void TRACE_Event(uint8_t id, uint32_t arg)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!trace_paused)
+    {
+        TRACE_Entry *e = &trace_ring[trace_head & (TRACE_SIZE - 1)];
+        e->cycles = PERF_Cycles();
+        e->event = ((uint32_t)id << 24) | (arg & 0xFFFFFF);
+        trace_head++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Drop all recorded events
+ */
+void TRACE_Clear(void)
+{
+    trace_head = 0;
+}
+
+/**
+ * @brief Copy the newest events, oldest first
+ */
+uint32_t TRACE_Read(TRACE_Entry *out, uint32_t max)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t count = (trace_head < TRACE_SIZE) ? trace_head : TRACE_SIZE;
+    if (count > max) count = max;
+
+    uint32_t first = trace_head - count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        out[i] = trace_ring[(first + i) & (TRACE_SIZE - 1)];
+    }
+
+    __set_PRIMASK(primask);
+    return count;
+}
+
+/**
+ * @brief Print and clear the recorded events
+ */
+void TRACE_Dump(void)
+{
+    char line[64];
+
+    trace_paused = true;
+
+    uint32_t total = trace_head;
+    uint32_t count = (total < TRACE_SIZE) ? total : TRACE_SIZE;
+    uint32_t first = total - count;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+    snprintf(line, sizeof(line), "trace: %lu events (%lu overwritten)",
+             (unsigned long)count, (unsigned long)(total - count));
+    TRACE_Print(line);
+    TRACE_Print("    cycles      +us  event            arg");
+
+    uint32_t last = (count > 0) ? trace_ring[first & (TRACE_SIZE - 1)].cycles : 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const TRACE_Entry *e = &trace_ring[(first + i) & (TRACE_SIZE - 1)];
+        uint8_t id = e->event >> 24;
+        uint32_t us10 = (uint32_t)((uint64_t)(e->cycles - last) * 10 / cycles_per_us);
+        const char *name = (id < TRACE_USER) ? trace_names[id] : NULL;
+
+        if (name != NULL)
+        {
+            snprintf(line, sizeof(line), "%10lu %6lu.%lu  %-16s %lu", (unsigned long)e->cycles,
+                     (unsigned long)(us10 / 10), (unsigned long)(us10 % 10), name,
+                     (unsigned long)(e->event & 0xFFFFFF));
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "%10lu %6lu.%lu  user %-11u %lu", (unsigned long)e->cycles,
+                     (unsigned long)(us10 / 10), (unsigned long)(us10 % 10), (unsigned)id,
+                     (unsigned long)(e->event & 0xFFFFFF));
+        }
+        TRACE_Print(line);
+
+        last = e->cycles;
+    }
+
+    trace_head = 0;
+    trace_paused = false;
+}
@@ -8,6 +8,7 @@
 #include "st7789.h"
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 
 /* ============== PRIVATE DEFINES ============== */
 
@@ -16,6 +17,7 @@
 #define CMD_Y_READ      0xD0  // Read Y (actually X in datasheet)
 #define CMD_Z1_READ     0xB0  // Read Z1 (pressure)
 #define CMD_Z2_READ     0xC0  // Read Z2 (pressure)
+#define CMD_ADC_ON      0x01  // PD0: keep ADC powered between conversions (PENIRQ off)
 
 // GPIO Macros
 #define CS_LOW()   HAL_GPIO_WritePin(XPT2046_CS_PORT, XPT2046_CS_PIN, GPIO_PIN_RESET)
@@ -28,55 +30,221 @@
 #define XPT2046_JUMP_THRESHOLD  80
 #define XPT2046_MAX_INVALID_SAMPLES 3
 
+// Compare-exchange for the median networks
+#define SORT2(a, b) do { if ((a) > (b)) { int16_t t_ = (a); (a) = (b); (b) = t_; } } while (0)
+
+// 2 * pi * 1e-6 in Q32: cutoff (mHz) * period (ms) -> Q16 phase step
+#define EURO_RATE_Q32   26986UL
+
+// Points accepted by XPT2046_SolveCalibration (keeps its sums in 64 bits)
+#define CAL_MAX_POINTS  9
+
+#ifdef XPT2046_CAL_FLASH_ADDR
+#define CAL_MAGIC       0x314C4143UL  // "CAL1"
+
+// Calibration record in flash
+typedef struct {
+    uint32_t magic;
+    uint16_t width;         // Screen size the matrix maps to
+    uint16_t height;
+    XPT2046_CalMatrix matrix;
+    uint32_t check;         // XPT2046_CalCheck() of the fields above
+} XPT2046_CalRecord;
+#endif
+
+// Statistics hooks
+#ifdef XPT2046_USE_STATS
+#define STATS_NOW()                 PERF_Cycles()
+#define STATS_COUNT(field)          (stats.field++)
+#define STATS_TIME(field, start)    PERF_StatAdd(&stats.field, PERF_Cycles() - (start))
+#else
+#define STATS_NOW()                 0
+#define STATS_COUNT(field)          ((void)0)
+#define STATS_TIME(field, start)    ((void)(start))
+#endif
+
+// Conversions per burst: Z1, Z2, then a settling conversion plus samples per axis
+#define BURST_CONVERSIONS   (2 + 2 * (XPT2046_READ_SAMPLES + 1))
+
+/* ============== PRIVATE TYPES ============== */
+
+// One burst of conversions (12-bit values)
+typedef struct {
+    int16_t z1;
+    int16_t z2;
+    int16_t x[XPT2046_READ_SAMPLES];
+    int16_t y[XPT2046_READ_SAMPLES];
+} XPT2046_Burst;
+
+// Smoothing state of one axis
+typedef struct {
+    int32_t x;          // Filtered position (Q4 pixels)
+    int32_t dx;         // Filtered speed (Q4 pixels/s, 1-euro only)
+} XPT2046_Axis;
+
 /* ============== PRIVATE VARIABLES ============== */
 
-// Averaging buffer
+#if XPT2046_FILTER == XPT2046_FILTER_AVERAGE
+// Moving average: ring of recent points and their running sums
 static int16_t avg_buf_x[XPT2046_AVG_SAMPLES];
 static int16_t avg_buf_y[XPT2046_AVG_SAMPLES];
+static uint8_t avg_index = 0;        // Next slot (oldest point once full)
 static uint8_t avg_count = 0;
+static int32_t avg_sum_x = 0;
+static int32_t avg_sum_y = 0;
+#elif XPT2046_FILTER != XPT2046_FILTER_NONE
+// Exponential / 1-euro state per axis
+static XPT2046_Axis smooth_x;
+static XPT2046_Axis smooth_y;
+static bool smooth_valid = false;
+#if XPT2046_FILTER == XPT2046_FILTER_EURO
+static uint32_t smooth_time = 0;     // HAL tick of previous point
+#endif
+#endif
 
-// Calibration values (can be updated at runtime)
+// Calibration in use (raw ADC -> screen)
+static XPT2046_CalMatrix calibration;
+
+// Raw range the matrix is built from, rebuilt when the screen size changes
+// (inactive once a fitted matrix is set)
 static struct {
     int16_t x_min;
     int16_t y_min;
     int16_t x_max;
     int16_t y_max;
-} calibration = {
+    bool active;
+} cal_range = {
     XPT2046_X_MIN,
     XPT2046_Y_MIN,
     XPT2046_X_MAX,
-    XPT2046_Y_MAX
+    XPT2046_Y_MAX,
+    true
 };
 
 // Screen dimensions (should match ST7789)
-static uint16_t screen_width = ST7789_WIDTH;
-static uint16_t screen_height = ST7789_HEIGHT;
+static uint16_t screen_width = ST7789_DEFAULT_WIDTH;
+static uint16_t screen_height = ST7789_DEFAULT_HEIGHT;
 
 static int16_t last_valid_x = -1;
 static int16_t last_valid_y = -1;
 static uint8_t invalid_count = 0;
 
+#ifdef XPT2046_USE_SPI_BUS
+// Arbiter entry (bus NULL until XPT2046_AttachBus)
+static SPI_BusDevice bus_dev;
+#endif
+
+#ifdef XPT2046_USE_EVENTS
+// Pen state seen by the sampler
+enum {
+    PEN_IDLE,           // Waiting for PENIRQ
+    PEN_DOWN,           // Sampling on every tick
+    PEN_RELEASING       // Lifted, pen-up not queued yet
+};
+
+// Single-producer (sampler) / single-consumer (XPT2046_PollEvent) ring
+static XPT2046_Event event_queue[XPT2046_EVENT_QUEUE_SIZE];
+static volatile uint8_t event_head = 0;    // Next free slot (producer only)
+static volatile uint8_t event_tail = 0;    // Oldest event (consumer only)
+
+static volatile uint8_t pen_state = PEN_IDLE;
+static volatile bool pen_sampling = false; // Burst requested or running
+static volatile bool pen_due = false;      // Tick without arbiter: sample in XPT2046_PollEvent()
+static bool pen_reported = false;          // Pen-down queued for this touch
+static uint8_t pen_misses = 0;             // Consecutive samples without pressure
+static int16_t pen_x = 0;                  // Last queued position
+static int16_t pen_y = 0;
+static uint32_t pen_down_cycles = 0;       // PENIRQ edge (statistics)
+#endif
+
+#ifdef XPT2046_USE_STATS
+static XPT2046_Stats stats;
+static uint32_t burst_start = 0;           // Cycle count when the last burst began
+#endif
+
 /* ============== PRIVATE FUNCTIONS ============== */
 
 /**
- * @brief Send command and read 16-bit response
+ * @brief Get the shared SPI bus
+ * Without the arbiter, pending display DMA is simply allowed to finish.
  */
-static int16_t XPT2046_SendCommand(uint8_t cmd)
+static void XPT2046_BusAcquire(void)
 {
-    uint8_t tx_data = cmd;
-    uint8_t rx_data[2] = {0};
+#ifdef XPT2046_USE_SPI_BUS
+    if (bus_dev.bus != NULL)
+    {
+        SPI_BusAcquire(&bus_dev);
+        return;
+    }
+#endif
+    ST7789_WaitIdle();
+}
 
-    CS_LOW();
-    HAL_Delay(1);
+/**
+ * @brief Give the shared SPI bus back
+ */
+static void XPT2046_BusRelease(void)
+{
+#ifdef XPT2046_USE_SPI_BUS
+    if (bus_dev.bus != NULL)
+    {
+        SPI_BusRelease(&bus_dev);
+    }
+#endif
+}
+
+/**
+ * @brief Run conversions back to back in one CS assertion
+ * Each command byte overlaps the last 8 clocks of the previous result
+ * (16 clocks per conversion); a final power-down command re-enables PENIRQ.
+ */
+static void XPT2046_Convert(const uint8_t *cmds, uint8_t count, int16_t *results)
+{
+    uint8_t tx[BURST_CONVERSIONS * 2 + 3];
+    uint8_t rx[BURST_CONVERSIONS * 2 + 3];
+    uint16_t len = count * 2 + 3;
+
+    memset(tx, 0, len);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        tx[i * 2] = cmds[i];
+    }
+    tx[count * 2] = CMD_X_READ;
+
+    #ifdef XPT2046_USE_TRACE
+    TRACE_Event(TRACE_TOUCH_BURST, count);
+    #endif
 
-    HAL_SPI_Transmit(&XPT2046_SPI_PORT, &tx_data, 1, HAL_MAX_DELAY);
-    for(volatile int i=0; i<100; i++);
-    HAL_SPI_Receive(&XPT2046_SPI_PORT, rx_data, 2, HAL_MAX_DELAY);
+    uint32_t start = STATS_NOW();
+    XPT2046_BusAcquire();
+    STATS_TIME(bus_wait_cycles, start);
 
+    CS_LOW();
+    HAL_SPI_TransmitReceive(&XPT2046_SPI_PORT, tx, rx, len, HAL_MAX_DELAY);
     CS_HIGH();
-    HAL_Delay(1);
 
-    return (rx_data[0] << 8) | rx_data[1];
+    XPT2046_BusRelease();
+
+    #ifdef XPT2046_USE_TRACE
+    TRACE_Event(TRACE_TOUCH_DONE, len);
+    #endif
+
+    // Result i: busy bit, 12 data bits, 3 zero bits
+    for (uint8_t i = 0; i < count; i++)
+    {
+        results[i] = ((rx[i * 2 + 1] << 8) | rx[i * 2 + 2]) >> 3;
+    }
+}
+
+/**
+ * @brief Check pressure readings against the touch threshold
+ */
+static bool XPT2046_IsPressure(int16_t z1, int16_t z2)
+{
+    if (z1 < 50) return false;
+
+    int16_t z = z2 - z1;
+    return (z > XPT2046_TOUCH_THRESHOLD);
 }
 
 /**
@@ -88,130 +256,324 @@ static bool XPT2046_IsPressed(void)
     if (!IS_IRQ_LOW()) return false;
 #endif
 
-    int16_t z1 = XPT2046_SendCommand(CMD_Z1_READ) >> 3;
-    int16_t z2 = XPT2046_SendCommand(CMD_Z2_READ) >> 3;
+    static const uint8_t cmds[2] = {CMD_Z1_READ | CMD_ADC_ON, CMD_Z2_READ | CMD_ADC_ON};
+    int16_t z[2];
 
-    if (z1 < 50) return false;
+    XPT2046_Convert(cmds, 2, z);
 
-    int16_t z = z2 - z1;
-    return (z > XPT2046_TOUCH_THRESHOLD);
+    return XPT2046_IsPressure(z[0], z[1]);
 }
 
 /**
- * @brief Apply calibration and coordinate transformations
+ * @brief Read pressure and all X/Y samples in one burst
+ * @return false if not touched (burst skipped when PENIRQ is high)
  */
-static void XPT2046_ApplyCalibration(int16_t *x, int16_t *y)
+static bool XPT2046_ReadBurst(XPT2046_Burst *burst)
 {
-#if XPT2046_XY_SWAP != 0
-    int16_t temp = *x;
-    *x = *y;
-    *y = temp;
+#ifdef XPT2046_IRQ_PIN
+    if (!IS_IRQ_LOW()) return false;
+#endif
+
+    uint8_t cmds[BURST_CONVERSIONS];
+    int16_t results[BURST_CONVERSIONS];
+    uint8_t n = 0;
+
+    cmds[n++] = CMD_Z1_READ | CMD_ADC_ON;
+    cmds[n++] = CMD_Z2_READ | CMD_ADC_ON;
+
+    for (uint8_t i = 0; i <= XPT2046_READ_SAMPLES; i++)
+    {
+        cmds[n++] = CMD_X_READ | CMD_ADC_ON;
+    }
+
+    for (uint8_t i = 0; i <= XPT2046_READ_SAMPLES; i++)
+    {
+        cmds[n++] = CMD_Y_READ | CMD_ADC_ON;
+    }
+
+    uint32_t start = STATS_NOW();
+
+    XPT2046_Convert(cmds, n, results);
+
+    STATS_COUNT(bursts);
+    STATS_TIME(burst_cycles, start);
+#ifdef XPT2046_USE_STATS
+    burst_start = start;
 #endif
 
-    if (*x < calibration.x_min) *x = calibration.x_min;
-    if (*y < calibration.y_min) *y = calibration.y_min;
-    if (*x > calibration.x_max) *x = calibration.x_max;
-    if (*y > calibration.y_max) *y = calibration.y_max;
+    burst->z1 = results[0];
+    burst->z2 = results[1];
+
+    // First conversion of each axis lets the switched drivers settle
+    for (uint8_t i = 0; i < XPT2046_READ_SAMPLES; i++)
+    {
+        burst->x[i] = results[3 + i];
+        burst->y[i] = results[4 + XPT2046_READ_SAMPLES + i];
+    }
+
+    return XPT2046_IsPressure(burst->z1, burst->z2);
+}
 
-    *x -= calibration.x_min;
-    *y -= calibration.y_min;
+/**
+ * @brief Build the calibration matrix from the raw range and axis options
+ */
+static void XPT2046_RangeMatrix(void)
+{
+    if (cal_range.x_max <= cal_range.x_min || cal_range.y_max <= cal_range.y_min) return;
 
-    *x = (uint32_t)(*x) * screen_width / (calibration.x_max - calibration.x_min);
-    *y = (uint32_t)(*y) * screen_height / (calibration.y_max - calibration.y_min);
+    int32_t sx = ((int32_t)screen_width << 16) / (cal_range.x_max - cal_range.x_min);
+    int32_t sy = ((int32_t)screen_height << 16) / (cal_range.y_max - cal_range.y_min);
+    int32_t cx = -sx * cal_range.x_min;
+    int32_t cy = -sy * cal_range.y_min;
 
 #if XPT2046_X_INV != 0
-    *x = screen_width - 1 - *x;
+    sx = -sx;
+    cx = ((int32_t)(screen_width - 1) << 16) - cx;
 #endif
 
 #if XPT2046_Y_INV != 0
-    *y = screen_height - 1 - *y;
+    sy = -sy;
+    cy = ((int32_t)(screen_height - 1) << 16) - cy;
+#endif
+
+#if XPT2046_XY_SWAP != 0
+    XPT2046_CalMatrix m = {0, sx, cx, sy, 0, cy};
+#else
+    XPT2046_CalMatrix m = {sx, 0, cx, 0, sy, cy};
 #endif
 
-    if (*x < 0) *x = 0;
-    if (*y < 0) *y = 0;
-    if (*x >= (int16_t)screen_width) *x = screen_width - 1;
-    if (*y >= (int16_t)screen_height) *y = screen_height - 1;
+    calibration = m;
+}
+
+/**
+ * @brief Apply calibration and coordinate transformations
+ */
+static void XPT2046_ApplyCalibration(int16_t *x, int16_t *y)
+{
+    int32_t raw_x = *x;
+    int32_t raw_y = *y;
+
+    int32_t sx = (calibration.a * raw_x + calibration.b * raw_y + calibration.c + 0x8000) >> 16;
+    int32_t sy = (calibration.d * raw_x + calibration.e * raw_y + calibration.f + 0x8000) >> 16;
+
+    if (sx < 0) sx = 0;
+    if (sy < 0) sy = 0;
+    if (sx >= (int32_t)screen_width) sx = screen_width - 1;
+    if (sy >= (int32_t)screen_height) sy = screen_height - 1;
+
+    *x = sx;
+    *y = sy;
+}
+
+/**
+ * @brief num / den in Q16 without overflowing the 64-bit intermediate
+ */
+static int32_t XPT2046_Q16Div(int64_t num, int64_t den)
+{
+    int64_t q = num / den;
+    int64_t r = num % den;
+
+    // Long division, 4 fraction bits per step
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        r *= 16;
+        q = q * 16 + r / den;
+        r %= den;
+    }
+
+    return (int32_t)q;
 }
 
+#ifdef XPT2046_CAL_FLASH_ADDR
 /**
- * @brief Average multiple samples to reduce noise
+ * @brief Check word of a calibration record
  */
-static void XPT2046_Average(int16_t *x, int16_t *y)
+static uint32_t XPT2046_CalCheck(const XPT2046_CalRecord *record)
 {
-    for (uint8_t i = XPT2046_AVG_SAMPLES - 1; i > 0; i--)
+    const uint32_t *words = (const uint32_t *)record;
+    uint32_t check = 0x5A5A5A5AUL;
+
+    for (uint8_t i = 0; i < offsetof(XPT2046_CalRecord, check) / 4; i++)
     {
-        avg_buf_x[i] = avg_buf_x[i - 1];
-        avg_buf_y[i] = avg_buf_y[i - 1];
+        check = (check << 5 | check >> 27) ^ words[i];
     }
 
-    avg_buf_x[0] = *x;
-    avg_buf_y[0] = *y;
+    return check;
+}
+#endif
+
+
+/**
+ * @brief Forget smoothing history
+ */
+static void XPT2046_SmoothReset(void)
+{
+#if XPT2046_FILTER == XPT2046_FILTER_AVERAGE
+    avg_index = 0;
+    avg_count = 0;
+    avg_sum_x = 0;
+    avg_sum_y = 0;
+#elif XPT2046_FILTER != XPT2046_FILTER_NONE
+    smooth_valid = false;
+#endif
+}
+
+#if XPT2046_FILTER == XPT2046_FILTER_EURO
+/**
+ * @brief Q16 smoothing factor of a first-order low-pass at 'cutoff' mHz
+ */
+static int32_t XPT2046_EuroAlpha(uint32_t cutoff, uint32_t period)
+{
+    uint32_t r = (uint32_t)(((uint64_t)cutoff * period * EURO_RATE_Q32) >> 16);
+    return (int32_t)(((uint64_t)r << 16) / (65536 + r));
+}
+
+/**
+ * @brief 1-euro step: cutoff rises with speed, so jitter is smoothed at
+ * rest while fast strokes keep little lag
+ */
+static int16_t XPT2046_EuroStep(XPT2046_Axis *axis, int16_t value, uint32_t period)
+{
+    int32_t x = (int32_t)value << 4;
+    int32_t speed = (x - axis->x) * 1000 / (int32_t)period;
+
+    axis->dx += (int32_t)(((int64_t)(speed - axis->dx) * XPT2046_EuroAlpha(XPT2046_EURO_D_CUTOFF, period)) >> 16);
+
+    uint32_t abs_dx = (axis->dx < 0) ? -axis->dx : axis->dx;
+    uint32_t cutoff = XPT2046_EURO_MIN_CUTOFF + ((XPT2046_EURO_BETA * abs_dx) >> 4);
 
-    if (avg_count < XPT2046_AVG_SAMPLES)
+    axis->x += (int32_t)(((int64_t)(x - axis->x) * XPT2046_EuroAlpha(cutoff, period)) >> 16);
+
+    return (axis->x + 8) >> 4;
+}
+#endif
+
+/**
+ * @brief Smooth successive points (constant cost per point)
+ */
+static void XPT2046_Smooth(int16_t *x, int16_t *y)
+{
+#if XPT2046_FILTER == XPT2046_FILTER_AVERAGE
+    if (avg_count == XPT2046_AVG_SAMPLES)
+    {
+        avg_sum_x -= avg_buf_x[avg_index];
+        avg_sum_y -= avg_buf_y[avg_index];
+    }
+    else
     {
         avg_count++;
     }
 
-    int32_t sum_x = 0;
-    int32_t sum_y = 0;
+    avg_buf_x[avg_index] = *x;
+    avg_buf_y[avg_index] = *y;
+    avg_sum_x += *x;
+    avg_sum_y += *y;
+
+    if (++avg_index == XPT2046_AVG_SAMPLES) avg_index = 0;
 
-    for (uint8_t i = 0; i < avg_count; i++)
+    *x = avg_sum_x / avg_count;
+    *y = avg_sum_y / avg_count;
+#elif XPT2046_FILTER != XPT2046_FILTER_NONE
+    if (!smooth_valid)
     {
-        sum_x += avg_buf_x[i];
-        sum_y += avg_buf_y[i];
+        smooth_x.x = (int32_t)*x << 4;
+        smooth_y.x = (int32_t)*y << 4;
+        smooth_x.dx = 0;
+        smooth_y.dx = 0;
+        smooth_valid = true;
+#if XPT2046_FILTER == XPT2046_FILTER_EURO
+        smooth_time = HAL_GetTick();
+#endif
+        return;
     }
 
-    *x = sum_x / avg_count;
-    *y = sum_y / avg_count;
+#if XPT2046_FILTER == XPT2046_FILTER_IIR
+    smooth_x.x += (((int32_t)*x << 4) - smooth_x.x) >> XPT2046_IIR_SHIFT;
+    smooth_y.x += (((int32_t)*y << 4) - smooth_y.x) >> XPT2046_IIR_SHIFT;
+    *x = (smooth_x.x + 8) >> 4;
+    *y = (smooth_y.x + 8) >> 4;
+#else
+    uint32_t now = HAL_GetTick();
+    uint32_t period = now - smooth_time;
+    smooth_time = now;
+
+    if (period == 0) period = 1;
+    if (period > 1000) period = 1000;
+
+    *x = XPT2046_EuroStep(&smooth_x, *x, period);
+    *y = XPT2046_EuroStep(&smooth_y, *y, period);
+#endif
+#else
+    (void)x;
+    (void)y;
+#endif
 }
 
 /**
- * @brief Median filter
+ * @brief Median of one axis of a burst
+ * Fixed sample counts use optimal median networks (no loops, no branches
+ * beyond the compare-exchanges); other counts fall back to insertion sort.
  */
-static int16_t median_filter(int16_t *data, uint8_t size)
+static int16_t XPT2046_Median(const int16_t *data)
 {
-    int16_t temp[XPT2046_READ_SAMPLES];
-    for (uint8_t i = 0; i < size; i++)
+    int16_t p[XPT2046_READ_SAMPLES];
+    memcpy(p, data, sizeof(p));
+
+#if XPT2046_READ_SAMPLES == 1
+    return p[0];
+#elif XPT2046_READ_SAMPLES == 3
+    SORT2(p[0], p[1]); SORT2(p[1], p[2]); SORT2(p[0], p[1]);
+    return p[1];
+#elif XPT2046_READ_SAMPLES == 5
+    SORT2(p[0], p[1]); SORT2(p[3], p[4]); SORT2(p[0], p[3]);
+    SORT2(p[1], p[4]); SORT2(p[1], p[2]); SORT2(p[2], p[3]);
+    SORT2(p[1], p[2]);
+    return p[2];
+#elif XPT2046_READ_SAMPLES == 7
+    SORT2(p[0], p[5]); SORT2(p[0], p[3]); SORT2(p[1], p[6]);
+    SORT2(p[2], p[4]); SORT2(p[0], p[1]); SORT2(p[3], p[5]);
+    SORT2(p[2], p[6]); SORT2(p[2], p[3]); SORT2(p[3], p[6]);
+    SORT2(p[4], p[5]); SORT2(p[1], p[4]); SORT2(p[1], p[3]);
+    SORT2(p[3], p[4]);
+    return p[3];
+#elif XPT2046_READ_SAMPLES == 9
+    SORT2(p[1], p[2]); SORT2(p[4], p[5]); SORT2(p[7], p[8]);
+    SORT2(p[0], p[1]); SORT2(p[3], p[4]); SORT2(p[6], p[7]);
+    SORT2(p[1], p[2]); SORT2(p[4], p[5]); SORT2(p[7], p[8]);
+    SORT2(p[0], p[3]); SORT2(p[5], p[8]); SORT2(p[4], p[7]);
+    SORT2(p[3], p[6]); SORT2(p[1], p[4]); SORT2(p[2], p[5]);
+    SORT2(p[4], p[7]); SORT2(p[4], p[2]); SORT2(p[6], p[4]);
+    SORT2(p[4], p[2]);
+    return p[4];
+#else
+    for (uint8_t i = 1; i < XPT2046_READ_SAMPLES; i++)
     {
-        temp[i] = data[i];
-    }
+        int16_t v = p[i];
+        uint8_t j = i;
 
-    // Bubble sort in copy
-    for (uint8_t i = 0; i < size - 1; i++)
-    {
-        for (uint8_t j = 0; j < size - i - 1; j++)
+        while (j > 0 && p[j - 1] > v)
         {
-            if (temp[j] > temp[j + 1])
-            {
-                int16_t swap = temp[j];
-                temp[j] = temp[j + 1];
-                temp[j + 1] = swap;
-            }
+            p[j] = p[j - 1];
+            j--;
         }
+        p[j] = v;
     }
 
-    return temp[size / 2];
+    return p[XPT2046_READ_SAMPLES / 2];
+#endif
 }
 
 /**
- * @brief Read coordinates with median filter and outlier removal
+ * @brief Reduce a burst with median filter and outlier removal
  */
-static bool XPT2046_ReadFiltered(int16_t *x, int16_t *y)
+static bool XPT2046_Filter(const XPT2046_Burst *burst, int16_t *x, int16_t *y)
 {
-    int16_t x_samples[XPT2046_READ_SAMPLES];
-    int16_t y_samples[XPT2046_READ_SAMPLES];
-
-    // Read multiple samples with small delay
-    for (uint8_t i = 0; i < XPT2046_READ_SAMPLES; i++)
-    {
-        x_samples[i] = XPT2046_SendCommand(CMD_X_READ) >> 3;
-        y_samples[i] = XPT2046_SendCommand(CMD_Y_READ) >> 3;
-        HAL_Delay(2);  // Increased delay from 1ms to 2ms
-    }
+    const int16_t *x_samples = burst->x;
+    const int16_t *y_samples = burst->y;
 
     // Get median
-    *x = median_filter(x_samples, XPT2046_READ_SAMPLES);
-    *y = median_filter(y_samples, XPT2046_READ_SAMPLES);
+    *x = XPT2046_Median(x_samples);
+    *y = XPT2046_Median(y_samples);
 
     // Calculate standard deviation to detect noise
     int32_t sum_diff_x = 0, sum_diff_y = 0;
@@ -223,8 +585,8 @@ static bool XPT2046_ReadFiltered(int16_t *x, int16_t *y)
         sum_diff_y += (diff_y * diff_y);
     }
 
-    int16_t std_dev_x = sum_diff_x / XPT2046_READ_SAMPLES;
-    int16_t std_dev_y = sum_diff_y / XPT2046_READ_SAMPLES;
+    int32_t std_dev_x = sum_diff_x / XPT2046_READ_SAMPLES;
+    int32_t std_dev_y = sum_diff_y / XPT2046_READ_SAMPLES;
 
     // If standard deviation is too high, data is unreliable
     if (std_dev_x > 10000 || std_dev_y > 10000)
@@ -235,58 +597,40 @@ static bool XPT2046_ReadFiltered(int16_t *x, int16_t *y)
     return true;
 }
 
-/* ============== PUBLIC FUNCTIONS ============== */
-
 /**
- * @brief Initialize XPT2046
+ * @brief Forget the previous touch (filter history and jump detection)
  */
-void XPT2046_Init(void)
+static void XPT2046_ResetFilter(void)
 {
-    memset(avg_buf_x, 0, sizeof(avg_buf_x));
-    memset(avg_buf_y, 0, sizeof(avg_buf_y));
-    avg_count = 0;
+    XPT2046_SmoothReset();
     last_valid_x = -1;
     last_valid_y = -1;
     invalid_count = 0;
-
-    // CS pin should be initialized in CubeMX
-    CS_HIGH();
-
-    // Small delay for chip to stabilize
-    HAL_Delay(10);
 }
 
 /**
- * @brief Read calibrated touch coordinates
+ * @brief Turn a pressed burst into screen coordinates
+ * @return false if the burst was rejected (noise or jump)
  */
-bool XPT2046_Read(int16_t *x, int16_t *y)
+static bool XPT2046_Process(const XPT2046_Burst *burst, int16_t *x, int16_t *y)
 {
-	// Check if touch is pressed
-    if (!XPT2046_IsPressed())
-    {
-    	// Reset state when not touched
-        avg_count = 0;
-        memset(avg_buf_x, 0, sizeof(avg_buf_x));
-        memset(avg_buf_y, 0, sizeof(avg_buf_y));
-        last_valid_x = -1;
-        last_valid_y = -1;
-        invalid_count = 0;
-        return false;
-    }
+    uint32_t start = STATS_NOW();
 
-    // Read with median filter
     int16_t raw_x, raw_y;
-    if (!XPT2046_ReadFiltered(&raw_x, &raw_y))
+    if (!XPT2046_Filter(burst, &raw_x, &raw_y))
     {
     	// Unreliable data (high noise)
+        STATS_COUNT(rejected_noise);
         invalid_count++;
         if (invalid_count >= XPT2046_MAX_INVALID_SAMPLES)
         {
         	// Too many invalid reads, reset
-            avg_count = 0;
+            STATS_COUNT(resets);
+            XPT2046_SmoothReset();
             last_valid_x = -1;
             last_valid_y = -1;
         }
+        STATS_TIME(process_cycles, start);
         return false;
     }
 
@@ -309,14 +653,15 @@ bool XPT2046_Read(int16_t *x, int16_t *y)
             if (invalid_count >= XPT2046_MAX_INVALID_SAMPLES)
             {
             	// Too many consecutive jumps, assume new touch
-                avg_count = 0;
-                memset(avg_buf_x, 0, sizeof(avg_buf_x));
-                memset(avg_buf_y, 0, sizeof(avg_buf_y));
+                STATS_COUNT(resets);
+                XPT2046_SmoothReset();
                 invalid_count = 0;
             }
             else
             {
             	// Skip this sample, wait for next
+                STATS_COUNT(rejected_jump);
+                STATS_TIME(process_cycles, start);
                 return false;
             }
         }
@@ -327,8 +672,8 @@ bool XPT2046_Read(int16_t *x, int16_t *y)
         }
     }
 
-    // Apply averaging for smoothing
-    XPT2046_Average(&raw_x, &raw_y);
+    // Smooth successive points
+    XPT2046_Smooth(&raw_x, &raw_y);
 
     // Store valid coordinates
     last_valid_x = raw_x;
@@ -338,9 +683,180 @@ bool XPT2046_Read(int16_t *x, int16_t *y)
     *x = raw_x;
     *y = raw_y;
 
+    STATS_COUNT(accepted);
+    STATS_TIME(process_cycles, start);
+#ifdef XPT2046_USE_STATS
+    stats.last_point = burst_start;
+#endif
+
+    return true;
+}
+
+#ifdef XPT2046_USE_EVENTS
+/**
+ * @brief Queue an event (producer side)
+ * @return false if the queue is full
+ */
+static bool XPT2046_PushEvent(uint8_t type, int16_t x, int16_t y)
+{
+    uint8_t head = event_head;
+
+    if ((uint8_t)(head - event_tail) >= XPT2046_EVENT_QUEUE_SIZE) return false;
+
+    XPT2046_Event *event = &event_queue[head & (XPT2046_EVENT_QUEUE_SIZE - 1)];
+    event->type = type;
+    event->x = x;
+    event->y = y;
+    event->time = HAL_GetTick();
+
+    // Event must be complete before the consumer can see it
+    __DMB();
+    event_head = head + 1;
+
+    pen_x = x;
+    pen_y = y;
     return true;
 }
 
+/**
+ * @brief Pen went down: start sampling
+ */
+static void XPT2046_PenDown(void)
+{
+    pen_down_cycles = STATS_NOW();
+
+    XPT2046_ResetFilter();
+    pen_reported = false;
+    pen_misses = 0;
+    pen_state = PEN_DOWN;
+
+#ifdef XPT2046_TIM
+    __HAL_TIM_SET_COUNTER(&XPT2046_TIM, 0);
+    HAL_TIM_Base_Start_IT(&XPT2046_TIM);
+#endif
+}
+
+/**
+ * @brief Touch over: stop sampling and wait for PENIRQ again
+ */
+static void XPT2046_PenIdle(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+#ifdef XPT2046_TIM
+    HAL_TIM_Base_Stop_IT(&XPT2046_TIM);
+#endif
+
+    // Conversions toggle PENIRQ: drop edges latched while sampling
+    __HAL_GPIO_EXTI_CLEAR_IT(XPT2046_IRQ_PIN);
+    pen_state = PEN_IDLE;
+
+    // Touched again while the pen-up was pending: that edge is gone
+    if (IS_IRQ_LOW()) XPT2046_PenDown();
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief One sampler step: queue down/move, or up once the pen has lifted
+ */
+static void XPT2046_Sample(void)
+{
+    if (pen_state == PEN_DOWN)
+    {
+        XPT2046_Burst burst;
+        int16_t x, y;
+
+        if (XPT2046_ReadBurst(&burst))
+        {
+            pen_misses = 0;
+
+            // A full queue drops moves; a lost pen-down is retried next sample
+            if (XPT2046_Process(&burst, &x, &y) &&
+                XPT2046_PushEvent(pen_reported ? XPT2046_EVENT_MOVE : XPT2046_EVENT_DOWN, x, y))
+            {
+                if (!pen_reported) STATS_TIME(down_cycles, pen_down_cycles);
+                pen_reported = true;
+            }
+            return;
+        }
+
+        if (++pen_misses < XPT2046_RELEASE_SAMPLES) return;
+
+        pen_state = PEN_RELEASING;
+    }
+
+    if (pen_state == PEN_RELEASING)
+    {
+        // Keep trying until the pen-up fits in the queue
+        if (pen_reported && !XPT2046_PushEvent(XPT2046_EVENT_UP, pen_x, pen_y)) return;
+
+        XPT2046_PenIdle();
+    }
+}
+
+#ifdef XPT2046_USE_SPI_BUS
+/**
+ * @brief Bus granted to a tick's sample (may run after the tick returned)
+ */
+static void XPT2046_BusGranted(SPI_BusDevice *dev)
+{
+    XPT2046_Sample();
+
+    // No burst is sent once the pen has lifted: give the bus back here
+    SPI_BusRelease(dev);
+    pen_sampling = false;
+}
+#endif
+#endif
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Initialize XPT2046
+ */
+void XPT2046_Init(void)
+{
+    XPT2046_ResetFilter();
+
+    if (cal_range.active) XPT2046_RangeMatrix();
+
+    // CS pin should be initialized in CubeMX
+    CS_HIGH();
+
+    // Small delay for chip to stabilize
+    HAL_Delay(10);
+
+#ifdef XPT2046_USE_EVENTS
+    event_head = 0;
+    event_tail = 0;
+    pen_sampling = false;
+    pen_due = false;
+
+    // Also picks up a touch already present (no edge will come)
+    XPT2046_PenIdle();
+#endif
+}
+
+/**
+ * @brief Read calibrated touch coordinates
+ */
+bool XPT2046_Read(int16_t *x, int16_t *y)
+{
+    XPT2046_Burst burst;
+
+	// Check if touch is pressed (one burst also holds all samples)
+    if (!XPT2046_ReadBurst(&burst))
+    {
+    	// Reset state when not touched
+        XPT2046_ResetFilter();
+        return false;
+    }
+
+    return XPT2046_Process(&burst, x, y);
+}
+
 /**
  * @brief Check if touch is pressed
  */
@@ -354,37 +870,253 @@ bool XPT2046_IsTouched(void)
  */
 bool XPT2046_ReadRaw(int16_t *x, int16_t *y)
 {
-    if (!XPT2046_IsPressed())
+    XPT2046_Burst burst;
+
+    if (!XPT2046_ReadBurst(&burst))
     {
         return false;
     }
 
-    // Read values multiple times
-    int16_t raw_x = 0;
-    int16_t raw_y = 0;
+    *x = XPT2046_Median(burst.x);
+    *y = XPT2046_Median(burst.y);
+
+    return true;
+}
 
-    for (uint8_t i = 0; i < 3; i++)
+#ifdef XPT2046_USE_EVENTS
+/**
+ * @brief Take the oldest queued event
+ */
+bool XPT2046_PollEvent(XPT2046_Event *event)
+{
+    if (pen_due)
     {
-        raw_x += XPT2046_SendCommand(CMD_X_READ) >> 3;
-        raw_y += XPT2046_SendCommand(CMD_Y_READ) >> 3;
+        pen_due = false;
+        XPT2046_Sample();
     }
 
-    *x = raw_x / 3;
-    *y = raw_y / 3;
+    uint8_t tail = event_tail;
+
+    if (tail == event_head) return false;
+
+    __DMB();
+    *event = event_queue[tail & (XPT2046_EVENT_QUEUE_SIZE - 1)];
+
+    // Slot must be copied before the producer may reuse it
+    __DMB();
+    event_tail = tail + 1;
 
     return true;
 }
 
+/**
+ * @brief Periodic sample tick
+ */
+void XPT2046_Tick(void)
+{
+    if (pen_state == PEN_IDLE || pen_sampling) return;
+
+#ifdef XPT2046_USE_SPI_BUS
+    // Sample as soon as the display yields the bus
+    if (bus_dev.bus != NULL)
+    {
+        pen_sampling = true;
+        SPI_BusRequest(&bus_dev);
+        return;
+    }
+#endif
+
+    // A polled display transfer may own the SPI right now: leave the
+    // burst to XPT2046_PollEvent() in thread context
+    pen_due = true;
+}
+
+/**
+ * @brief PENIRQ falling edge
+ */
+void XPT2046_EXTI_Callback(uint16_t pin)
+{
+    if (pin != XPT2046_IRQ_PIN || pen_state != PEN_IDLE) return;
+
+    XPT2046_PenDown();
+}
+
+#ifndef XPT2046_USER_EXTI_CALLBACK
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    XPT2046_EXTI_Callback(GPIO_Pin);
+}
+#endif
+
+#ifdef XPT2046_TIM
+/**
+ * @brief Sample timer elapsed
+ */
+void XPT2046_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim == &XPT2046_TIM) XPT2046_Tick();
+}
+
+#ifndef XPT2046_USER_TIM_CALLBACK
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    XPT2046_TIM_PeriodElapsedCallback(htim);
+}
+#endif
+#endif
+#endif
+
 /**
  * @brief Update calibration values
  */
 void XPT2046_Calibrate(int16_t x_min, int16_t y_min, int16_t x_max, int16_t y_max)
 {
-    calibration.x_min = x_min;
-    calibration.y_min = y_min;
-    calibration.x_max = x_max;
-    calibration.y_max = y_max;
+    cal_range.x_min = x_min;
+    cal_range.y_min = y_min;
+    cal_range.x_max = x_max;
+    cal_range.y_max = y_max;
+    cal_range.active = true;
+
+    XPT2046_RangeMatrix();
+}
+
+/**
+ * @brief Least-squares calibration fit
+ * Solves each screen axis as a plane over the raw points. Centering the
+ * sums (scaled by count^2 to stay integer) splits off the offset and
+ * leaves a 2x2 system.
+ */
+bool XPT2046_SolveCalibration(const XPT2046_CalPoint *points, uint8_t count,
+                              XPT2046_CalMatrix *matrix)
+{
+    if (count < 3 || count > CAL_MAX_POINTS) return false;
+
+    int64_t su = 0, sv = 0, suu = 0, svv = 0, suv = 0;
+    int64_t sx = 0, sy = 0, sux = 0, svx = 0, suy = 0, svy = 0;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        int64_t u = points[i].raw_x;
+        int64_t v = points[i].raw_y;
+        int64_t x = points[i].screen_x;
+        int64_t y = points[i].screen_y;
+
+        su += u;
+        sv += v;
+        suu += u * u;
+        svv += v * v;
+        suv += u * v;
+        sx += x;
+        sy += y;
+        sux += u * x;
+        svx += v * x;
+        suy += u * y;
+        svy += v * y;
+    }
+
+    int64_t n = count;
+    int64_t cuu = n * suu - su * su;
+    int64_t cvv = n * svv - sv * sv;
+    int64_t cuv = n * suv - su * sv;
+    int64_t cux = n * sux - su * sx;
+    int64_t cvx = n * svx - sv * sx;
+    int64_t cuy = n * suy - su * sy;
+    int64_t cvy = n * svy - sv * sy;
+
+    // Zero when the points lie on one line
+    int64_t det = cuu * cvv - cuv * cuv;
+    if (det <= 0) return false;
+
+    matrix->a = XPT2046_Q16Div(cux * cvv - cvx * cuv, det);
+    matrix->b = XPT2046_Q16Div(cvx * cuu - cux * cuv, det);
+    matrix->d = XPT2046_Q16Div(cuy * cvv - cvy * cuv, det);
+    matrix->e = XPT2046_Q16Div(cvy * cuu - cuy * cuv, det);
+    matrix->c = (int32_t)((sx * 65536 - matrix->a * su - matrix->b * sv) / n);
+    matrix->f = (int32_t)((sy * 65536 - matrix->d * su - matrix->e * sv) / n);
+
+    return true;
+}
+
+/**
+ * @brief Use a calibration matrix
+ */
+void XPT2046_SetCalibration(const XPT2046_CalMatrix *matrix)
+{
+    calibration = *matrix;
+    cal_range.active = false;
+}
+
+/**
+ * @brief Get the calibration matrix
+ */
+void XPT2046_GetCalibration(XPT2046_CalMatrix *matrix)
+{
+    *matrix = calibration;
+}
+
+#ifdef XPT2046_CAL_FLASH_ADDR
+/**
+ * @brief Store the calibration in flash
+ */
+bool XPT2046_SaveCalibration(void)
+{
+    XPT2046_CalRecord record;
+    record.magic = CAL_MAGIC;
+    record.width = screen_width;
+    record.height = screen_height;
+    record.matrix = calibration;
+    record.check = XPT2046_CalCheck(&record);
+
+    FLASH_EraseInitTypeDef erase = {0};
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = XPT2046_CAL_FLASH_ADDR;
+    erase.NbPages = 1;
+
+    uint32_t page_error;
+    const uint32_t *words = (const uint32_t *)&record;
+
+    HAL_FLASH_Unlock();
+
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &page_error);
+
+    for (uint8_t i = 0; status == HAL_OK && i < sizeof(record) / 4; i++)
+    {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, XPT2046_CAL_FLASH_ADDR + i * 4, words[i]);
+    }
+
+    HAL_FLASH_Lock();
+
+    return status == HAL_OK && memcmp((const void *)XPT2046_CAL_FLASH_ADDR, &record, sizeof(record)) == 0;
+}
+
+/**
+ * @brief Load the stored calibration
+ */
+bool XPT2046_LoadCalibration(void)
+{
+    const XPT2046_CalRecord *record = (const XPT2046_CalRecord *)XPT2046_CAL_FLASH_ADDR;
+
+    if (record->magic != CAL_MAGIC || record->check != XPT2046_CalCheck(record)) return false;
+    if (record->width != screen_width || record->height != screen_height) return false;
+
+    XPT2046_SetCalibration(&record->matrix);
+    return true;
+}
+#endif
+
+#ifdef XPT2046_USE_SPI_BUS
+/**
+ * @brief Share the SPI through an arbiter
+ */
+void XPT2046_AttachBus(SPI_Bus *bus, uint32_t prescaler)
+{
+#ifdef XPT2046_USE_EVENTS
+    SPI_BusAddDevice(&bus_dev, bus, prescaler, XPT2046_BusGranted, NULL);
+#else
+    SPI_BusAddDevice(&bus_dev, bus, prescaler, NULL, NULL);
+#endif
 }
+#endif
 
 /**
  * @brief Set screen dimensions
@@ -393,8 +1125,44 @@ void XPT2046_SetScreenSize(uint16_t width, uint16_t height)
 {
     screen_width = width;
     screen_height = height;
+
+    if (cal_range.active) XPT2046_RangeMatrix();
+}
+
+#ifdef XPT2046_USE_STATS
+/**
+ * @brief Copy the statistics
+ */
+void XPT2046_GetStats(XPT2046_Stats *out)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *out = stats;
+
+    __set_PRIMASK(primask);
 }
 
+/**
+ * @brief Clear the statistics
+ */
+void XPT2046_ResetStats(void)
+{
+    PERF_Init();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memset(&stats, 0, sizeof(stats));
+    PERF_StatReset(&stats.burst_cycles);
+    PERF_StatReset(&stats.bus_wait_cycles);
+    PERF_StatReset(&stats.process_cycles);
+    PERF_StatReset(&stats.down_cycles);
+
+    __set_PRIMASK(primask);
+}
+#endif
+
 void XPT2046_Test(void)
 {
     char buffer[50];
@@ -502,6 +1270,7 @@ void XPT2046_HardwareTest(void)
     ST7789_WriteString(10, y_pos, "Test 2: Read X", Font_7x10, ST7789_CYAN, ST7789_BLACK);
     y_pos += 15;
 
+    XPT2046_BusAcquire();
     int32_t x_sum = 0;
     for (uint8_t i = 0; i < 5; i++)
     {
@@ -521,6 +1290,7 @@ void XPT2046_HardwareTest(void)
         int16_t x_raw = ((rx[0] << 8) | rx[1]) >> 3;
         x_sum += x_raw;
     }
+    XPT2046_BusRelease();
 
     int16_t x_avg = x_sum / 5;
     snprintf(buffer, sizeof(buffer), "X avg: %d (0x%03X)", x_avg, x_avg);
@@ -532,6 +1302,7 @@ void XPT2046_HardwareTest(void)
     ST7789_WriteString(10, y_pos, "Test 3: Read Y", Font_7x10, ST7789_CYAN, ST7789_BLACK);
     y_pos += 15;
 
+    XPT2046_BusAcquire();
     int32_t y_sum = 0;
     for (uint8_t i = 0; i < 5; i++)
     {
@@ -551,6 +1322,7 @@ void XPT2046_HardwareTest(void)
         int16_t y_raw = ((rx[0] << 8) | rx[1]) >> 3;
         y_sum += y_raw;
     }
+    XPT2046_BusRelease();
 
     int16_t y_avg = y_sum / 5;
     snprintf(buffer, sizeof(buffer), "Y avg: %d (0x%03X)", y_avg, y_avg);
@@ -563,6 +1335,7 @@ void XPT2046_HardwareTest(void)
     y_pos += 15;
 
     // Z1
+    XPT2046_BusAcquire();
     CS_LOW();
     HAL_Delay(1);
     uint8_t cmd_z1 = CMD_Z1_READ;
@@ -584,6 +1357,7 @@ void XPT2046_HardwareTest(void)
     HAL_Delay(1);
     HAL_SPI_Receive(&XPT2046_SPI_PORT, rx_z2, 2, 100);
     CS_HIGH();
+    XPT2046_BusRelease();
     HAL_Delay(2);
 
     int16_t z2 = ((rx_z2[0] << 8) | rx_z2[1]) >> 3;
@@ -653,6 +1427,7 @@ void XPT2046_LiveTest(void)
         ST7789_FillRect(0, 70, ST7789_WIDTH, 140, ST7789_BLACK);
 
         // Read X with proper timing
+        XPT2046_BusAcquire();
         CS_LOW();
         HAL_Delay(1);
         uint8_t cmd = CMD_X_READ;
@@ -694,6 +1469,7 @@ void XPT2046_LiveTest(void)
         HAL_Delay(1);
         HAL_SPI_Receive(&XPT2046_SPI_PORT, rx, 2, 100);
         CS_HIGH();
+        XPT2046_BusRelease();
         HAL_Delay(1);
         int16_t z2 = ((rx[0] << 8) | rx[1]) >> 3;
 
@@ -843,62 +1619,69 @@ void XPT2046_Calibration(void)
         }
     }
 
-    // Calculate calibration values
-    int16_t x_min = 4095, x_max = 0;
-    int16_t y_min = 4095, y_max = 0;
+    // Fit the calibration matrix
+    XPT2046_CalPoint fit[5];
+    XPT2046_CalMatrix matrix;
 
-    // Check all 4 corners only
-    for (uint8_t i = 0; i < 4; i++)
+    for (uint8_t i = 0; i < 5; i++)
     {
-        if (points[i].raw_x < x_min) x_min = points[i].raw_x;
-        if (points[i].raw_x > x_max) x_max = points[i].raw_x;
-        if (points[i].raw_y < y_min) y_min = points[i].raw_y;
-        if (points[i].raw_y > y_max) y_max = points[i].raw_y;
+        fit[i].screen_x = points[i].screen_x;
+        fit[i].screen_y = points[i].screen_y;
+        fit[i].raw_x = points[i].raw_x;
+        fit[i].raw_y = points[i].raw_y;
     }
 
-    // Display results
     ST7789_FillScreen(ST7789_BLACK);
     ST7789_WriteString(10, 10, "Calibration Results", Font_11x18, ST7789_YELLOW, ST7789_BLACK);
 
-    uint16_t y_pos = 40;
-
-    snprintf(buffer, sizeof(buffer), "X_MIN: %d", x_min);
-    ST7789_WriteString(10, y_pos, buffer, Font_11x18, ST7789_GREEN, ST7789_BLACK);
-    y_pos += 25;
-
-    snprintf(buffer, sizeof(buffer), "X_MAX: %d", x_max);
-    ST7789_WriteString(10, y_pos, buffer, Font_11x18, ST7789_GREEN, ST7789_BLACK);
-    y_pos += 25;
+    if (!XPT2046_SolveCalibration(fit, 5, &matrix))
+    {
+        ST7789_WriteString(10, 40, "Points on a line,", Font_11x18, ST7789_RED, ST7789_BLACK);
+        ST7789_WriteString(10, 65, "calibration kept", Font_11x18, ST7789_RED, ST7789_BLACK);
+        HAL_Delay(3000);
+        return;
+    }
 
-    snprintf(buffer, sizeof(buffer), "Y_MIN: %d", y_min);
-    ST7789_WriteString(10, y_pos, buffer, Font_11x18, ST7789_GREEN, ST7789_BLACK);
-    y_pos += 25;
+    // Apply calibration immediately for testing
+    XPT2046_SetCalibration(&matrix);
 
-    snprintf(buffer, sizeof(buffer), "Y_MAX: %d", y_max);
-    ST7789_WriteString(10, y_pos, buffer, Font_11x18, ST7789_GREEN, ST7789_BLACK);
-    y_pos += 35;
+    // Display results
+    uint16_t y_pos = 40;
 
-    // Show configuration to update in xpt2046.h
-    ST7789_WriteString(10, y_pos, "Update xpt2046.h:", Font_7x10, ST7789_CYAN, ST7789_BLACK);
+    snprintf(buffer, sizeof(buffer), "X: %ld %ld %ld", (long)matrix.a, (long)matrix.b, (long)matrix.c);
+    ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_GREEN, ST7789_BLACK);
     y_pos += 15;
 
-    snprintf(buffer, sizeof(buffer), "#define XPT2046_X_MIN %d", x_min);
-    ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
-    y_pos += 12;
-
-    snprintf(buffer, sizeof(buffer), "#define XPT2046_X_MAX %d", x_max);
-    ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
-    y_pos += 12;
-
-    snprintf(buffer, sizeof(buffer), "#define XPT2046_Y_MIN %d", y_min);
-    ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
-    y_pos += 12;
+    snprintf(buffer, sizeof(buffer), "Y: %ld %ld %ld", (long)matrix.d, (long)matrix.e, (long)matrix.f);
+    ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_GREEN, ST7789_BLACK);
+    y_pos += 25;
 
-    snprintf(buffer, sizeof(buffer), "#define XPT2046_Y_MAX %d", y_max);
-    ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
+    // Residual at each target
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        int16_t x = fit[i].raw_x;
+        int16_t y = fit[i].raw_y;
+        XPT2046_ApplyCalibration(&x, &y);
+
+        snprintf(buffer, sizeof(buffer), "%d: %d,%d -> %d,%d", i + 1,
+                 fit[i].screen_x, fit[i].screen_y, x, y);
+        ST7789_WriteString(10, y_pos, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
+        y_pos += 12;
+    }
+    y_pos += 10;
 
-    // Apply calibration immediately for testing
-    XPT2046_Calibrate(x_min, y_min, x_max, y_max);
+#ifdef XPT2046_CAL_FLASH_ADDR
+    if (XPT2046_SaveCalibration())
+    {
+        ST7789_WriteString(10, y_pos, "Saved to flash", Font_7x10, ST7789_CYAN, ST7789_BLACK);
+    }
+    else
+    {
+        ST7789_WriteString(10, y_pos, "Flash write failed", Font_7x10, ST7789_RED, ST7789_BLACK);
+    }
+#else
+    ST7789_WriteString(10, y_pos, "Not saved (XPT2046_CAL_FLASH_ADDR)", Font_7x10, ST7789_CYAN, ST7789_BLACK);
+#endif
 
     HAL_Delay(5000);
 
@@ -957,3 +1740,109 @@ void XPT2046_RawDiagnostic(void) {
         HAL_Delay(50);
     }
 }
+
+#ifdef XPT2046_USE_STATS
+/**
+ * @brief Show one timing statistic as mean / max microseconds
+ */
+static void XPT2046_ShowStat(uint16_t y, const char *label, const PERF_Stat *stat)
+{
+    char buffer[48];
+
+    if (stat->count == 0)
+    {
+        snprintf(buffer, sizeof(buffer), "%-8s   -", label);
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), "%-8s %5lu /%6lu us", label,
+                 (unsigned long)PERF_CyclesToUs(PERF_StatMean(stat)),
+                 (unsigned long)PERF_CyclesToUs(stat->max));
+    }
+
+    ST7789_WriteString(10, y, buffer, Font_7x10, ST7789_WHITE, ST7789_BLACK);
+}
+
+/**
+ * @brief Touch benchmark: draw under the finger with live timing
+ */
+void XPT2046_Benchmark(void)
+{
+    char buffer[48];
+    XPT2046_Stats snap;
+    PERF_Stat pixel;
+    uint32_t last_update = HAL_GetTick();
+    uint32_t last_accepted = 0;
+
+    XPT2046_ResetStats();
+    PERF_StatReset(&pixel);
+
+    ST7789_FillScreen(ST7789_BLACK);
+    ST7789_WriteString(10, 10, "Touch Benchmark", Font_11x18, ST7789_YELLOW, ST7789_BLACK);
+    ST7789_WriteString(10, 32, "Draw under finger", Font_7x10, ST7789_CYAN, ST7789_BLACK);
+    snprintf(buffer, sizeof(buffer), "Samples %d  Avg %d  Jump %d",
+             XPT2046_READ_SAMPLES, XPT2046_AVG_SAMPLES, XPT2046_JUMP_THRESHOLD);
+    ST7789_WriteString(10, 44, buffer, Font_7x10, ST7789_GRAY, ST7789_BLACK);
+
+    while (1)
+    {
+        int16_t x = 0, y = 0;
+        bool point;
+
+#ifdef XPT2046_USE_EVENTS
+        // Draw only the newest point (the one last_point belongs to)
+        XPT2046_Event event;
+        point = false;
+
+        while (XPT2046_PollEvent(&event))
+        {
+            point = (event.type != XPT2046_EVENT_UP);
+            x = event.x;
+            y = event.y;
+        }
+#else
+        point = XPT2046_Read(&x, &y);
+#endif
+
+        if (point && y > 130)
+        {
+            ST7789_FillRect(x - 1, y - 1, 3, 3, ST7789_GREEN);
+#ifdef ST7789_USE_FRAMEBUFFER
+            ST7789_Flush();
+#endif
+            ST7789_WaitIdle();
+
+            XPT2046_GetStats(&snap);
+            PERF_StatAdd(&pixel, PERF_Cycles() - snap.last_point);
+        }
+
+        uint32_t now = HAL_GetTick();
+        if (now - last_update < 500) continue;
+
+        XPT2046_GetStats(&snap);
+
+        uint32_t rate = (snap.accepted - last_accepted) * 1000 / (now - last_update);
+        uint32_t seen = snap.accepted + snap.rejected_noise + snap.rejected_jump;
+        last_accepted = snap.accepted;
+        last_update = now;
+
+        ST7789_FillRect(0, 58, ST7789_WIDTH, 82, ST7789_BLACK);
+
+        snprintf(buffer, sizeof(buffer), "Rate %lu/s  Points %lu",
+                 (unsigned long)rate, (unsigned long)snap.accepted);
+        ST7789_WriteString(10, 60, buffer, Font_7x10, ST7789_GREEN, ST7789_BLACK);
+
+        snprintf(buffer, sizeof(buffer), "Noise %lu%%  Jump %lu%%  Reset %lu",
+                 (unsigned long)(seen ? snap.rejected_noise * 100 / seen : 0),
+                 (unsigned long)(seen ? snap.rejected_jump * 100 / seen : 0),
+                 (unsigned long)snap.resets);
+        ST7789_WriteString(10, 72, buffer, Font_7x10, ST7789_GREEN, ST7789_BLACK);
+
+        XPT2046_ShowStat(84, "Burst", &snap.burst_cycles);
+        XPT2046_ShowStat(96, "BusWait", &snap.bus_wait_cycles);
+        XPT2046_ShowStat(108, "Filter", &snap.process_cycles);
+        XPT2046_ShowStat(120, "PenDown", &snap.down_cycles);
+        XPT2046_ShowStat(132, "Pixel", &pixel);
+    }
+}
+#endif
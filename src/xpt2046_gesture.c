@@ -0,0 +1,264 @@
+/**
+ * @file xpt2046_gesture.c
+ */
+
+/* ============== INCLUDES ===================== */
+
+#include "xpt2046_gesture.h"
+#include <stddef.h>
+
+/* ============== PRIVATE VARIABLES ============== */
+
+// Gesture ring (producer and consumer both run in the main loop)
+static XPT2046_Gesture gesture_queue[XPT2046_GESTURE_QUEUE_SIZE];
+static uint8_t gesture_head = 0;    // Next free slot
+static uint8_t gesture_tail = 0;    // Oldest gesture
+
+// Pen being tracked
+static struct {
+    bool down;
+    bool moved;             // Left the tap slop circle
+    bool long_sent;         // Long press already reported
+    uint8_t misses;         // Consecutive failed reads (polling)
+    int16_t start_x;        // Pen-down point
+    int16_t start_y;
+    uint32_t start_time;
+    int16_t x;              // Last point
+    int16_t y;
+    uint32_t time;
+} pen;
+
+/* ============== PRIVATE FUNCTIONS ============== */
+
+/**
+ * @brief Queue a gesture, merging moves while the consumer is behind
+ */
+static void XPT2046_GesturePush(uint8_t type, int16_t x, int16_t y, uint32_t time)
+{
+    uint8_t count = gesture_head - gesture_tail;
+    XPT2046_Gesture *gesture;
+
+    if (type == XPT2046_GESTURE_MOVE && count >= XPT2046_GESTURE_QUEUE_SIZE / 2)
+    {
+        // Keep the second half free for downs, ups and recognized gestures
+        gesture = &gesture_queue[(uint8_t)(gesture_head - 1) & (XPT2046_GESTURE_QUEUE_SIZE - 1)];
+
+        if (gesture->type != XPT2046_GESTURE_MOVE)
+        {
+            gesture = NULL;
+        }
+    }
+    else
+    {
+        gesture = NULL;
+    }
+
+    if (gesture == NULL)
+    {
+        if (count >= XPT2046_GESTURE_QUEUE_SIZE) return;
+
+        gesture = &gesture_queue[gesture_head & (XPT2046_GESTURE_QUEUE_SIZE - 1)];
+        gesture_head++;
+    }
+
+    gesture->type = type;
+    gesture->x = x;
+    gesture->y = y;
+    gesture->dx = x - pen.start_x;
+    gesture->dy = y - pen.start_y;
+    gesture->time = time;
+    gesture->duration = time - pen.start_time;
+}
+
+/**
+ * @brief Pen-down at a point
+ */
+static void XPT2046_GestureDown(int16_t x, int16_t y, uint32_t time)
+{
+    pen.down = true;
+    pen.moved = false;
+    pen.long_sent = false;
+    pen.misses = 0;
+    pen.start_x = x;
+    pen.start_y = y;
+    pen.start_time = time;
+    pen.x = x;
+    pen.y = y;
+    pen.time = time;
+
+    XPT2046_GesturePush(XPT2046_GESTURE_DOWN, x, y, time);
+}
+
+/**
+ * @brief New point while down, filling gaps with interpolated moves
+ */
+static void XPT2046_GestureMove(int16_t x, int16_t y, uint32_t time)
+{
+    int32_t dx = x - pen.x;
+    int32_t dy = y - pen.y;
+
+    if (dx == 0 && dy == 0)
+    {
+        pen.time = time;
+        return;
+    }
+
+    int32_t span = (dx < 0) ? -dx : dx;
+    int32_t span_y = (dy < 0) ? -dy : dy;
+    if (span_y > span) span = span_y;
+
+    int32_t steps = (span + XPT2046_GESTURE_STEP - 1) / XPT2046_GESTURE_STEP;
+    int32_t period = time - pen.time;
+
+    for (int32_t i = 1; i <= steps; i++)
+    {
+        XPT2046_GesturePush(XPT2046_GESTURE_MOVE,
+                            pen.x + dx * i / steps,
+                            pen.y + dy * i / steps,
+                            pen.time + period * i / steps);
+    }
+
+    pen.x = x;
+    pen.y = y;
+    pen.time = time;
+
+    if (!pen.moved)
+    {
+        int32_t sx = x - pen.start_x;
+        int32_t sy = y - pen.start_y;
+
+        pen.moved = (sx * sx + sy * sy > XPT2046_GESTURE_SLOP * XPT2046_GESTURE_SLOP);
+    }
+}
+
+/**
+ * @brief Pen-up: report it, then classify the stroke
+ */
+static void XPT2046_GestureUp(uint32_t time)
+{
+    pen.down = false;
+
+    XPT2046_GesturePush(XPT2046_GESTURE_UP, pen.x, pen.y, time);
+
+    uint32_t duration = time - pen.start_time;
+    int32_t dx = pen.x - pen.start_x;
+    int32_t dy = pen.y - pen.start_y;
+    int32_t adx = (dx < 0) ? -dx : dx;
+    int32_t ady = (dy < 0) ? -dy : dy;
+
+    if (!pen.moved)
+    {
+        if (!pen.long_sent && duration <= XPT2046_GESTURE_TAP_MS)
+        {
+            XPT2046_GesturePush(XPT2046_GESTURE_TAP, pen.x, pen.y, time);
+        }
+    }
+    else if (duration <= XPT2046_GESTURE_SWIPE_MS &&
+             (adx >= XPT2046_GESTURE_SWIPE_MIN || ady >= XPT2046_GESTURE_SWIPE_MIN))
+    {
+        uint8_t type;
+
+        if (adx >= ady)
+        {
+            type = (dx < 0) ? XPT2046_GESTURE_SWIPE_LEFT : XPT2046_GESTURE_SWIPE_RIGHT;
+        }
+        else
+        {
+            type = (dy < 0) ? XPT2046_GESTURE_SWIPE_UP : XPT2046_GESTURE_SWIPE_DOWN;
+        }
+
+        XPT2046_GesturePush(type, pen.x, pen.y, time);
+    }
+}
+
+/* ============== PUBLIC FUNCTIONS ============== */
+
+/**
+ * @brief Reset the gesture engine
+ */
+void XPT2046_GestureInit(void)
+{
+    gesture_head = 0;
+    gesture_tail = 0;
+    pen.down = false;
+}
+
+/**
+ * @brief Pull touch input and run the recognizers
+ */
+void XPT2046_GestureUpdate(void)
+{
+#ifdef XPT2046_USE_EVENTS
+    XPT2046_Event event;
+
+    while (XPT2046_PollEvent(&event))
+    {
+        switch (event.type)
+        {
+            case XPT2046_EVENT_DOWN:
+                XPT2046_GestureDown(event.x, event.y, event.time);
+                break;
+
+            case XPT2046_EVENT_MOVE:
+                if (pen.down) XPT2046_GestureMove(event.x, event.y, event.time);
+                break;
+
+            case XPT2046_EVENT_UP:
+                if (pen.down)
+                {
+                    XPT2046_GestureMove(event.x, event.y, event.time);
+                    XPT2046_GestureUp(event.time);
+                }
+                break;
+        }
+    }
+#else
+    int16_t x, y;
+
+    if (XPT2046_Read(&x, &y))
+    {
+        uint32_t now = HAL_GetTick();
+
+        pen.misses = 0;
+
+        if (!pen.down)
+        {
+            XPT2046_GestureDown(x, y, now);
+        }
+        else
+        {
+            XPT2046_GestureMove(x, y, now);
+        }
+    }
+    else if (pen.down && ++pen.misses >= XPT2046_GESTURE_RELEASE)
+    {
+        // Released at the last good read, not when the misses ran out
+        XPT2046_GestureUp(pen.time);
+    }
+#endif
+
+    // Long press fires while still held
+    if (pen.down && !pen.moved && !pen.long_sent)
+    {
+        uint32_t now = HAL_GetTick();
+
+        if (now - pen.start_time >= XPT2046_GESTURE_LONG_MS)
+        {
+            pen.long_sent = true;
+            XPT2046_GesturePush(XPT2046_GESTURE_LONG_PRESS, pen.x, pen.y, now);
+        }
+    }
+}
+
+/**
+ * @brief Take the oldest gesture
+ */
+bool XPT2046_GesturePoll(XPT2046_Gesture *gesture)
+{
+    if (gesture_tail == gesture_head) return false;
+
+    *gesture = gesture_queue[gesture_tail & (XPT2046_GESTURE_QUEUE_SIZE - 1)];
+    gesture_tail++;
+
+    return true;
+}
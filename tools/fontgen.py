@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Generate a PropFontDef table (see inc/fonts.h) from a TrueType/OpenType font.
+
+    python3 tools/fontgen.py DejaVuSans.ttf 32 Font_Sans32 --bpp 4 > src/font_sans32.c
+
+Then declare it where it is used:
+
+    extern const PropFontDef Font_Sans32;
+
+Glyphs are rendered with Pillow, cropped to their ink inside the advance x
+line-height cell, quantized to 1/2/4 bits of alpha and run-length coded.
+Ink that falls outside the cell (negative bearings) is clipped.
+"""
+
+import argparse
+import sys
+
+from PIL import Image, ImageDraw, ImageFont
+
+
+def rle_encode(levels, bpp):
+    """Encode alpha levels as (level << (8 - bpp)) | (run - 1) tokens."""
+    max_run = 1 << (8 - bpp)
+    out = []
+    i = 0
+    while i < len(levels):
+        level = levels[i]
+        run = 1
+        while i + run < len(levels) and levels[i + run] == level and run < max_run:
+            run += 1
+        out.append((level << (8 - bpp)) | (run - 1))
+        i += run
+    return out
+
+
+def render_glyph(font, ch, height, bpp):
+    """Return (advance, x_offset, y_offset, width, height, levels) for ch."""
+    advance = int(round(font.getlength(ch)))
+    if advance == 0:
+        return 0, 0, 0, 0, 0, []
+
+    cell = Image.new("L", (advance, height), 0)
+    ImageDraw.Draw(cell).text((0, 0), ch, font=font, fill=255)
+
+    bbox = cell.getbbox()
+    if bbox is None:
+        return advance, 0, 0, 0, 0, []
+
+    left, top, right, bottom = bbox
+    max_level = (1 << bpp) - 1
+    pixels = cell.crop(bbox).getdata()
+    levels = [(p * max_level + 127) // 255 for p in pixels]
+
+    return advance, left, top, right - left, bottom - top, levels
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("font", help="TrueType/OpenType font file")
+    parser.add_argument("size", type=int, help="Pixel size")
+    parser.add_argument("name", help="C symbol, e.g. Font_Sans32")
+    parser.add_argument("--bpp", type=int, choices=(1, 2, 4), default=4,
+                        help="Alpha bits per pixel (default 4)")
+    parser.add_argument("--first", type=int, default=32, help="First character code")
+    parser.add_argument("--last", type=int, default=126, help="Last character code")
+    args = parser.parse_args()
+
+    font = ImageFont.truetype(args.font, args.size)
+    ascent, descent = font.getmetrics()
+    height = ascent + descent
+    if height > 255:
+        sys.exit("line height %d does not fit in uint8_t" % height)
+
+    data = []
+    glyphs = []
+    for code in range(args.first, args.last + 1):
+        ch = chr(code)
+        advance, x_off, y_off, w, h, levels = render_glyph(font, ch, height, args.bpp)
+        if advance > 255:
+            sys.exit("advance of %r does not fit in uint8_t" % ch)
+        glyphs.append((len(data), w, h, advance, x_off, y_off, ch))
+        data.extend(rle_encode(levels, args.bpp))
+
+    out = sys.stdout
+    out.write("/**\n * @file %s\n * Generated by tools/fontgen.py from %s at %d px, %d bpp.\n */\n\n"
+              % (args.name, args.font.split("/")[-1], args.size, args.bpp))
+    out.write('#include "fonts.h"\n\n')
+
+    out.write("static const uint8_t %s_data[] = {\n" % args.name)
+    for i in range(0, len(data), 16):
+        out.write("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",\n")
+    if not data:
+        out.write("    0x00,\n")
+    out.write("};\n\n")
+
+    out.write("static const GlyphDef %s_glyphs[] = {\n" % args.name)
+    for offset, w, h, advance, x_off, y_off, ch in glyphs:
+        label = "backslash" if ch == "\\" else ch
+        out.write("    {%5d, %3d, %3d, %3d, %3d, %3d},  // %s\n"
+                  % (offset, w, h, advance, x_off, y_off, label))
+    out.write("};\n\n")
+
+    out.write("const PropFontDef %s = {%d, %d, %d, %d, %d, %s_glyphs, %s_data};\n"
+              % (args.name, height, ascent, args.bpp, args.first, args.last,
+                 args.name, args.name))
+
+    bitmap_bytes = sum((g[1] * g[2] * args.bpp + 7) // 8 for g in glyphs)
+    sys.stderr.write("%s: %d glyphs, %d bytes RLE (%d bytes packed bitmap)\n"
+                     % (args.name, len(glyphs), len(data) + len(glyphs) * 12, bitmap_bytes))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""
+Generate an ST7789_Image (see inc/st7789.h) from a PNG/BMP/JPEG picture.
+
+    python3 tools/imgconv.py splash.png Img_Splash > src/img_splash.c
+
+Then declare it where it is used and draw it with ST7789_DrawCompressedImage():
+
+    extern const ST7789_Image Img_Splash;
+
+Pixels are reduced to RGB565. If the picture has few enough colors, palette
+formats (1/2/4/8 bits per pixel) are tried as well; --colors N quantizes
+photos down to N colors first. Every format is encoded both packed and
+run-length coded, and the smallest one (data + palette) wins unless --bpp
+or --rle/--no-rle pin the choice.
+"""
+
+import argparse
+import sys
+
+from PIL import Image
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def value_bytes(value, bpp):
+    """Bytes of one index (bpp 8) or color (bpp 16), high byte first."""
+    return [value >> 8, value & 0xFF] if bpp == 16 else [value]
+
+
+def rle_encode_tokens(values, bpp):
+    """Encode bpp 1/2/4 indices as (index << (8 - bpp)) | (run - 1) tokens."""
+    max_run = 1 << (8 - bpp)
+    out = []
+    i = 0
+    while i < len(values):
+        value = values[i]
+        run = 1
+        while i + run < len(values) and values[i + run] == value and run < max_run:
+            run += 1
+        out.append((value << (8 - bpp)) | (run - 1))
+        i += run
+    return out
+
+
+def rle_encode_packbits(values, bpp):
+    """Encode bpp 8/16 values as repeat (0x80 | n - 1) or literal (n - 1) tokens."""
+    out = []
+    i = 0
+    while i < len(values):
+        run = 1
+        while i + run < len(values) and values[i + run] == values[i] and run < 128:
+            run += 1
+        if run >= 2:
+            out.append(0x80 | (run - 1))
+            out.extend(value_bytes(values[i], bpp))
+            i += run
+            continue
+
+        # Literal stretch up to the next run of 2 or more
+        start = i
+        while i < len(values) and i - start < 128:
+            if i + 1 < len(values) and values[i + 1] == values[i]:
+                break
+            i += 1
+        if i == start:
+            i += 1
+        out.append(i - start - 1)
+        for value in values[start:i]:
+            out.extend(value_bytes(value, bpp))
+    return out
+
+
+def pack(values, width, bpp):
+    """Pack values MSB first, each row starting on a byte boundary."""
+    out = []
+    for row in range(0, len(values), width):
+        if bpp == 16:
+            for value in values[row:row + width]:
+                out.extend(value_bytes(value, bpp))
+            continue
+        acc = 0
+        bits = 0
+        for value in values[row:row + width]:
+            acc = (acc << bpp) | value
+            bits += bpp
+            if bits == 8:
+                out.append(acc)
+                acc = 0
+                bits = 0
+        if bits:
+            out.append(acc << (8 - bits))
+    return out
+
+
+def encode(colors, width, bpp, rle):
+    """Return (palette, data) for one format, or None if it does not fit."""
+    if bpp == 16:
+        palette = []
+        values = colors
+    else:
+        palette = sorted(set(colors))
+        if len(palette) > (1 << bpp):
+            return None
+        lookup = {c: i for i, c in enumerate(palette)}
+        values = [lookup[c] for c in colors]
+
+    if not rle:
+        data = pack(values, width, bpp)
+    elif bpp < 8:
+        data = rle_encode_tokens(values, bpp)
+    else:
+        data = rle_encode_packbits(values, bpp)
+    return palette, data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("image", help="Input picture")
+    parser.add_argument("name", help="C symbol, e.g. Img_Splash")
+    parser.add_argument("--bpp", type=int, choices=(1, 2, 4, 8, 16),
+                        help="Force bits per pixel (default: smallest)")
+    parser.add_argument("--rle", dest="rle", action="store_true", default=None,
+                        help="Force run-length coding")
+    parser.add_argument("--no-rle", dest="rle", action="store_false",
+                        help="Force packed pixels")
+    parser.add_argument("--colors", type=int,
+                        help="Quantize to this many colors first (2-256)")
+    parser.add_argument("--size", metavar="WxH", help="Resize first, e.g. 240x135")
+    args = parser.parse_args()
+
+    img = Image.open(args.image).convert("RGB")
+    if args.size:
+        w, h = (int(v) for v in args.size.lower().split("x"))
+        img = img.resize((w, h), Image.LANCZOS)
+    if args.colors:
+        if not 2 <= args.colors <= 256:
+            sys.exit("--colors must be 2-256")
+        img = img.quantize(args.colors, dither=Image.Dither.NONE).convert("RGB")
+
+    width, height = img.size
+    if width > 65535 or height > 65535:
+        sys.exit("image too large")
+    colors = [rgb565(*p) for p in img.getdata()]
+
+    candidates = []
+    for bpp in (1, 2, 4, 8, 16):
+        if args.bpp is not None and bpp != args.bpp:
+            continue
+        for rle in (False, True):
+            if args.rle is not None and rle != args.rle:
+                continue
+            result = encode(colors, width, bpp, rle)
+            if result is not None:
+                palette, data = result
+                candidates.append((len(data) + len(palette) * 2, bpp, rle, palette, data))
+    if not candidates:
+        sys.exit("%d colors do not fit in %d bpp (try --colors)"
+                 % (len(set(colors)), args.bpp))
+
+    size, bpp, rle, palette, data = min(candidates, key=lambda c: c[0])
+
+    out = sys.stdout
+    out.write("/**\n * @file %s\n * Generated by tools/imgconv.py from %s, %dx%d, %d bpp%s.\n */\n\n"
+              % (args.name, args.image.split("/")[-1], width, height, bpp,
+                 " RLE" if rle else ""))
+    out.write('#include "st7789.h"\n\n')
+
+    if palette:
+        # SPI byte order: high byte first in memory
+        out.write("static const uint16_t %s_palette[] = {\n" % args.name)
+        for i in range(0, len(palette), 8):
+            out.write("    " + ", ".join("0x%04X" % (((c & 0xFF) << 8) | (c >> 8))
+                                         for c in palette[i:i + 8]) + ",\n")
+        out.write("};\n\n")
+
+    out.write("static const uint8_t %s_data[] = {\n" % args.name)
+    for i in range(0, len(data), 16):
+        out.write("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",\n")
+    if not data:
+        out.write("    0x00,\n")
+    out.write("};\n\n")
+
+    out.write("const ST7789_Image %s = {%d, %d, %d, %s, %d, %s, %s_data};\n"
+              % (args.name, width, height, bpp, "ST7789_IMAGE_RLE" if rle else "0",
+                 len(palette), ("%s_palette" % args.name) if palette else "NULL",
+                 args.name))
+
+    sys.stderr.write("%s: %dx%d, %d colors, %d bpp%s, %d bytes (%d bytes raw RGB565)\n"
+                     % (args.name, width, height, len(set(colors)), bpp,
+                        " RLE" if rle else "", size, width * height * 2))
+
+
+if __name__ == "__main__":
+    main()
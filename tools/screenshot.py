@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Receive an ST7789_Screenshot() (see inc/st7789.h) over a serial port and save it.
+
+    python3 tools/screenshot.py /dev/ttyUSB0 shot.bmp --baud 921600
+    python3 tools/screenshot.py COM5 shot.png --trigger s
+
+The firmware streams a 16-bit RGB565 BMP one line at a time, e.g.:
+
+    static void uart_write(const uint8_t *data, uint32_t len, void *context)
+    {
+        HAL_UART_Transmit(&huart1, (uint8_t*)data, len, HAL_MAX_DELAY);
+    }
+
+    ST7789_Screenshot(uart_write, NULL);
+
+Anything sent before the file (log lines) is skipped: the tool waits for a
+BMP header. --trigger sends a string first, for firmware that takes the
+screenshot on request. USB CDC ports work the same way (baud is ignored).
+--input reads a capture file instead of a port. Saving as .png needs Pillow.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+HEADER_SIZE = 66    # BITMAPFILEHEADER + BITMAPINFOHEADER + RGB565 masks
+
+
+def parse_header(header):
+    """Return (file size, width, height) of an ST7789_Screenshot header, or None."""
+    if header[:2] != b"BM":
+        return None
+    size, offset, info = struct.unpack_from("<I4xII", header, 2)
+    width, height, planes, bpp, compression = struct.unpack_from("<iiHHI", header, 18)
+    masks = struct.unpack_from("<III", header, 54)
+    if (offset != HEADER_SIZE or info != 40 or planes != 1 or bpp != 16 or compression != 3
+            or masks != (0xF800, 0x07E0, 0x001F) or not 0 < width <= 4096
+            or not 0 < -height <= 4096):
+        return None
+    line = (width * 2 + 3) & ~3
+    if size != HEADER_SIZE + line * -height:
+        return None
+    return size, width, -height
+
+
+class Source:
+    """Byte stream from a serial port or a capture file."""
+
+    def __init__(self, args):
+        if args.input:
+            self.stream = open(args.input, "rb")
+            self.read = self.stream.read
+        else:
+            try:
+                import serial
+            except ImportError:
+                sys.exit("pyserial is needed for serial ports (pip install pyserial)")
+            self.stream = serial.Serial(args.port, args.baud, timeout=args.timeout)
+            self.read = self.stream.read
+            if args.trigger:
+                self.stream.reset_input_buffer()
+                self.stream.write(args.trigger.encode())
+
+    def read_exact(self, count):
+        data = b""
+        while len(data) < count:
+            chunk = self.read(count - len(data))
+            if not chunk:
+                sys.exit("stream ended after %d of %d bytes" % (len(data), count))
+            data += chunk
+        return data
+
+
+def receive(source):
+    """Skip to a valid header and return the whole BMP file."""
+    window = b""
+    while True:
+        byte = source.read(1)
+        if not byte:
+            sys.exit("no screenshot found")
+        window = (window + byte)[-HEADER_SIZE:]
+        if len(window) == HEADER_SIZE and window[:2] == b"BM":
+            parsed = parse_header(window)
+            if parsed is not None:
+                break
+
+    size, width, height = parsed
+    print("receiving %dx%d (%d bytes)" % (width, height, size), file=sys.stderr)
+    start = time.time()
+    data = window + source.read_exact(size - HEADER_SIZE)
+    elapsed = time.time() - start
+    if elapsed > 0:
+        print("%.1f s, %.0f bytes/s" % (elapsed, size / elapsed), file=sys.stderr)
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("port", nargs="?", help="Serial port, e.g. /dev/ttyUSB0 or COM5")
+    parser.add_argument("output", help="Output file (.bmp as received, .png needs Pillow)")
+    parser.add_argument("--baud", type=int, default=115200, help="Baud rate (default 115200)")
+    parser.add_argument("--trigger", help="String to send before waiting")
+    parser.add_argument("--timeout", type=float, default=10.0,
+                        help="Seconds without data before giving up (default 10)")
+    parser.add_argument("--input", help="Read a capture file instead of a port")
+    args = parser.parse_args()
+    if not args.port and not args.input:
+        parser.error("need a port or --input")
+
+    data = receive(Source(args))
+
+    if args.output.lower().endswith(".bmp"):
+        with open(args.output, "wb") as f:
+            f.write(data)
+    else:
+        try:
+            from PIL import Image
+        except ImportError:
+            sys.exit("Pillow is needed to convert (pip install pillow), or save as .bmp")
+        import io
+        Image.open(io.BytesIO(data)).convert("RGB").save(args.output)
+
+
+if __name__ == "__main__":
+    main()